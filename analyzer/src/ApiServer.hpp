@@ -5,8 +5,25 @@
 
 namespace ApiServer
 {
+  // Tunable settings of gcb-analyzer server
+  struct ServerOption
+  {
+    uint32_t m_ioThreadNum = 0;       // drogon io threads (0: number of hardware threads)
+    uint32_t m_computeThreadNum = 0;  // threads of /analyze_picture compute pool (0: number of hardware threads)
+    uint32_t m_maxQueuedPictureNum = 256; // picture requests on compute pool (requests beyond it are rejected)
+    uint32_t m_analysisWorkerNum = 0; // frames analyzed at the same time by all video jobs (0: number of hardware threads)
+    uint32_t m_maxRunningJobNum = 2;  // video analysis / visualization jobs run at the same time
+    uint32_t m_maxQueuedJobNum = 64;  // jobs waiting for start (requests beyond it are rejected)
+    uint32_t m_jobStatusSlotNum = 4096; // recent jobs whose statuses are kept (older access ids become invalid)
+    uint32_t m_eventPushIntervalMilliseconds = 200; // interval of progress events of /job_events
+    std::string m_localVideoRoot; // directory whose videos /analyze_local_video reads in place (empty: disabled)
+    uint32_t m_resultCacheMegabytes = 1024; // budget of cached video analysis results in ../data/cache (0: disabled)
+  };
+
   /// @brief boot gcb-analyzer server
   /// @param ip_addr_str Server's ip address (string: "0.0.0.0")
   /// @param string Port number
-  void bootServer(const std::string &ip_addr_str, const uint16_t &port_num);
+  /// @param server_option Tunable settings
+  void bootServer(const std::string &ip_addr_str, const uint16_t &port_num,
+                  const ServerOption &server_option = ServerOption());
 };
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "JobEventHub.hpp"
+
+#include <algorithm>
+
+using namespace ApiServer;
+
+static constexpr auto KEEP_ALIVE_INTERVAL = std::chrono::seconds(15); // shorter than idle timeout of connections
+
+// api returning result of finished job (index: Metrics::JobKind)
+static const std::array<std::string, static_cast<size_t>(Metrics::JobKind::JOB_KIND_NUM)> RESULT_URL_BASES{
+    "/analyzation_result/", "/visualization_result/"};
+
+/// @brief create Server-Sent Events message
+/// @param event_name Name of event
+/// @param event_json Data of event
+/// @return Message string
+static std::string create_event_message(const std::string &event_name, const nlohmann::json &event_json)
+{
+  return "event: " + event_name + "\ndata: " + event_json.dump() + "\n\n";
+}
+
+JobEventHub::JobEventHub(const JobScheduler &job_scheduler, const std::chrono::milliseconds &push_interval)
+    : m_jobScheduler(job_scheduler), m_pushInterval(push_interval), m_isPushRequested(false), m_isStopped(false)
+{
+  m_pusher = std::thread(&JobEventHub::pushEvents, this);
+}
+
+JobEventHub::~JobEventHub()
+{
+  stop();
+}
+
+void JobEventHub::pushEvents()
+{
+  std::unique_lock<std::mutex> subscriber_lock(m_mutex);
+  while (true)
+  {
+    if (m_subscriberList.empty())
+      m_pushCv.wait(subscriber_lock, [&]()
+                    { return m_isStopped || m_isPushRequested; });
+    else
+      m_pushCv.wait_for(subscriber_lock, m_pushInterval, [&]()
+                        { return m_isStopped || m_isPushRequested; });
+    if (m_isStopped)
+      return;
+    m_isPushRequested = false;
+
+    // streams are written without lock, subscribe() is not blocked by slow clients
+    auto subscriber_list = std::move(m_subscriberList);
+    m_subscriberList.clear();
+    subscriber_lock.unlock();
+
+    const auto finished_iter = std::remove_if(subscriber_list.begin(), subscriber_list.end(), [&](Subscriber &subscriber)
+                                              {
+                                                if (pushEvent(subscriber))
+                                                  return false;
+                                                subscriber.m_ptrStream->close();
+                                                return true; });
+    subscriber_list.erase(finished_iter, subscriber_list.end());
+
+    subscriber_lock.lock();
+    m_subscriberList.insert(m_subscriberList.end(),
+                            std::make_move_iterator(subscriber_list.begin()), std::make_move_iterator(subscriber_list.end()));
+  }
+}
+
+bool JobEventHub::pushEvent(Subscriber &subscriber) const
+{
+  JobStatusTable::JobStatus job_status;
+  if (!m_jobScheduler.readJobStatus(subscriber.m_jobId, job_status))
+  {
+    subscriber.m_ptrStream->send(create_event_message("failed", {{"error", "'access-id' is not valid"}}));
+    return false;
+  }
+
+  const auto now_time = std::chrono::steady_clock::now();
+  const bool is_finished = (job_status.m_state == JobState::COMPLETED || job_status.m_state == JobState::FAILED);
+  const bool is_changed = !subscriber.m_isStatusSent || job_status.m_state != subscriber.m_sentStatus.m_state ||
+                          job_status.m_frameCount != subscriber.m_sentStatus.m_frameCount;
+  if (!is_changed)
+  {
+    if (now_time - subscriber.m_sentTime < KEEP_ALIVE_INTERVAL)
+      return true;
+
+    subscriber.m_sentTime = now_time;
+    return subscriber.m_ptrStream->send(": keep-alive\n\n");
+  }
+
+  auto event_json = job_status.getJson();
+  event_json["access_id"] = subscriber.m_jobId;
+  std::string event_name = "progress";
+  if (job_status.m_state == JobState::COMPLETED)
+  {
+    event_name = "completed";
+    event_json["result_url"] = RESULT_URL_BASES[static_cast<size_t>(job_status.m_jobKind)] + std::to_string(subscriber.m_jobId);
+  }
+  else if (job_status.m_state == JobState::FAILED)
+    event_name = "failed";
+
+  if (!subscriber.m_ptrStream->send(create_event_message(event_name, event_json)))
+    return false; // client disconnected
+
+  subscriber.m_sentStatus = std::move(job_status);
+  subscriber.m_isStatusSent = true;
+  subscriber.m_sentTime = now_time;
+
+  return !is_finished;
+}
+
+void JobEventHub::subscribe(const uint64_t &job_id, drogon::ResponseStreamPtr &&ptr_stream)
+{
+  {
+    std::lock_guard<std::mutex> subscriber_lock(m_mutex);
+    if (m_isStopped)
+    {
+      ptr_stream->close();
+      return;
+    }
+
+    Subscriber subscriber;
+    subscriber.m_jobId = job_id;
+    subscriber.m_ptrStream = std::move(ptr_stream);
+    m_subscriberList.push_back(std::move(subscriber));
+    m_isPushRequested = true; // current status is sent at once
+  }
+  m_pushCv.notify_one();
+}
+
+void JobEventHub::requestPush()
+{
+  {
+    std::lock_guard<std::mutex> subscriber_lock(m_mutex);
+    m_isPushRequested = true;
+  }
+  m_pushCv.notify_one();
+}
+
+void JobEventHub::stop()
+{
+  {
+    std::lock_guard<std::mutex> subscriber_lock(m_mutex);
+    if (m_isStopped)
+      return;
+
+    m_isStopped = true;
+  }
+  m_pushCv.notify_all();
+
+  if (m_pusher.joinable())
+    m_pusher.join();
+
+  for (auto &subscriber : m_subscriberList)
+    subscriber.m_ptrStream->close();
+  m_subscriberList.clear();
+}
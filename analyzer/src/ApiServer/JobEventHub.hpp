@@ -0,0 +1,65 @@
+#pragma once
+
+#include <drogon/drogon.h>
+
+#include "JobScheduler.hpp"
+
+namespace ApiServer
+{
+  // Pusher of job progress to Server-Sent Events streams (/job_events/{access-id})
+  class JobEventHub
+  {
+  private:
+    // Stream of client waiting for one job
+    struct Subscriber
+    {
+      uint64_t m_jobId = 0;
+      drogon::ResponseStreamPtr m_ptrStream;
+      JobStatusTable::JobStatus m_sentStatus; // last pushed status
+      bool m_isStatusSent = false;
+      std::chrono::steady_clock::time_point m_sentTime; // last pushed event (or keep-alive)
+    };
+
+    const JobScheduler &m_jobScheduler;
+    std::mutex m_mutex;
+    std::condition_variable m_pushCv;
+    std::vector<Subscriber> m_subscriberList;
+    std::chrono::milliseconds m_pushInterval;
+    bool m_isPushRequested;
+    bool m_isStopped;
+    std::thread m_pusher;
+
+    /// @brief pusher thread's loop
+    void pushEvents();
+
+    /// @brief push event of changed status to subscriber
+    /// @param subscriber Subscriber
+    /// @return false if subscriber is finished (job finished, job unknown or client disconnected)
+    bool pushEvent(Subscriber &subscriber) const;
+
+  public:
+    /// @brief constructor (start pusher thread)
+    /// @param job_scheduler Scheduler whose job statuses are pushed
+    /// @param push_interval Interval of progress events (finished jobs are pushed without waiting it)
+    JobEventHub(const JobScheduler &job_scheduler, const std::chrono::milliseconds &push_interval);
+
+    /// @brief destructor (stop pusher thread)
+    ~JobEventHub();
+
+    /* forbid copy action */
+    JobEventHub(const JobEventHub &other) = delete;
+    JobEventHub &operator=(const JobEventHub &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief register stream of client (thread-safe)
+    /// @param job_id Access id of job
+    /// @param ptr_stream Event stream to client (closed after completion event)
+    void subscribe(const uint64_t &job_id, drogon::ResponseStreamPtr &&ptr_stream);
+
+    /// @brief wake pusher to send completion event at once (thread-safe)
+    void requestPush();
+
+    /// @brief stop pusher thread (close streams)
+    void stop();
+  };
+};
@@ -0,0 +1,180 @@
+#include "JobScheduler.hpp"
+
+#include <random>
+
+using namespace ApiServer;
+
+JobScheduler::JobScheduler(const uint32_t &max_running_job_num, const size_t &max_queued_job_num,
+                           const size_t &job_status_slot_num)
+    : m_jobStatusTable(job_status_slot_num), m_nextJobId(1), m_maxQueuedJobNum(max_queued_job_num), m_isStopped(false)
+{
+  // ids of another server run are not mistaken for this run's jobs
+  std::random_device random_device;
+  m_nextJobId = (static_cast<uint64_t>(random_device() & 0xFFFFU) << 32U) + 1U;
+
+  for (uint32_t runner_idx = 0; runner_idx < std::max(1U, max_running_job_num); runner_idx++)
+    m_runnerList.emplace_back(&JobScheduler::runJobs, this);
+}
+
+JobScheduler::~JobScheduler()
+{
+  stop();
+}
+
+void JobScheduler::runJobs()
+{
+  while (true)
+  {
+    std::shared_ptr<Job> ptr_job;
+    std::function<void(const uint64_t &)> job_finished_listener;
+    {
+      std::unique_lock<std::mutex> queue_lock(m_mutex);
+      m_queueCv.wait(queue_lock, [&]()
+                     { return m_isStopped || !m_queuedJobList.empty(); });
+      if (m_isStopped)
+        return;
+
+      ptr_job = std::move(m_queuedJobList.front());
+      m_queuedJobList.pop_front();
+      job_finished_listener = m_jobFinishedListener;
+    }
+
+    auto &server_counters = Metrics::get_counters();
+    server_counters.m_queuedJobNum.fetch_sub(1, std::memory_order_relaxed);
+    const auto &ptr_linked_job = ptr_job->m_ptrLinkedJob;
+    for (const auto &ptr_started_job : {ptr_job, ptr_linked_job})
+      if (ptr_started_job != nullptr)
+      {
+        Metrics::start_job(ptr_started_job->m_jobKind);
+        JobStatusTable::setState(*ptr_started_job->m_ptrStatusSlot, JobState::RUNNING);
+      }
+
+    std::string error_message;
+    try
+    {
+      ptr_job->m_jobFunction(*ptr_job);
+    }
+    catch (const std::exception &exception)
+    {
+      error_message = exception.what();
+      std::cout << "job " << ptr_job->m_jobId << " failed: " << exception.what() << std::endl;
+    }
+
+    for (const auto &ptr_finished_job : {ptr_job, ptr_linked_job})
+    {
+      if (ptr_finished_job == nullptr)
+        continue;
+
+      // exception fails both jobs, error set on one job fails only it
+      auto &job_status_slot = *ptr_finished_job->m_ptrStatusSlot;
+      const auto &job_error_message = error_message.empty() ? ptr_finished_job->m_errorMessage : error_message;
+      if (job_error_message.empty())
+        JobStatusTable::setState(job_status_slot, JobState::COMPLETED);
+      else
+        JobStatusTable::setFailed(job_status_slot, job_error_message);
+
+      Metrics::finish_job(ptr_finished_job->m_jobKind);
+      if (job_finished_listener)
+        job_finished_listener(ptr_finished_job->m_jobId);
+    }
+  }
+}
+
+uint64_t JobScheduler::queueJob(const std::shared_ptr<Job> &ptr_job)
+{
+  {
+    std::lock_guard<std::mutex> queue_lock(m_mutex);
+    if (m_isStopped || m_queuedJobList.size() >= m_maxQueuedJobNum)
+      return 0U;
+
+    // slot of older job still queued or running is not overwritten
+    ptr_job->m_ptrStatusSlot = m_jobStatusTable.assignSlot(m_nextJobId, ptr_job->m_jobKind);
+    if (ptr_job->m_ptrStatusSlot == nullptr)
+      return 0U;
+    ptr_job->m_jobId = m_nextJobId++;
+
+    const auto &ptr_linked_job = ptr_job->m_ptrLinkedJob;
+    if (ptr_linked_job != nullptr)
+    {
+      ptr_linked_job->m_ptrStatusSlot = m_jobStatusTable.assignSlot(m_nextJobId, ptr_linked_job->m_jobKind);
+      if (ptr_linked_job->m_ptrStatusSlot == nullptr)
+      {
+        // queued slot is freed by finishing it
+        JobStatusTable::setState(*ptr_job->m_ptrStatusSlot, JobState::RUNNING);
+        JobStatusTable::setFailed(*ptr_job->m_ptrStatusSlot, "status slot is not free");
+        m_jobStatusTable.eraseStatus(ptr_job->m_jobId);
+        return 0U;
+      }
+      ptr_linked_job->m_jobId = m_nextJobId++;
+    }
+
+    m_queuedJobList.push_back(ptr_job);
+  }
+  Metrics::get_counters().m_queuedJobNum.fetch_add(1, std::memory_order_relaxed);
+  m_queueCv.notify_one();
+
+  return ptr_job->m_jobId;
+}
+
+uint64_t JobScheduler::submitJob(const Metrics::JobKind &job_kind, std::function<void(Job &)> &&job_function)
+{
+  auto ptr_job = std::make_shared<Job>();
+  ptr_job->m_jobKind = job_kind;
+  ptr_job->m_jobFunction = std::move(job_function);
+
+  return queueJob(ptr_job);
+}
+
+uint64_t JobScheduler::submitLinkedJobs(const Metrics::JobKind &job_kind, const Metrics::JobKind &linked_job_kind,
+                                        std::function<void(Job &)> &&job_function, uint64_t &linked_job_id)
+{
+  auto ptr_job = std::make_shared<Job>();
+  ptr_job->m_jobKind = job_kind;
+  ptr_job->m_jobFunction = std::move(job_function);
+  ptr_job->m_ptrLinkedJob = std::make_shared<Job>();
+  ptr_job->m_ptrLinkedJob->m_jobKind = linked_job_kind;
+
+  const auto job_id = queueJob(ptr_job);
+  linked_job_id = (job_id == 0U) ? 0U : ptr_job->m_ptrLinkedJob->m_jobId;
+
+  return job_id;
+}
+
+uint64_t JobScheduler::registerCompletedJob(const Metrics::JobKind &job_kind)
+{
+  std::lock_guard<std::mutex> queue_lock(m_mutex);
+  if (m_isStopped)
+    return 0U;
+
+  const auto ptr_status_slot = m_jobStatusTable.assignSlot(m_nextJobId, job_kind);
+  if (ptr_status_slot == nullptr)
+    return 0U;
+  JobStatusTable::setState(*ptr_status_slot, JobState::RUNNING);
+  JobStatusTable::setState(*ptr_status_slot, JobState::COMPLETED);
+
+  return m_nextJobId++;
+}
+
+void JobScheduler::setJobFinishedListener(std::function<void(const uint64_t &)> &&job_finished_listener)
+{
+  std::lock_guard<std::mutex> queue_lock(m_mutex);
+  m_jobFinishedListener = std::move(job_finished_listener);
+}
+
+void JobScheduler::stop()
+{
+  {
+    std::lock_guard<std::mutex> queue_lock(m_mutex);
+    if (m_isStopped)
+      return;
+
+    m_isStopped = true;
+    Metrics::get_counters().m_queuedJobNum.fetch_sub(static_cast<int64_t>(m_queuedJobList.size()), std::memory_order_relaxed);
+    m_queuedJobList.clear();
+  }
+  m_queueCv.notify_all();
+
+  for (auto &runner : m_runnerList)
+    if (runner.joinable())
+      runner.join();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+
+#include "JobStatusTable.hpp"
+
+namespace ApiServer
+{
+  // Background job queued in JobScheduler
+  struct Job
+  {
+    uint64_t m_jobId = 0; // access id of client (generated, never reused)
+    Metrics::JobKind m_jobKind = Metrics::JobKind::ANALYZE;
+    JobStatusTable::JobStatusSlot *m_ptrStatusSlot = nullptr;
+    std::function<void(Job &)> m_jobFunction; // throws on failure
+    std::shared_ptr<Job> m_ptrLinkedJob = nullptr; // job of other kind done by same function (finished together)
+    std::string m_errorMessage; // set by function of linked jobs: only this job fails although function returns
+
+    /// @brief set frames of job (progression: frame_count / frame_num)
+    void setFrameNum(const uint64_t &frame_num) { m_ptrStatusSlot->m_frameNum.store(frame_num, std::memory_order_relaxed); }
+
+    /// @brief set processed frames (called per frame)
+    void setFrameCount(const uint64_t &frame_count) { m_ptrStatusSlot->m_frameCount.store(frame_count, std::memory_order_relaxed); }
+  };
+
+  // Runner of background jobs (bounded runner threads, FIFO queue, statuses keyed by job id)
+  class JobScheduler
+  {
+  private:
+    std::mutex m_mutex;
+    std::condition_variable m_queueCv;
+    std::deque<std::shared_ptr<Job>> m_queuedJobList;
+    JobStatusTable m_jobStatusTable;
+    std::vector<std::thread> m_runnerList;
+    std::function<void(const uint64_t &)> m_jobFinishedListener; // called with id of finished job
+    uint64_t m_nextJobId;
+    size_t m_maxQueuedJobNum;
+    bool m_isStopped;
+
+    /// @brief runner thread's loop
+    void runJobs();
+
+    /// @brief register job (and linked job) and queue it
+    /// @param ptr_job Job (m_ptrLinkedJob is registered if set)
+    /// @return Access id of job (0 when queue is full or scheduler is stopped)
+    uint64_t queueJob(const std::shared_ptr<Job> &ptr_job);
+
+  public:
+    /// @brief constructor (start runner threads)
+    /// @param max_running_job_num Number of jobs run at the same time
+    /// @param max_queued_job_num Number of jobs waiting for runner (submitJob fails beyond it)
+    /// @param job_status_slot_num Number of recent jobs whose statuses are kept
+    JobScheduler(const uint32_t &max_running_job_num, const size_t &max_queued_job_num, const size_t &job_status_slot_num);
+
+    /// @brief destructor (wait for running jobs, discard queued jobs)
+    ~JobScheduler();
+
+    /* forbid copy action */
+    JobScheduler(const JobScheduler &other) = delete;
+    JobScheduler &operator=(const JobScheduler &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief register job and queue it (thread-safe)
+    /// @param job_kind Kind of job
+    /// @param job_function Work of job, called on runner thread (throws on failure)
+    /// @return Access id of job (0 when queue is full or scheduler is stopped)
+    uint64_t submitJob(const Metrics::JobKind &job_kind, std::function<void(Job &)> &&job_function);
+
+    /// @brief register job and linked job of another kind, queue them as one job (thread-safe)
+    /// @param job_kind Kind of job
+    /// @param linked_job_kind Kind of linked job (its progression is set through job.m_ptrLinkedJob)
+    /// @param job_function Work of both jobs, called on runner thread (throws on failure of both, sets m_errorMessage of linked job on its own failure)
+    /// @param linked_job_id Access id of linked job (output)
+    /// @return Access id of job (0 when queue is full or scheduler is stopped)
+    uint64_t submitLinkedJobs(const Metrics::JobKind &job_kind, const Metrics::JobKind &linked_job_kind,
+                              std::function<void(Job &)> &&job_function, uint64_t &linked_job_id);
+
+    /// @brief register job whose result already exists (e.g. cached result) as completed (thread-safe)
+    /// @param job_kind Kind of job
+    /// @return Access id of job (0 when its status slot is not free or scheduler is stopped)
+    uint64_t registerCompletedJob(const Metrics::JobKind &job_kind);
+
+    /// @brief read status of job (lock-free, thread-safe)
+    /// @param job_id Access id of job
+    /// @param job_status Snapshot (output)
+    /// @return false if job is not registered
+    bool readJobStatus(const uint64_t &job_id, JobStatusTable::JobStatus &job_status) const
+    {
+      return m_jobStatusTable.readStatus(job_id, job_status);
+    }
+
+    /// @brief unregister finished job (thread-safe, queued or running job is kept)
+    /// @param job_id Access id of job
+    void eraseJob(const uint64_t &job_id) { m_jobStatusTable.eraseStatus(job_id); }
+
+    /// @brief set listener notified on runner thread after job completed or failed (thread-safe)
+    /// @param job_finished_listener Function called with access id of finished job
+    void setJobFinishedListener(std::function<void(const uint64_t &)> &&job_finished_listener);
+
+    /// @brief stop runner threads (wait for running jobs, discard queued jobs)
+    void stop();
+  };
+};
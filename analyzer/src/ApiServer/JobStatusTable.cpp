@@ -0,0 +1,147 @@
+#include "JobStatusTable.hpp"
+
+using namespace ApiServer;
+
+static_assert(std::atomic<JobState>::is_always_lock_free && std::atomic<Metrics::JobKind>::is_always_lock_free);
+
+static const std::array<std::string, 4> JOB_STATE_NAMES{"queued", "running", "completed", "failed"};
+
+/// @brief get steady clock time
+/// @return Nanoseconds since epoch of steady clock
+static int64_t get_steady_nanoseconds()
+{
+  return static_cast<int64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+double JobStatusTable::JobStatus::getProgression() const
+{
+  if (m_state == JobState::COMPLETED)
+    return 1.0;
+  if (m_frameNum == 0U)
+    return 0.0;
+
+  return std::min(1.0, static_cast<double>(m_frameCount) / static_cast<double>(m_frameNum));
+}
+
+nlohmann::json JobStatusTable::JobStatus::getJson() const
+{
+  nlohmann::json status_json;
+  status_json["state"] = JOB_STATE_NAMES[static_cast<size_t>(m_state)];
+  status_json["progression"] = getProgression();
+  status_json["frame_count"] = m_frameCount;
+  status_json["wait_s"] = m_waitSeconds;
+  status_json["elapsed_s"] = m_elapsedSeconds;
+  if (m_state == JobState::FAILED)
+    status_json["error"] = m_errorMessage;
+
+  return status_json;
+}
+
+JobStatusTable::JobStatusTable(const size_t &slot_num)
+    : m_slots(new JobStatusSlot[std::max<size_t>(slot_num, 1U)]()), m_slotNum(std::max<size_t>(slot_num, 1U))
+{
+}
+
+JobStatusTable::JobStatusSlot *JobStatusTable::assignSlot(const uint64_t &job_id, const Metrics::JobKind &job_kind)
+{
+  auto &job_status_slot = m_slots[job_id % m_slotNum];
+  if (job_status_slot.m_jobId.load(std::memory_order_relaxed) != 0U)
+  {
+    const auto previous_state = job_status_slot.m_state.load(std::memory_order_acquire);
+    if (previous_state == JobState::QUEUED || previous_state == JobState::RUNNING)
+      return nullptr;
+  }
+
+  // readers of previous job see id change and discard their snapshot
+  job_status_slot.m_jobId.store(0U, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  job_status_slot.m_jobKind.store(job_kind, std::memory_order_relaxed);
+  job_status_slot.m_state.store(JobState::QUEUED, std::memory_order_relaxed);
+  job_status_slot.m_frameCount.store(0U, std::memory_order_relaxed);
+  job_status_slot.m_frameNum.store(0U, std::memory_order_relaxed);
+  job_status_slot.m_queuedNanoseconds.store(get_steady_nanoseconds(), std::memory_order_relaxed);
+  job_status_slot.m_startedNanoseconds.store(0, std::memory_order_relaxed);
+  job_status_slot.m_finishedNanoseconds.store(0, std::memory_order_relaxed);
+  job_status_slot.m_errorMessage[0].store('\0', std::memory_order_relaxed);
+  job_status_slot.m_jobId.store(job_id, std::memory_order_release);
+
+  return &job_status_slot;
+}
+
+bool JobStatusTable::readStatus(const uint64_t &job_id, JobStatus &job_status) const
+{
+  if (job_id == 0U)
+    return false;
+
+  const auto &job_status_slot = m_slots[job_id % m_slotNum];
+  if (job_status_slot.m_jobId.load(std::memory_order_acquire) != job_id)
+    return false;
+
+  job_status.m_jobId = job_id;
+  job_status.m_jobKind = job_status_slot.m_jobKind.load(std::memory_order_relaxed);
+  job_status.m_state = job_status_slot.m_state.load(std::memory_order_acquire);
+  job_status.m_frameCount = job_status_slot.m_frameCount.load(std::memory_order_relaxed);
+  job_status.m_frameNum = job_status_slot.m_frameNum.load(std::memory_order_relaxed);
+
+  const auto now_nanoseconds = get_steady_nanoseconds();
+  const auto queued_nanoseconds = job_status_slot.m_queuedNanoseconds.load(std::memory_order_relaxed);
+  const auto started_nanoseconds = job_status_slot.m_startedNanoseconds.load(std::memory_order_relaxed);
+  const auto finished_nanoseconds = job_status_slot.m_finishedNanoseconds.load(std::memory_order_relaxed);
+  job_status.m_waitSeconds =
+      static_cast<double>((started_nanoseconds != 0 ? started_nanoseconds : now_nanoseconds) - queued_nanoseconds) * 1e-9;
+  job_status.m_elapsedSeconds = (started_nanoseconds == 0)
+                                    ? 0.0
+                                    : static_cast<double>((finished_nanoseconds != 0 ? finished_nanoseconds : now_nanoseconds) -
+                                                          started_nanoseconds) *
+                                          1e-9;
+
+  job_status.m_errorMessage.clear();
+  if (job_status.m_state == JobState::FAILED)
+    for (size_t char_idx = 0; char_idx < ERROR_MESSAGE_SIZE; char_idx++)
+    {
+      const auto error_char = job_status_slot.m_errorMessage[char_idx].load(std::memory_order_relaxed);
+      if (error_char == '\0')
+        break;
+      job_status.m_errorMessage.push_back(error_char);
+    }
+
+  // slot reused by another job while reading
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return job_status_slot.m_jobId.load(std::memory_order_relaxed) == job_id;
+}
+
+void JobStatusTable::eraseStatus(const uint64_t &job_id)
+{
+  if (job_id == 0U)
+    return;
+
+  auto &job_status_slot = m_slots[job_id % m_slotNum];
+  const auto job_state = job_status_slot.m_state.load(std::memory_order_acquire);
+  if (job_state != JobState::COMPLETED && job_state != JobState::FAILED)
+    return;
+
+  auto expected_job_id = job_id;
+  job_status_slot.m_jobId.compare_exchange_strong(expected_job_id, 0U, std::memory_order_acq_rel);
+}
+
+void JobStatusTable::setState(JobStatusSlot &job_status_slot, const JobState &job_state)
+{
+  if (job_state == JobState::RUNNING)
+    job_status_slot.m_startedNanoseconds.store(get_steady_nanoseconds(), std::memory_order_relaxed);
+  else if (job_state == JobState::COMPLETED || job_state == JobState::FAILED)
+    job_status_slot.m_finishedNanoseconds.store(get_steady_nanoseconds(), std::memory_order_relaxed);
+
+  job_status_slot.m_state.store(job_state, std::memory_order_release);
+}
+
+void JobStatusTable::setFailed(JobStatusSlot &job_status_slot, const std::string &error_message)
+{
+  const auto message_length = std::min(error_message.size(), ERROR_MESSAGE_SIZE - 1U);
+  for (size_t char_idx = 0; char_idx < message_length; char_idx++)
+    job_status_slot.m_errorMessage[char_idx].store(error_message[char_idx], std::memory_order_relaxed);
+  job_status_slot.m_errorMessage[message_length].store('\0', std::memory_order_relaxed);
+
+  setState(job_status_slot, JobState::FAILED);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+
+#include "Metrics.hpp"
+
+namespace ApiServer
+{
+  // Lifecycle of background job
+  enum class JobState : uint8_t
+  {
+    QUEUED,
+    RUNNING,
+    COMPLETED,
+    FAILED,
+  };
+
+  // Preallocated status slots of jobs (slot of job: job_id % slot_num, read without lock)
+  class JobStatusTable
+  {
+  public:
+    static constexpr size_t ERROR_MESSAGE_SIZE = 128; // including terminator
+
+    // Status of one job (written by its runner, every field is atomic)
+    struct JobStatusSlot
+    {
+      std::atomic<uint64_t> m_jobId; // 0: unused (changed last on reuse, readers re-check it)
+      std::atomic<Metrics::JobKind> m_jobKind;
+      std::atomic<JobState> m_state;
+      std::atomic<uint64_t> m_frameCount; // processed frames
+      std::atomic<uint64_t> m_frameNum;   // frames of video (0: unknown)
+      std::atomic<int64_t> m_queuedNanoseconds; // steady clock of submit, start and finish
+      std::atomic<int64_t> m_startedNanoseconds;
+      std::atomic<int64_t> m_finishedNanoseconds;
+      std::array<std::atomic<char>, ERROR_MESSAGE_SIZE> m_errorMessage; // written before FAILED
+    };
+
+    // Snapshot of slot
+    struct JobStatus
+    {
+      uint64_t m_jobId = 0;
+      Metrics::JobKind m_jobKind = Metrics::JobKind::ANALYZE;
+      JobState m_state = JobState::QUEUED;
+      uint64_t m_frameCount = 0;
+      uint64_t m_frameNum = 0;
+      double m_waitSeconds = 0.0;    // queued ~ started (or now)
+      double m_elapsedSeconds = 0.0; // started ~ finished (or now)
+      std::string m_errorMessage;
+
+      /// @brief get progression of job (0.0 ~ 1.0)
+      double getProgression() const;
+
+      /// @brief get status as json ({"state", "progression", "frame_count", ...})
+      nlohmann::json getJson() const;
+    };
+
+  private:
+    std::unique_ptr<JobStatusSlot[]> m_slots;
+    size_t m_slotNum;
+
+  public:
+    /// @brief constructor
+    /// @param slot_num Number of slots (statuses of older jobs are overwritten after slot_num jobs)
+    explicit JobStatusTable(const size_t &slot_num);
+
+    /* forbid copy action */
+    JobStatusTable(const JobStatusTable &other) = delete;
+    JobStatusTable &operator=(const JobStatusTable &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief take slot of new job as QUEUED (single writer: called under JobScheduler's lock)
+    /// @param job_id Access id of job (not 0)
+    /// @param job_kind Kind of job
+    /// @return Slot (nullptr if previous job of slot is still queued or running)
+    JobStatusSlot *assignSlot(const uint64_t &job_id, const Metrics::JobKind &job_kind);
+
+    /// @brief read status of job (lock-free, thread-safe)
+    /// @param job_id Access id of job
+    /// @param job_status Snapshot (output)
+    /// @return false if job is not registered (unknown, erased or overwritten)
+    bool readStatus(const uint64_t &job_id, JobStatus &job_status) const;
+
+    /// @brief unregister finished job (thread-safe, queued or running job is kept)
+    /// @param job_id Access id of job
+    void eraseStatus(const uint64_t &job_id);
+
+    /// @brief change state of job (called by its runner)
+    static void setState(JobStatusSlot &job_status_slot, const JobState &job_state);
+
+    /// @brief mark job as failed with message (called by its runner)
+    static void setFailed(JobStatusSlot &job_status_slot, const std::string &error_message);
+
+    /// @brief getter slotNum
+    const size_t &getSlotNum() const { return m_slotNum; }
+  };
+};
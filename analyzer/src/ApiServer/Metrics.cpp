@@ -0,0 +1,230 @@
+#include "Metrics.hpp"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <tuple>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+using namespace ApiServer::Metrics;
+
+// counters are updated on per-frame path, they must not fall back to locks
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free);
+
+static ServerCounters g_server_counters; // zero-initialized (static storage)
+
+static constexpr size_t EXPOSED_BUCKET_BEGIN = 10; // smaller buckets (< 1 us) are merged into first exposed bucket
+static constexpr std::array<const char *, static_cast<size_t>(JobKind::JOB_KIND_NUM)> JOB_KIND_NAMES{"analyze", "visualize"};
+
+/// @brief write header of metric (# HELP, # TYPE)
+static void write_metric_header(std::ostringstream &text_stream, const std::string &metric_name,
+                                const std::string &metric_type, const std::string &help_text)
+{
+  text_stream << "# HELP " << metric_name << ' ' << help_text << '\n'
+              << "# TYPE " << metric_name << ' ' << metric_type << '\n';
+}
+
+/// @brief write metric having one sample
+template <typename T>
+static void write_single_metric(std::ostringstream &text_stream, const std::string &metric_name,
+                                const std::string &metric_type, const std::string &help_text, const T &value)
+{
+  write_metric_header(text_stream, metric_name, metric_type, help_text);
+  text_stream << metric_name << ' ' << value << '\n';
+}
+
+/// @brief write metric having one sample per job kind (label: kind)
+template <typename T>
+static void write_job_kind_metric(std::ostringstream &text_stream, const std::string &metric_name,
+                                  const std::string &metric_type, const std::string &help_text,
+                                  const std::array<std::atomic<T>, static_cast<size_t>(JobKind::JOB_KIND_NUM)> &atomic_array)
+{
+  write_metric_header(text_stream, metric_name, metric_type, help_text);
+  for (size_t kind_idx = 0; kind_idx < atomic_array.size(); kind_idx++)
+    text_stream << metric_name << "{kind=\"" << JOB_KIND_NAMES[kind_idx] << "\"} "
+                << atomic_array[kind_idx].load(std::memory_order_relaxed) << '\n';
+}
+
+/// @brief write samples of histogram (cumulative buckets, seconds)
+/// @param label_str Labels without braces ("" or `stage="warp"`)
+static void write_histogram_samples(std::ostringstream &text_stream, const std::string &metric_name,
+                                    const std::string &label_str, const AtomicHistogram &atomic_histogram)
+{
+  const auto label_prefix = label_str.empty() ? std::string() : label_str + ",";
+  uint64_t accumulated_count = 0U;
+  for (size_t bucket_idx = 0; bucket_idx < GCB::StageTimingProfile::BUCKET_NUM; bucket_idx++)
+  {
+    accumulated_count += atomic_histogram.m_bucketCounts[bucket_idx].load(std::memory_order_relaxed);
+    if (bucket_idx < EXPOSED_BUCKET_BEGIN || bucket_idx + 1 == GCB::StageTimingProfile::BUCKET_NUM)
+      continue;
+
+    // upper bound of bucket: 2^(i+1) nanoseconds
+    text_stream << metric_name << "_bucket{" << label_prefix << "le=\""
+                << static_cast<double>(uint64_t{2} << bucket_idx) * 1e-9 << "\"} " << accumulated_count << '\n';
+  }
+  text_stream << metric_name << "_bucket{" << label_prefix << "le=\"+Inf\"} " << accumulated_count << '\n';
+
+  const auto label_braces = label_str.empty() ? std::string() : "{" + label_str + "}";
+  text_stream << metric_name << "_sum" << label_braces << ' '
+              << static_cast<double>(atomic_histogram.m_totalNanoseconds.load(std::memory_order_relaxed)) * 1e-9 << '\n'
+              << metric_name << "_count" << label_braces << ' ' << accumulated_count << '\n';
+}
+
+/// @brief get memory usage of this process (/proc/self/statm, getrusage)
+/// @return (resident bytes, virtual bytes, peak resident bytes), zero if it cannot be read
+static std::tuple<uint64_t, uint64_t, uint64_t> get_memory_bytes()
+{
+  std::ifstream statm_ifs("/proc/self/statm");
+  uint64_t virtual_page_num = 0, resident_page_num = 0;
+  statm_ifs >> virtual_page_num >> resident_page_num;
+
+  ::rusage resource_usage;
+  ::getrusage(RUSAGE_SELF, &resource_usage);
+
+  const auto page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  return {resident_page_num * page_size, virtual_page_num * page_size,
+          static_cast<uint64_t>(resource_usage.ru_maxrss) * 1024U}; // kilobytes on Linux
+}
+
+ServerCounters &ApiServer::Metrics::get_counters()
+{
+  return g_server_counters;
+}
+
+void ApiServer::Metrics::count_analyzation_results(const std::vector<GCB::AnalyzationResult> &analyzation_result_list)
+{
+  uint64_t failure_num = 0;
+  for (const auto &analyzation_result : analyzation_result_list)
+    failure_num += analyzation_result.m_isMarkerFound ? 0U : 1U;
+
+  if (failure_num > 0U)
+    g_server_counters.m_markerDetectionFailureNum.fetch_add(failure_num, std::memory_order_relaxed);
+}
+
+void ApiServer::Metrics::add_video_analysis_statistics(const GCB::VideoAnalysisStatistics &video_analysis_statistics)
+{
+  auto &server_counters = g_server_counters;
+  server_counters.m_decodedFrameNum.fetch_add(video_analysis_statistics.m_frameNum, std::memory_order_relaxed);
+  server_counters.m_decodeNanoseconds.fetch_add(
+      static_cast<uint64_t>(video_analysis_statistics.m_decodeSeconds * 1e9), std::memory_order_relaxed);
+
+  // aggregated per bucket locally, shared cache lines are touched once per bucket
+  std::array<uint64_t, GCB::StageTimingProfile::BUCKET_NUM> latency_bucket_counts{};
+  uint64_t latency_total_nanoseconds = 0U;
+  for (const auto &latency_nanoseconds : video_analysis_statistics.m_frameLatencyNanoseconds)
+  {
+    latency_bucket_counts[GCB::StageTimingProfile::getBucketIdx(latency_nanoseconds)]++;
+    latency_total_nanoseconds += latency_nanoseconds;
+  }
+  auto &latency_histogram = server_counters.m_frameLatencyHistogram;
+  for (size_t bucket_idx = 0; bucket_idx < GCB::StageTimingProfile::BUCKET_NUM; bucket_idx++)
+    if (latency_bucket_counts[bucket_idx] > 0U)
+      latency_histogram.m_bucketCounts[bucket_idx].fetch_add(latency_bucket_counts[bucket_idx], std::memory_order_relaxed);
+  latency_histogram.m_sampleNum.fetch_add(video_analysis_statistics.m_frameLatencyNanoseconds.size(), std::memory_order_relaxed);
+  latency_histogram.m_totalNanoseconds.fetch_add(latency_total_nanoseconds, std::memory_order_relaxed);
+
+  // stage histograms are empty without GCB_STAGE_TIMING
+  const auto &stage_timing_profile = video_analysis_statistics.m_stageTimingProfile;
+  for (size_t stage_idx = 0; stage_idx < static_cast<size_t>(GCB::AnalysisStage::STAGE_NUM); stage_idx++)
+  {
+    const auto &stage_histogram = stage_timing_profile.getStageHistogram(static_cast<GCB::AnalysisStage>(stage_idx));
+    if (stage_histogram.m_sampleNum == 0U)
+      continue;
+
+    auto &atomic_histogram = server_counters.m_stageHistograms[stage_idx];
+    for (size_t bucket_idx = 0; bucket_idx < GCB::StageTimingProfile::BUCKET_NUM; bucket_idx++)
+      if (stage_histogram.m_bucketCounts[bucket_idx] > 0U)
+        atomic_histogram.m_bucketCounts[bucket_idx].fetch_add(stage_histogram.m_bucketCounts[bucket_idx], std::memory_order_relaxed);
+    atomic_histogram.m_sampleNum.fetch_add(stage_histogram.m_sampleNum, std::memory_order_relaxed);
+    atomic_histogram.m_totalNanoseconds.fetch_add(stage_histogram.m_totalNanoseconds, std::memory_order_relaxed);
+  }
+}
+
+void ApiServer::Metrics::start_job(const JobKind &job_kind)
+{
+  const auto kind_idx = static_cast<size_t>(job_kind);
+  g_server_counters.m_startedJobNum[kind_idx].fetch_add(1, std::memory_order_relaxed);
+  g_server_counters.m_activeJobNum[kind_idx].fetch_add(1, std::memory_order_relaxed);
+}
+
+void ApiServer::Metrics::finish_job(const JobKind &job_kind)
+{
+  const auto kind_idx = static_cast<size_t>(job_kind);
+  g_server_counters.m_completedJobNum[kind_idx].fetch_add(1, std::memory_order_relaxed);
+  g_server_counters.m_activeJobNum[kind_idx].fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::string ApiServer::Metrics::get_prometheus_text()
+{
+  const auto &server_counters = g_server_counters;
+  const auto load = [](const auto &atomic_value)
+  { return atomic_value.load(std::memory_order_relaxed); };
+
+  std::ostringstream text_stream;
+  text_stream << std::setprecision(12); // bucket bounds (2^n nanoseconds) are exact
+
+  /* jobs */
+  write_job_kind_metric(text_stream, "gcb_jobs_active", "gauge", "Background jobs running.", server_counters.m_activeJobNum);
+  write_job_kind_metric(text_stream, "gcb_jobs_started_total", "counter", "Background jobs started.",
+                        server_counters.m_startedJobNum);
+  write_job_kind_metric(text_stream, "gcb_jobs_completed_total", "counter", "Background jobs finished (completed or failed).",
+                        server_counters.m_completedJobNum);
+  write_single_metric(text_stream, "gcb_jobs_queued", "gauge", "Background jobs waiting for start.",
+                      load(server_counters.m_queuedJobNum));
+  write_single_metric(text_stream, "gcb_pictures_queued", "gauge", "Picture requests waiting for or running on compute pool.",
+                      load(server_counters.m_queuedPictureNum));
+  write_single_metric(text_stream, "gcb_result_cache_hits_total", "counter",
+                      "Video analysis requests answered by cached result.", load(server_counters.m_resultCacheHitNum));
+  write_single_metric(text_stream, "gcb_result_cache_coalesced_total", "counter",
+                      "Video analysis requests sharing running job of same video and request.",
+                      load(server_counters.m_coalescedJobNum));
+  /* end: jobs */
+
+  /* analysis */
+  write_single_metric(text_stream, "gcb_analyzed_frames_total", "counter",
+                      "Video frames analyzed (rate() gives frames per second).", load(server_counters.m_analyzedFrameNum));
+  write_single_metric(text_stream, "gcb_analyzed_pictures_total", "counter",
+                      "Pictures analyzed by /analyze_picture.", load(server_counters.m_analyzedPictureNum));
+  write_single_metric(text_stream, "gcb_marker_detection_failures_total", "counter",
+                      "Devices whose markers are not found (LED pattern is reported as 0).",
+                      load(server_counters.m_markerDetectionFailureNum));
+
+  write_metric_header(text_stream, "gcb_frame_latency_seconds", "histogram",
+                      "Latency of video frame from taken by worker to its result merged.");
+  write_histogram_samples(text_stream, "gcb_frame_latency_seconds", "", server_counters.m_frameLatencyHistogram);
+
+  if (GCB::STAGE_TIMING_ENABLED)
+  {
+    write_metric_header(text_stream, "gcb_stage_duration_seconds", "histogram", "Duration of analyzePicture stages.");
+    for (size_t stage_idx = 0; stage_idx < static_cast<size_t>(GCB::AnalysisStage::STAGE_NUM); stage_idx++)
+      write_histogram_samples(text_stream, "gcb_stage_duration_seconds",
+                              "stage=\"" + GCB::StageTimingProfile::getStageName(static_cast<GCB::AnalysisStage>(stage_idx)) + "\"",
+                              server_counters.m_stageHistograms[stage_idx]);
+  }
+  /* end: analysis */
+
+  /* io */
+  write_single_metric(text_stream, "gcb_upload_bytes_total", "counter",
+                      "Bytes of uploaded pictures, videos and request JSONs.", load(server_counters.m_uploadBytes));
+  write_single_metric(text_stream, "gcb_decoded_frames_total", "counter",
+                      "Video frames decoded by analysis and visualization jobs.", load(server_counters.m_decodedFrameNum));
+  write_single_metric(text_stream, "gcb_decode_seconds_total", "counter", "Time spent in decoding video frames.",
+                      static_cast<double>(load(server_counters.m_decodeNanoseconds)) * 1e-9);
+  write_single_metric(text_stream, "gcb_encoded_frames_total", "counter",
+                      "Video frames encoded by visualization jobs.", load(server_counters.m_encodedFrameNum));
+  write_single_metric(text_stream, "gcb_encode_seconds_total", "counter", "Time spent in encoding video frames.",
+                      static_cast<double>(load(server_counters.m_encodeNanoseconds)) * 1e-9);
+  /* end: io */
+
+  /* memory */
+  const auto [resident_bytes, virtual_bytes, peak_resident_bytes] = get_memory_bytes();
+  write_single_metric(text_stream, "process_resident_memory_bytes", "gauge", "Resident memory of server process.", resident_bytes);
+  write_single_metric(text_stream, "process_virtual_memory_bytes", "gauge", "Virtual memory of server process.", virtual_bytes);
+  write_single_metric(text_stream, "process_peak_resident_memory_bytes", "gauge",
+                      "Peak resident memory of server process.", peak_resident_bytes);
+  /* end: memory */
+
+  return text_stream.str();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+
+#include "../GCB.hpp"
+
+// Operational counters of gcb-analyzer (exposed by /metrics in Prometheus text format)
+namespace ApiServer::Metrics
+{
+  // Kind of background job
+  enum class JobKind : size_t
+  {
+    ANALYZE,   // /analyze_video
+    VISUALIZE, // /visualize_analyzation_result
+    JOB_KIND_NUM,
+  };
+
+  // Histogram of durations (bucket i: 2^i ~ 2^(i+1) nanoseconds, same as GCB::StageTimingProfile)
+  struct AtomicHistogram
+  {
+    std::array<std::atomic<uint64_t>, GCB::StageTimingProfile::BUCKET_NUM> m_bucketCounts;
+    std::atomic<uint64_t> m_sampleNum;
+    std::atomic<uint64_t> m_totalNanoseconds;
+  };
+
+  // Counters updated by request handlers and jobs (lock-free atomics)
+  struct ServerCounters
+  {
+    std::array<std::atomic<int64_t>, static_cast<size_t>(JobKind::JOB_KIND_NUM)> m_activeJobNum;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(JobKind::JOB_KIND_NUM)> m_startedJobNum;
+    std::array<std::atomic<uint64_t>, static_cast<size_t>(JobKind::JOB_KIND_NUM)> m_completedJobNum;
+    std::atomic<int64_t> m_queuedJobNum; // jobs accepted but not started
+    std::atomic<int64_t> m_queuedPictureNum; // /analyze_picture requests on compute pool (waiting or running)
+    std::atomic<uint64_t> m_resultCacheHitNum; // video analysis requests answered by cached result
+    std::atomic<uint64_t> m_coalescedJobNum;   // video analysis requests sharing running job of same request
+    std::atomic<uint64_t> m_analyzedFrameNum;   // video frames
+    std::atomic<uint64_t> m_analyzedPictureNum; // pictures of /analyze_picture
+    std::atomic<uint64_t> m_markerDetectionFailureNum; // devices whose markers are not found
+    std::atomic<uint64_t> m_uploadBytes;
+    std::atomic<uint64_t> m_decodedFrameNum;
+    std::atomic<uint64_t> m_decodeNanoseconds;
+    std::atomic<uint64_t> m_encodedFrameNum;
+    std::atomic<uint64_t> m_encodeNanoseconds;
+    AtomicHistogram m_frameLatencyHistogram; // decode ~ merge of video frames
+    std::array<AtomicHistogram, static_cast<size_t>(GCB::AnalysisStage::STAGE_NUM)> m_stageHistograms;
+  };
+
+  /// @brief getter counters
+  ServerCounters &get_counters();
+
+  /// @brief count analyzation results of one frame or picture (devices whose markers are not found)
+  /// @param analyzation_result_list Results of all devices
+  void count_analyzation_results(const std::vector<GCB::AnalyzationResult> &analyzation_result_list);
+
+  /// @brief add statistics of finished video analysis (decode time, frame latencies, stage histograms)
+  /// @param video_analysis_statistics Statistics returned by GCB::VideoAnalyzer
+  void add_video_analysis_statistics(const GCB::VideoAnalysisStatistics &video_analysis_statistics);
+
+  /// @brief mark job as started (called by JobScheduler)
+  void start_job(const JobKind &job_kind);
+
+  /// @brief mark job as finished (called by JobScheduler)
+  void finish_job(const JobKind &job_kind);
+
+  /// @brief create /metrics response body
+  /// @return Counters in Prometheus text exposition format (version 0.0.4)
+  std::string get_prometheus_text();
+};
@@ -0,0 +1,172 @@
+#include "ResultCache.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "../GCB/json.hpp"
+
+using namespace ApiServer;
+
+ContentHasher::ContentHasher()
+    : m_ptrDigestContext(EVP_MD_CTX_new())
+{
+  if (m_ptrDigestContext == nullptr || EVP_DigestInit_ex(m_ptrDigestContext, EVP_sha256(), nullptr) != 1)
+    throw std::runtime_error("SHA-256 Init Error");
+}
+
+ContentHasher::~ContentHasher()
+{
+  EVP_MD_CTX_free(m_ptrDigestContext);
+}
+
+void ContentHasher::update(const char *data, const size_t &data_size)
+{
+  EVP_DigestUpdate(m_ptrDigestContext, data, data_size);
+}
+
+std::string ContentHasher::finishHex()
+{
+  std::array<unsigned char, EVP_MAX_MD_SIZE> digest;
+  unsigned int digest_size = 0;
+  EVP_DigestFinal_ex(m_ptrDigestContext, digest.data(), &digest_size);
+
+  std::ostringstream hex_stream;
+  hex_stream << std::hex << std::setfill('0');
+  for (unsigned int byte_idx = 0; byte_idx < digest_size; byte_idx++)
+    hex_stream << std::setw(2) << static_cast<uint32_t>(digest[byte_idx]);
+
+  return hex_stream.str();
+}
+
+ResultCache::ResultCache(const std::string &cache_dir_path, const uint64_t &budget_bytes)
+    : m_cacheDirPath(cache_dir_path), m_budgetBytes(budget_bytes), m_totalBytes(0)
+{
+  std::filesystem::create_directories(m_cacheDirPath);
+
+  // last write time is access time of result (updated on hit)
+  std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> cache_file_list;
+  for (const auto &dir_entry : std::filesystem::directory_iterator(m_cacheDirPath))
+    if (dir_entry.is_regular_file() && dir_entry.path().extension() == ".json")
+      cache_file_list.emplace_back(dir_entry.last_write_time(), dir_entry.path());
+  std::sort(cache_file_list.begin(), cache_file_list.end());
+
+  for (const auto &[write_time, cache_file_path] : cache_file_list)
+  {
+    const auto cache_key = cache_file_path.stem().string();
+    m_lruKeyList.push_front(cache_key);
+
+    auto &cache_entry = m_entryMap[cache_key];
+    cache_entry.m_fileBytes = std::filesystem::file_size(cache_file_path);
+    cache_entry.m_lruIter = m_lruKeyList.begin();
+    m_totalBytes += cache_entry.m_fileBytes;
+  }
+
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  evictResults();
+}
+
+std::string ResultCache::getCacheFilePath(const std::string &cache_key) const
+{
+  return m_cacheDirPath + "/" + cache_key + ".json";
+}
+
+void ResultCache::evictResults()
+{
+  while (m_totalBytes > m_budgetBytes && !m_lruKeyList.empty())
+  {
+    const auto &cache_key = m_lruKeyList.back();
+    std::error_code error_code;
+    std::filesystem::remove(getCacheFilePath(cache_key), error_code);
+
+    const auto entry_iter = m_entryMap.find(cache_key);
+    m_totalBytes -= entry_iter->second.m_fileBytes;
+    m_entryMap.erase(entry_iter);
+    m_lruKeyList.pop_back();
+  }
+}
+
+std::string ResultCache::createKey(const std::string &video_digest, const std::string &request_json_string)
+{
+  ContentHasher key_hasher;
+  key_hasher.update(video_digest);
+  key_hasher.update(nlohmann::json::parse(request_json_string).dump()); // object keys are sorted
+
+  return key_hasher.finishHex();
+}
+
+bool ResultCache::containsResult(const std::string &cache_key)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  return m_entryMap.count(cache_key) != 0U;
+}
+
+bool ResultCache::copyResult(const std::string &cache_key, const std::string &result_file_path)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  const auto entry_iter = m_entryMap.find(cache_key);
+  if (entry_iter == m_entryMap.end())
+    return false;
+
+  const auto cache_file_path = getCacheFilePath(cache_key);
+  std::error_code error_code;
+  std::filesystem::create_hard_link(cache_file_path, result_file_path, error_code);
+  if (error_code && !std::filesystem::copy_file(cache_file_path, result_file_path, error_code))
+    return false;
+
+  m_lruKeyList.splice(m_lruKeyList.begin(), m_lruKeyList, entry_iter->second.m_lruIter);
+  std::filesystem::last_write_time(cache_file_path, std::filesystem::file_time_type::clock::now(), error_code);
+
+  return true;
+}
+
+void ResultCache::storeResult(const std::string &cache_key, const std::string &result_file_path)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  if (m_entryMap.count(cache_key) != 0U)
+    return;
+
+  std::error_code error_code;
+  const auto file_bytes = std::filesystem::file_size(result_file_path, error_code);
+  if (error_code || file_bytes > m_budgetBytes)
+    return;
+
+  const auto cache_file_path = getCacheFilePath(cache_key);
+  std::filesystem::create_hard_link(result_file_path, cache_file_path, error_code);
+  if (error_code && !std::filesystem::copy_file(result_file_path, cache_file_path, error_code))
+    return;
+
+  m_lruKeyList.push_front(cache_key);
+  auto &cache_entry = m_entryMap[cache_key];
+  cache_entry.m_fileBytes = file_bytes;
+  cache_entry.m_lruIter = m_lruKeyList.begin();
+  m_totalBytes += file_bytes;
+
+  evictResults();
+}
+
+uint64_t ResultCache::findRunningJob(const std::string &cache_key)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  const auto job_iter = m_runningJobMap.find(cache_key);
+
+  return (job_iter == m_runningJobMap.end()) ? 0U : job_iter->second;
+}
+
+void ResultCache::registerRunningJob(const std::string &cache_key, const uint64_t &job_id)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  m_runningJobMap[cache_key] = job_id;
+}
+
+void ResultCache::finishRunningJob(const std::string &cache_key, const uint64_t &job_id)
+{
+  std::lock_guard<std::mutex> cache_lock(m_mutex);
+  const auto job_iter = m_runningJobMap.find(cache_key);
+  if (job_iter != m_runningJobMap.end() && job_iter->second == job_id)
+    m_runningJobMap.erase(job_iter);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <openssl/evp.h>
+
+namespace ApiServer
+{
+  // Incremental SHA-256 of content (chunks of upload, cache keys)
+  class ContentHasher
+  {
+  private:
+    EVP_MD_CTX *m_ptrDigestContext;
+
+  public:
+    /// @brief constructor
+    ContentHasher();
+
+    /// @brief destructor
+    ~ContentHasher();
+
+    /* forbid copy action */
+    ContentHasher(const ContentHasher &other) = delete;
+    ContentHasher &operator=(const ContentHasher &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief add chunk of content
+    void update(const char *data, const size_t &data_size);
+
+    /// @brief add chunk of content
+    void update(const std::string &data) { update(data.data(), data.size()); }
+
+    /// @brief finish hashing (no update after it)
+    /// @return Lowercase hex digest
+    std::string finishHex();
+  };
+
+  // On-disk LRU cache of video analysis results (key: video content and canonical request json) and running jobs of keys
+  class ResultCache
+  {
+  private:
+    // Cached result file
+    struct CacheEntry
+    {
+      uint64_t m_fileBytes = 0;
+      std::list<std::string>::iterator m_lruIter;
+    };
+
+    std::mutex m_mutex;
+    std::string m_cacheDirPath;
+    uint64_t m_budgetBytes;
+    uint64_t m_totalBytes;
+    std::list<std::string> m_lruKeyList; // front: most recently used
+    std::unordered_map<std::string, CacheEntry> m_entryMap;
+    std::unordered_map<std::string, uint64_t> m_runningJobMap; // key -> access id of job analyzing it
+
+    /// @brief get path of cached result
+    std::string getCacheFilePath(const std::string &cache_key) const;
+
+    /// @brief remove least recently used results until total size fits budget (called with lock)
+    void evictResults();
+
+  public:
+    /// @brief constructor (results left by previous run are loaded, older files are evicted first)
+    /// @param cache_dir_path Directory of cached results (created if not exists)
+    /// @param budget_bytes Total size of cached results
+    ResultCache(const std::string &cache_dir_path, const uint64_t &budget_bytes);
+
+    /* forbid copy action */
+    ResultCache(const ResultCache &other) = delete;
+    ResultCache &operator=(const ResultCache &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief create cache key
+    /// @param video_digest Digest of video content (or identity of local file)
+    /// @param request_json_string Request json (canonicalized: key order and whitespace are ignored)
+    /// @return Key (hex)
+    static std::string createKey(const std::string &video_digest, const std::string &request_json_string);
+
+    /// @brief check cached result (thread-safe)
+    bool containsResult(const std::string &cache_key);
+
+    /// @brief put cached result at path (hard link, copy on other file system) and mark it recently used (thread-safe)
+    /// @param cache_key Key
+    /// @param result_file_path Destination
+    /// @return false if result is not cached
+    bool copyResult(const std::string &cache_key, const std::string &result_file_path);
+
+    /// @brief cache result file (thread-safe)
+    /// @param cache_key Key
+    /// @param result_file_path Result of finished analysis
+    void storeResult(const std::string &cache_key, const std::string &result_file_path);
+
+    /// @brief find job analyzing same video and request (thread-safe)
+    /// @return Access id (0: not found)
+    uint64_t findRunningJob(const std::string &cache_key);
+
+    /// @brief register job analyzing key (thread-safe)
+    void registerRunningJob(const std::string &cache_key, const uint64_t &job_id);
+
+    /// @brief unregister job of key after it finished (thread-safe, newer job of same key is kept)
+    void finishRunningJob(const std::string &cache_key, const uint64_t &job_id);
+  };
+};
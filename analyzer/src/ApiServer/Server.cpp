@@ -1,93 +1,95 @@
 #include "../ApiServer.hpp"
+#include "JobEventHub.hpp"
+#include "ResultCache.hpp"
+#include "UploadedVideoFile.hpp"
+#include "VisualizationRenderer.hpp"
 
+#include <algorithm>
 #include <chrono>
 using namespace std::chrono_literals;
 
 #include <filesystem>
 #include <fstream>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <unordered_map>
 
+#include <cctype>
 #include <cstdio>
 #include <cstdlib>
-#include <errno.h>
-#include <fcntl.h>
-#include <pthread.h>
-#include <signal.h>
-#include <sys/mman.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <unistd.h>
 
-static std::shared_ptr<GCB::BeaconAnalyzer> gptr_beacon_analyzer = nullptr;
+#include <trantor/utils/ConcurrentTaskQueue.h>
 
-struct ProcessState
-{
-  double m_progression = 0.0;
-  uint64_t m_frameCount = 0;
-  bool m_isCompleted = false;
-};
-
-static std::unordered_set<::pid_t> g_video_request_id_set; // key: client_id (base-> analyze_video's process id)
+static std::shared_ptr<GCB::BeaconAnalyzer> gptr_beacon_analyzer = nullptr;
+static std::unique_ptr<GCB::AnalysisSlotPool> gptr_analysis_slot_pool = nullptr; // shared by frames of all video jobs
+static std::unique_ptr<ApiServer::JobScheduler> gptr_job_scheduler = nullptr;
+static std::unique_ptr<ApiServer::JobEventHub> gptr_job_event_hub = nullptr;
+static std::unique_ptr<trantor::ConcurrentTaskQueue> gptr_compute_queue = nullptr; // /analyze_picture (off io threads)
+static int64_t g_max_queued_picture_num = 0;
+static std::filesystem::path g_local_video_root; // canonical (empty: /analyze_local_video is disabled)
+static std::unique_ptr<ApiServer::ResultCache> gptr_result_cache = nullptr; // nullptr: results are not cached
+static std::atomic<uint64_t> g_upload_num(0); // numbers files of uploads (same names never share a file)
+static std::mutex g_uploaded_video_mutex;
+static std::map<uint64_t, std::shared_ptr<ApiServer::UploadedVideoFile>> g_uploaded_video_map; // key: analysis access id
+
+static constexpr size_t MAX_KEPT_UPLOADED_VIDEO_NUM = 32; // videos of recent analyses kept for later visualization
 
 /// @brief create file path
 /// @param base_path Api's directory and base_name
-/// @param pid Process id
+/// @param job_id Access id of job
 /// @param extension File's extension
 /// @return File_path
-static std::string create_process_file_path(
-    const std::string &base_path, const ::pid_t &pid, const std::string &extension)
+static std::string create_job_file_path(
+    const std::string &base_path, const uint64_t &job_id, const std::string &extension)
 {
   std::stringstream file_path_stream;
-  file_path_stream << base_path << pid << extension;
+  file_path_stream << base_path << job_id << extension;
 
   return file_path_stream.str();
 }
 
-/// @brief create mapped memory for connecting another process
-/// @param mapped_file_path Memory mapped file path
-/// @return Reference (pointer) to mapped memory
-static char *create_mapped_memory(const std::string &mapped_file_path, const int32_t &read_write_op)
-{
-  auto mmap_fd = ::open(mapped_file_path.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
-  ::lseek(mmap_fd, sizeof(ProcessState) + 1U, SEEK_SET);
-  (void)::write(mmap_fd, "", 1);
-  ::lseek(mmap_fd, 0, SEEK_SET);
-
-  char *const file_mapped_memory =
-      // reinterpret_cast<char *>(::mmap(0, sizeof(ProcessState), PROT_READ | PROT_WRITE, MAP_SHARED, mmap_fd, 0));
-      reinterpret_cast<char *>(::mmap(0, sizeof(ProcessState), read_write_op, MAP_SHARED, mmap_fd, 0));
-  ::close(mmap_fd);
-
-  return file_mapped_memory;
-}
-
-/// @brief return device_detection_result_list (from json_string)
-/// @param json_string Json format string
-/// @return Vector of device_detection
-static std::vector<GCB::DetectionResult> get_device_detection_list_from_json(const std::string &json_string)
+/// @brief create BGR picture from uploaded bytes
+/// @param image_data Encoded image (jpeg, png, ...) or raw pixels
+/// @param image_format_json {"pixel_format": "encoded" (default) | "bgr" | "nv12", "width", "height"} (size of raw pixels)
+/// @return BGR picture ("bgr" refers to image_data without copy)
+static cv::Mat decode_picture(const std::string_view &image_data, const nlohmann::json &image_format_json)
 {
-  std::vector<GCB::DetectionResult> detection_result_list;
+  const std::string pixel_format = image_format_json.value("pixel_format", "encoded");
+  auto ptr_image_data = const_cast<char *>(image_data.data()); // only read by decoder and analyzer
 
-  const auto json_obj = nlohmann::json::parse(json_string);
-  const std::vector<std::string> device_key_list = json_obj["device_key"];
-
-  for (const auto &device_key : device_key_list)
+  cv::Mat picture;
+  if (pixel_format == "encoded")
+    picture = cv::imdecode(cv::Mat(1, static_cast<int>(image_data.size()), CV_8UC1, ptr_image_data), cv::IMREAD_COLOR);
+  else
   {
-    GCB::DetectionResult detection_result;
-    detection_result.m_deviceName = json_obj[device_key]["device_name"];
-    detection_result.m_deviceId = json_obj[device_key]["device_id"];
-    detection_result.m_positionRect.x = json_obj[device_key]["rect_x"];
-    detection_result.m_positionRect.y = json_obj[device_key]["rect_y"];
-    detection_result.m_positionRect.width = json_obj[device_key]["rect_width"];
-    detection_result.m_positionRect.height = json_obj[device_key]["rect_height"];
-
-    detection_result_list.push_back(detection_result);
+    const int width = image_format_json.at("width");
+    const int height = image_format_json.at("height");
+    if (width <= 0 || height <= 0)
+      throw std::invalid_argument("image size is not valid");
+
+    const auto pixel_num = static_cast<size_t>(width) * static_cast<size_t>(height);
+    if (pixel_format == "bgr")
+    {
+      if (image_data.size() != pixel_num * 3U)
+        throw std::invalid_argument("bgr image must have width * height * 3 bytes");
+      picture = cv::Mat(height, width, CV_8UC3, ptr_image_data);
+    }
+    else if (pixel_format == "nv12")
+    {
+      if (width % 2 != 0 || height % 2 != 0 || image_data.size() != pixel_num * 3U / 2U)
+        throw std::invalid_argument("nv12 image must have even size and width * height * 3 / 2 bytes");
+      cv::cvtColor(cv::Mat(height * 3 / 2, width, CV_8UC1, ptr_image_data), picture, cv::COLOR_YUV2BGR_NV12);
+    }
+    else
+      throw std::invalid_argument("pixel_format is not valid: " + pixel_format);
   }
 
-  return detection_result_list;
+  if (picture.empty())
+    throw std::invalid_argument("image cannot be decoded");
+
+  return picture;
 }
 
 /// @brief analyze beacon on picture (using GCB module)
@@ -97,179 +99,743 @@ static std::vector<GCB::DetectionResult> get_device_detection_list_from_json(con
 static std::string analyze_picture(const cv::Mat &picture, const std::vector<GCB::DetectionResult> &detection_result_list)
 {
   GCB::AnalyzationResultWriter analyzation_result_writer;
+  std::vector<GCB::AnalyzationResult> analyzation_result_list;
+  analyzation_result_list.reserve(detection_result_list.size());
 
   for (const auto &detection_result : detection_result_list)
   {
-    const auto analyzation_result = gptr_beacon_analyzer->analyzePicture(picture, detection_result);
-    analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result);
+    analyzation_result_list.push_back(gptr_beacon_analyzer->analyzePicture(picture, detection_result));
+    analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result_list.back());
+  }
+
+  ApiServer::Metrics::get_counters().m_analyzedPictureNum.fetch_add(1, std::memory_order_relaxed);
+  ApiServer::Metrics::count_analyzation_results(analyzation_result_list);
+
+  return analyzation_result_writer.getJsonString();
+}
+
+/// @brief analyze beacon on pre-cropped device tiles (using GCB module)
+/// @param tile_data Bytes of all tiles
+/// @param request_json Request json, "tile" of device: {"x", "y" (offset in frame), "offset", "size" (in tile_data), image format}
+/// @param detection_result_list Vector of GCB::DetecionResult (rects in frame coordinates)
+/// @return Json String as analyzed picture (same as analyze_picture's one)
+static std::string analyze_picture_tiles(const std::string_view &tile_data, const nlohmann::json &request_json,
+                                         const std::vector<GCB::DetectionResult> &detection_result_list)
+{
+  GCB::AnalyzationResultWriter analyzation_result_writer;
+  std::vector<GCB::AnalyzationResult> analyzation_result_list;
+  analyzation_result_list.reserve(detection_result_list.size());
+
+  const std::vector<std::string> device_key_list = request_json.at("device_key");
+  for (size_t device_idx = 0; device_idx < detection_result_list.size(); device_idx++)
+  {
+    const auto &tile_json = request_json.at(device_key_list[device_idx]).at("tile");
+    const size_t tile_offset = tile_json.at("offset");
+    const size_t tile_size = tile_json.at("size");
+    if (tile_offset > tile_data.size() || tile_size > tile_data.size() - tile_offset)
+      throw std::invalid_argument("tile is out of image_tiles: " + device_key_list[device_idx]);
+    const auto tile_picture = decode_picture(tile_data.substr(tile_offset, tile_size), tile_json);
+
+    // device rect is moved onto tile, result reports it in frame coordinates
+    const auto &detection_result = detection_result_list[device_idx];
+    auto tile_detection_result = detection_result;
+    tile_detection_result.m_positionRect.x -= tile_json.at("x").get<float>();
+    tile_detection_result.m_positionRect.y -= tile_json.at("y").get<float>();
+    const cv::Rect device_rect_on_tile = tile_detection_result.m_positionRect;
+    if ((device_rect_on_tile & cv::Rect(0, 0, tile_picture.cols, tile_picture.rows)) != device_rect_on_tile)
+      throw std::invalid_argument("tile does not contain device rect: " + device_key_list[device_idx]);
+
+    analyzation_result_list.push_back(gptr_beacon_analyzer->analyzePicture(tile_picture, tile_detection_result));
+    analyzation_result_list.back().m_devicePositionRect = detection_result.m_positionRect;
+    analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result_list.back());
   }
 
+  ApiServer::Metrics::get_counters().m_analyzedPictureNum.fetch_add(1, std::memory_order_relaxed);
+  ApiServer::Metrics::count_analyzation_results(analyzation_result_list);
+
   return analyzation_result_writer.getJsonString();
 }
 
-/// @brief analyze beacon on video (using GCB module)
+/// @brief convert analysis results of frame to LED patterns rendered by VisualizationRenderer
+/// @param analyzation_result_list Results of frame
+/// @param device_led_pattern_list LED patterns sorted by device key (output, same order as "device_keys" of result json)
+static void get_device_led_patterns(const std::vector<GCB::AnalyzationResult> &analyzation_result_list,
+                                    std::vector<ApiServer::DeviceLedPattern> &device_led_pattern_list)
+{
+  std::vector<std::pair<std::string, size_t>> device_key_list;
+  device_key_list.reserve(analyzation_result_list.size());
+  for (size_t device_idx = 0; device_idx < analyzation_result_list.size(); device_idx++)
+  {
+    const auto &analyzation_result = analyzation_result_list[device_idx];
+    device_key_list.emplace_back(analyzation_result.m_deviceName + std::to_string(analyzation_result.m_deviceId), device_idx);
+  }
+  std::sort(device_key_list.begin(), device_key_list.end());
+
+  device_led_pattern_list.resize(device_key_list.size());
+  for (size_t device_idx = 0; device_idx < device_key_list.size(); device_idx++)
+  {
+    const auto &analyzation_result = analyzation_result_list[device_key_list[device_idx].second];
+    device_led_pattern_list[device_idx].m_deviceName = analyzation_result.m_deviceName;
+    device_led_pattern_list[device_idx].m_ledPatternList = analyzation_result.m_ledPatternList;
+  }
+}
+
+/// @brief write timing record of analysis job (sent by /analysis_timing)
+/// @param job_id Access id of analysis job
+/// @param video_analysis_statistics Statistics of analysis (stage histograms are filled when built with GCB_STAGE_TIMING)
+/// @param worker_num Number of worker threads of analysis (0: result served from cache)
+/// @param is_cache_hit Result is copied from cache (timings are zero)
+static void write_timing_record(const uint64_t &job_id, const GCB::VideoAnalysisStatistics &video_analysis_statistics,
+                                const uint32_t &worker_num, const bool &is_cache_hit)
+{
+  nlohmann::json timing_json;
+  timing_json["frame_num"] = video_analysis_statistics.m_frameNum;
+  timing_json["worker_num"] = worker_num;
+  timing_json["elapsed_s"] = video_analysis_statistics.m_elapsedSeconds;
+  timing_json["decode_s"] = video_analysis_statistics.m_decodeSeconds;
+  timing_json["analysis_s"] = video_analysis_statistics.m_analysisSeconds;
+  timing_json["cache_hit"] = is_cache_hit;
+  timing_json["stage_timing_enabled"] = GCB::STAGE_TIMING_ENABLED;
+  timing_json["stage_timing"] = video_analysis_statistics.m_stageTimingProfile.getJson();
+
+  std::ofstream timing_ofs(create_job_file_path("../data/analyze/timing_", job_id, ".json"));
+  timing_ofs << timing_json.dump();
+}
+
+/// @brief analyze beacon on video (using GCB module, runs as job)
+/// @param job Job reporting progression (linked job: visualization is rendered from analyzed frames in same pass)
 /// @param video_file_path Analyzed video path
+/// @param ptr_uploaded_video Video being uploaded to video_file_path (nullptr: video file is complete)
 /// @param detection_result_list Vector of GCB::DetecionResult
-static void analyze_video(const std::string &video_file_path, const std::vector<GCB::DetectionResult> &detection_result_list)
+/// @return true if result covers whole video (frames of complete file are all analyzed), only such result is cached
+static bool analyze_video(ApiServer::Job &job, const std::string &video_file_path,
+                          const std::shared_ptr<ApiServer::UploadedVideoFile> &ptr_uploaded_video,
+                          const std::vector<GCB::DetectionResult> &detection_result_list)
 {
-  const auto pid = ::getpid();
-  const std::string mmap_file_path = create_process_file_path("../data/memory_map/analyze", pid, ".dat");
-  const auto file_mapped_memory = create_mapped_memory(mmap_file_path, PROT_WRITE);
+  const auto &job_id = job.m_jobId;
 
-  cv::VideoCapture video_cap(video_file_path);
-  const auto video_frame_number = video_cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_COUNT);
+  // video still uploading is decoded from FIFO while it grows (needs streamable container: fragmented MP4, MPEG-TS)
+  std::unique_ptr<ApiServer::UploadedVideoFeeder> ptr_video_feeder = nullptr;
+  if (ptr_uploaded_video != nullptr && !ptr_uploaded_video->isFinished())
+    ptr_video_feeder = std::make_unique<ApiServer::UploadedVideoFeeder>(*ptr_uploaded_video);
+
+  cv::VideoCapture video_cap((ptr_video_feeder != nullptr) ? ptr_video_feeder->getFifoPath() : video_file_path);
+  if (!video_cap.isOpened())
+    throw std::runtime_error("Video Open Error: " + video_file_path);
+  const auto frame_num = static_cast<uint64_t>(std::max(0.0, video_cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_COUNT)));
+  job.setFrameNum(frame_num);
 
+  // frames are decoded by decoder thread, analyzed in parallel, and merged here in frame order
+  auto &server_counters = ApiServer::Metrics::get_counters();
   GCB::AnalyzationResultWriter analyzation_result_writer;
-  uint64_t frame_count = 0;
-  while (true)
+  const auto write_frame_result = [&](const uint64_t &frame_idx, const std::vector<GCB::AnalyzationResult> &analyzation_result_list)
+  {
+    for (const auto &analyzation_result : analyzation_result_list)
+      analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result, frame_idx);
+    server_counters.m_analyzedFrameNum.fetch_add(1, std::memory_order_relaxed);
+    ApiServer::Metrics::count_analyzation_results(analyzation_result_list);
+    job.setFrameCount(frame_idx + 1U);
+  };
+
+  // each frame holds a slot of shared pool, running videos interleave frame by frame
+  const GCB::VideoAnalyzer video_analyzer(*gptr_beacon_analyzer, 0, gptr_analysis_slot_pool.get());
+  GCB::VideoAnalysisStatistics video_analysis_statistics;
+  std::string visualization_error_message;
+  if (job.m_ptrLinkedJob == nullptr)
+    video_analysis_statistics = video_analyzer.analyzeVideo(video_cap, detection_result_list, write_frame_result);
+  else
   {
-    cv::Mat frame;
-    if (!video_cap.read(frame))
-      break;
+    // visualization is rendered from merged frames (video is decoded once), reported by linked job
+    auto &visualization_job = *job.m_ptrLinkedJob;
+    visualization_job.setFrameNum(frame_num);
+
+    const auto visualization_file_path = create_job_file_path("../data/visualize/result_", visualization_job.m_jobId, ".mp4");
+    cv::VideoWriter video_writer;
+    video_writer.open(
+        visualization_file_path,
+        cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+        static_cast<int32_t>(video_cap.get(cv::VideoCaptureProperties::CAP_PROP_FPS)),
+        cv::Size(ApiServer::VisualizationRenderer::CANVAS_WIDTH, ApiServer::VisualizationRenderer::CANVAS_HEIGHT));
+
+    ApiServer::VisualizationRenderer visualization_renderer(gptr_beacon_analyzer->getDeviceDefinitions());
+    std::vector<ApiServer::DeviceLedPattern> device_led_pattern_list;
+    // merge callback must not throw while workers run, rendering failure does not stop analysis
+    std::string render_error_message;
+    if (!video_writer.isOpened())
+      render_error_message = "Video Writer Open Error: " + visualization_file_path;
+    video_analysis_statistics = video_analyzer.analyzeVideo(
+        video_cap, detection_result_list,
+        [&](const uint64_t &frame_idx, const cv::Mat &frame, const std::vector<GCB::AnalyzationResult> &analyzation_result_list)
+        {
+          write_frame_result(frame_idx, analyzation_result_list);
+          if (!render_error_message.empty())
+            return;
+
+          try
+          {
+            get_device_led_patterns(analyzation_result_list, device_led_pattern_list);
+            if (visualization_renderer.renderFrame(frame, device_led_pattern_list))
+            {
+              const auto encode_begin = std::chrono::steady_clock::now();
+              video_writer.write(visualization_renderer.getCanvas());
+              server_counters.m_encodeNanoseconds.fetch_add(
+                  static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                            std::chrono::steady_clock::now() - encode_begin)
+                                            .count()),
+                  std::memory_order_relaxed);
+              server_counters.m_encodedFrameNum.fetch_add(1, std::memory_order_relaxed);
+            }
+          }
+          catch (const std::exception &exception)
+          {
+            render_error_message = exception.what();
+          }
+          visualization_job.setFrameCount(frame_idx + 1U);
+        });
+    video_writer.release();
+    // only linked job fails (set after analysis result is written)
+    if (!render_error_message.empty())
+      visualization_error_message = "Visualization Error: " + render_error_message;
+  }
+  if (ptr_uploaded_video != nullptr && ptr_uploaded_video->isFailed())
+    throw std::runtime_error("Video Upload Error: " + video_file_path);
 
-    for (const auto &detection_result : detection_result_list)
-    {
-      const auto analyzation_result = gptr_beacon_analyzer->analyzePicture(frame, detection_result);
-      analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result, frame_count);
-    }
+  const auto &frame_count = video_analysis_statistics.m_frameNum;
+  ApiServer::Metrics::add_video_analysis_statistics(video_analysis_statistics);
 
-    ProcessState analyzation_state;
-    analyzation_state.m_progression = static_cast<double>(frame_count) / video_frame_number;
-    analyzation_state.m_frameCount = frame_count;
-    std::memcpy(file_mapped_memory, reinterpret_cast<char *>(&analyzation_state), sizeof(ProcessState));
+  std::cout << "analyzed " << frame_count << " frames in " << video_analysis_statistics.m_elapsedSeconds << " s"
+            << " (decode: " << video_analysis_statistics.m_decodeSeconds << " s"
+            << ", analysis: " << video_analysis_statistics.m_analysisSeconds << " s on "
+            << video_analyzer.getWorkerNum() << " workers)" << std::endl;
+  if (GCB::AllocationCounter::is_enabled())
+    std::cout << "allocations in steady state (workers, after first frame): "
+              << video_analysis_statistics.m_steadyAllocationNum << ", on " << video_analysis_statistics.m_trackedFrameNum
+              << " tracked frames: " << video_analysis_statistics.m_trackedAllocationNum << std::endl;
 
-    frame_count++;
+  analyzation_result_writer.outputJson(
+      create_job_file_path("../data/analyze/result_", job_id, ".json"), frame_count);
+
+  // completion record of job
+  write_timing_record(job_id, video_analysis_statistics, video_analyzer.getWorkerNum(), false);
+
+  if (!visualization_error_message.empty())
+  {
+    std::cout << "job " << job.m_ptrLinkedJob->m_jobId << " failed: " << visualization_error_message << std::endl;
+    job.m_ptrLinkedJob->m_errorMessage = visualization_error_message;
   }
 
-  analyzation_result_writer.outputJson(
-      create_process_file_path("../data/analyze/result_", pid, ".json"), frame_count);
-
-  ProcessState analyzation_state;
-  analyzation_state.m_isCompleted = true;
-  analyzation_state.m_progression = 1.0;
-  analyzation_state.m_frameCount = frame_count;
-  std::memcpy(file_mapped_memory, &analyzation_state, sizeof(ProcessState));
-  ::munmap(file_mapped_memory, sizeof(ProcessState));
+  // video decoded while uploading has no frame count, it is read from complete file
+  auto expected_frame_num = frame_num;
+  if (expected_frame_num == 0U && ptr_uploaded_video != nullptr && ptr_uploaded_video->isFinished())
+  {
+    cv::VideoCapture complete_video_cap(video_file_path);
+    expected_frame_num =
+        static_cast<uint64_t>(std::max(0.0, complete_video_cap.get(cv::VideoCaptureProperties::CAP_PROP_FRAME_COUNT)));
+  }
+  const bool is_upload_complete =
+      (ptr_uploaded_video == nullptr) || (ptr_uploaded_video->isFinished() && !ptr_uploaded_video->isFailed());
+
+  return is_upload_complete && expected_frame_num > 0U && frame_count == expected_frame_num;
 }
 
-/// @brief create visualization video of analyzation_result
+/// @brief load analyzation result json into LED patterns of frames (json is parsed once, then released)
 /// @param analyzation_json_path Video analyzation result json file path
-/// @param video_file_path Analyzed Video file path
-static void visualize_analyzation_result(const std::string &analyzation_json_path, const std::string &video_file_path)
+/// @return LED patterns of devices (index: frame count, devices are sorted by device key)
+static std::vector<std::vector<ApiServer::DeviceLedPattern>> load_device_led_patterns(const std::string &analyzation_json_path)
 {
-  const auto pid = ::getpid();
-  const std::string mmap_file_path = create_process_file_path("../data/memory_map/visualize", pid, ".dat");
-  const auto file_mapped_memory = create_mapped_memory(mmap_file_path, PROT_WRITE);
-
   std::ifstream json_ifs(analyzation_json_path);
-
   if (json_ifs.fail())
+    throw std::runtime_error("File Open Error: " + analyzation_json_path);
+  const auto json_obj = nlohmann::json::parse(json_ifs);
+
+  const uint64_t frame_num = json_obj.at("frame_num");
+  std::vector<std::vector<ApiServer::DeviceLedPattern>> frame_led_pattern_list(frame_num);
+  for (uint64_t frame_count = 0; frame_count < frame_num; frame_count++)
   {
-    std::cout << "File Open Error" << std::endl;
-    return;
-  }
+    const auto frame_iter = json_obj.find("Frame" + std::to_string(frame_count));
+    if (frame_iter == json_obj.end())
+      continue; // no device
 
-  std::string json_str, line;
-  while (std::getline(json_ifs, line))
-    json_str.append(line);
+    // keys of json object are sorted
+    auto &device_led_pattern_list = frame_led_pattern_list[frame_count];
+    for (const auto &device_key_item : frame_iter->at("device_keys").items())
+    {
+      const auto &device_obj = frame_iter->at(device_key_item.key());
+      const auto &beacon_obj = device_obj.at("beacon");
+
+      ApiServer::DeviceLedPattern device_led_pattern;
+      device_led_pattern.m_deviceName = device_obj.at("device_name").get<std::string>();
+      device_led_pattern.m_ledPatternList.resize(beacon_obj.size());
+      for (size_t led_idx = 0; led_idx < beacon_obj.size(); led_idx++)
+        device_led_pattern.m_ledPatternList[led_idx] = beacon_obj.at("ID" + std::to_string(led_idx + 1U)).get<uint8_t>();
+      device_led_pattern_list.push_back(std::move(device_led_pattern));
+    }
+  }
 
-  const auto json_obj = nlohmann::json::parse(json_str);
+  return frame_led_pattern_list;
+}
 
-  const auto &device_definitions = gptr_beacon_analyzer->getDeviceDefinitions();
-  const uint64_t frame_num = json_obj["frame_num"];
+/// @brief create visualization video of analyzation_result (runs as job)
+/// @param job Job reporting progression
+/// @param analyzation_json_path Video analyzation result json file path
+/// @param video_file_path Analyzed Video file path
+static void visualize_analyzation_result(ApiServer::Job &job, const std::string &analyzation_json_path,
+                                         const std::string &video_file_path)
+{
+  const auto &job_id = job.m_jobId;
+  auto frame_led_pattern_list = load_device_led_patterns(analyzation_json_path);
+  const uint64_t frame_num = frame_led_pattern_list.size();
+  job.setFrameNum(frame_num);
 
   cv::VideoCapture video_cap(video_file_path);
   const auto video_fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
   const auto video_fps = static_cast<int32_t>(video_cap.get(cv::VideoCaptureProperties::CAP_PROP_FPS));
 
+  const auto visualization_file_path = create_job_file_path("../data/visualize/result_", job_id, ".mp4");
   cv::VideoWriter video_writer;
   video_writer.open(
-      create_process_file_path("../data/visualize/result_", pid, ".mp4"),
-      video_fourcc, video_fps, cv::Size(1500, 1000));
+      visualization_file_path, video_fourcc, video_fps,
+      cv::Size(ApiServer::VisualizationRenderer::CANVAS_WIDTH, ApiServer::VisualizationRenderer::CANVAS_HEIGHT));
+  if (!video_writer.isOpened())
+    throw std::runtime_error("Video Writer Open Error: " + visualization_file_path);
+
+  // decoder thread reads next frames while this loop draws and encodes
+  GCB::FrameDecoder frame_decoder(video_cap, 4U);
+  GCB::FrameDecoder::DecodedFrame decoded_frame;
+  ApiServer::VisualizationRenderer visualization_renderer(gptr_beacon_analyzer->getDeviceDefinitions());
 
+  auto &server_counters = ApiServer::Metrics::get_counters();
   uint64_t frame_count = 0;
-  while (true)
+  while (frame_count < frame_num && frame_decoder.acquireFrame(decoded_frame))
   {
-    if (frame_count >= frame_num)
-      break;
+    if (visualization_renderer.renderFrame(decoded_frame.m_image, frame_led_pattern_list[frame_count]))
+    {
+      const auto encode_begin = std::chrono::steady_clock::now();
+      video_writer.write(visualization_renderer.getCanvas());
+      server_counters.m_encodeNanoseconds.fetch_add(
+          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now() - encode_begin)
+                                    .count()),
+          std::memory_order_relaxed);
+      server_counters.m_encodedFrameNum.fetch_add(1, std::memory_order_relaxed);
+    }
+    frame_decoder.releaseFrame(decoded_frame);
+    std::vector<ApiServer::DeviceLedPattern>().swap(frame_led_pattern_list[frame_count]); // rendered
 
-    cv::Mat frame, visualized_img;
-    if (!video_cap.read(frame))
-      break;
+    frame_count++;
+    job.setFrameCount(frame_count);
+  }
+  video_writer.release();
 
-    const auto frame_obj = json_obj["Frame" + std::to_string(frame_count)];
-    std::map<std::string, std::string> device_keys_map = frame_obj["device_keys"];
-    std::vector<std::string> device_keys;
-    for (const auto &[device_key, _] : device_keys_map)
-      device_keys.push_back(device_key);
-    std::sort(device_keys.begin(), device_keys.end());
+  std::cout << "visualized " << frame_count << " frames (decode: " << frame_decoder.getDecodeSeconds() << " s)" << std::endl;
+  server_counters.m_decodedFrameNum.fetch_add(frame_count, std::memory_order_relaxed);
+  server_counters.m_decodeNanoseconds.fetch_add(
+      static_cast<uint64_t>(frame_decoder.getDecodeSeconds() * 1e9), std::memory_order_relaxed);
+}
 
-    for (const auto &device_key : device_keys)
+/// @brief resolve path of video analyzed in place (symbolic links and ".." are resolved before check)
+/// @param video_path Path relative to local video root (or absolute path under it)
+/// @return Canonical path of regular file under root (empty if it is outside root or not found)
+static std::filesystem::path resolve_local_video_path(const std::string &video_path)
+{
+  std::error_code error_code;
+  const auto video_file_path = std::filesystem::canonical(g_local_video_root / video_path, error_code);
+  if (error_code || !std::filesystem::is_regular_file(video_file_path, error_code))
+    return std::filesystem::path();
+
+  const auto relative_path = video_file_path.lexically_relative(g_local_video_root);
+  if (relative_path.empty() || *relative_path.begin() == "..")
+    return std::filesystem::path();
+
+  return video_file_path;
+}
+
+/// @brief get identity of video analyzed in place (path, size and modification time, content is not hashed)
+/// @param video_file_path Canonical path of local video
+/// @return Identity used as digest of cache key (empty if file is not readable)
+static std::string get_local_video_identity(const std::string &video_file_path)
+{
+  std::error_code error_code;
+  const auto file_size = std::filesystem::file_size(video_file_path, error_code);
+  if (error_code)
+    return std::string();
+  const auto last_write_time = std::filesystem::last_write_time(video_file_path, error_code);
+  if (error_code)
+    return std::string();
+
+  return "local:" + video_file_path + ":" + std::to_string(file_size) + ":" +
+         std::to_string(last_write_time.time_since_epoch().count());
+}
+
+// State of /analyze_pictures request shared by its frame tasks
+struct PictureBatchContext
+{
+  std::shared_ptr<drogon::MultiPartParser> m_ptrUploadedFile; // frames refer to its parts
+  std::vector<std::string_view> m_frameDataList;
+  nlohmann::json m_imageFormatJson;
+  std::vector<GCB::DetectionResult> m_detectionResultList; // parsed once for all frames
+  std::vector<std::vector<GCB::AnalyzationResult>> m_frameResultList; // index: frame
+  std::atomic<size_t> m_remainingFrameNum{0};
+  std::mutex m_errorMutex;
+  std::string m_errorMessage; // first error of frames
+  std::function<void(const drogon::HttpResponsePtr &)> m_callback;
+};
+
+/// @brief split uploaded frames of batch ("image_stream": concatenated raw frames, otherwise: one part per frame)
+/// @param batch_context Batch whose uploaded file and image format are set
+static void split_picture_batch(PictureBatchContext &batch_context)
+{
+  const auto &files_map = batch_context.m_ptrUploadedFile->getFilesMap();
+  if (const auto stream_file_iter = files_map.find("image_stream"); stream_file_iter != files_map.end())
+  {
+    const auto &image_format_json = batch_context.m_imageFormatJson;
+    const std::string pixel_format = image_format_json.value("pixel_format", "encoded");
+    if (pixel_format != "bgr" && pixel_format != "nv12")
+      throw std::invalid_argument("image_stream needs bgr or nv12 image_format");
+
+    const auto pixel_num = image_format_json.at("width").get<size_t>() * image_format_json.at("height").get<size_t>();
+    const auto frame_size = (pixel_format == "bgr") ? pixel_num * 3U : pixel_num * 3U / 2U;
+    const auto stream_data = stream_file_iter->second.fileContent();
+    if (frame_size == 0U || stream_data.size() % frame_size != 0U)
+      throw std::invalid_argument("image_stream is not a sequence of whole frames");
+
+    for (size_t frame_offset = 0; frame_offset < stream_data.size(); frame_offset += frame_size)
+      batch_context.m_frameDataList.push_back(stream_data.substr(frame_offset, frame_size));
+  }
+  else
+  {
+    for (const auto &uploaded_part : batch_context.m_ptrUploadedFile->getFiles())
+      if (uploaded_part.getItemName() != "request_json")
+        batch_context.m_frameDataList.push_back(uploaded_part.fileContent());
+  }
+
+  if (batch_context.m_frameDataList.empty())
+    throw std::invalid_argument("no frame is uploaded");
+}
+
+/// @brief send response of finished batch (called by its last frame task)
+/// @param batch_context Batch
+static void finish_picture_batch(PictureBatchContext &batch_context)
+{
+  auto response = drogon::HttpResponse::newHttpResponse();
+  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+  if (!batch_context.m_errorMessage.empty())
+  {
+    response->setStatusCode(drogon::k400BadRequest);
+    response->setBody(nlohmann::json({{"error", batch_context.m_errorMessage}}).dump());
+  }
+  else
+  {
+    // same layout as result of video ("FrameN", "frame_num")
+    GCB::AnalyzationResultWriter analyzation_result_writer;
+    for (size_t frame_idx = 0; frame_idx < batch_context.m_frameResultList.size(); frame_idx++)
+      for (const auto &analyzation_result : batch_context.m_frameResultList[frame_idx])
+        analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result, frame_idx);
+    response->setBody(analyzation_result_writer.getJsonString(batch_context.m_frameResultList.size()));
+  }
+
+  ApiServer::Metrics::get_counters().m_queuedPictureNum.fetch_sub(1, std::memory_order_relaxed);
+  batch_context.m_callback(response);
+}
+
+/// @brief analyze one frame of batch (runs on compute pool, frames of batch run in parallel)
+/// @param ptr_batch_context Batch
+/// @param frame_idx Index of frame
+static void analyze_batch_frame(const std::shared_ptr<PictureBatchContext> &ptr_batch_context, const size_t &frame_idx)
+{
+  auto &batch_context = *ptr_batch_context;
+  try
+  {
+    const auto picture = decode_picture(batch_context.m_frameDataList[frame_idx], batch_context.m_imageFormatJson);
+
+    // buffers of compute thread are reused by its next frames (warped images are not cloned)
+    thread_local GCB::AnalyzerWorkspace workspace;
+    auto &analyzation_result_list = batch_context.m_frameResultList[frame_idx];
+    analyzation_result_list.resize(batch_context.m_detectionResultList.size());
+    for (size_t device_idx = 0; device_idx < analyzation_result_list.size(); device_idx++)
     {
-      const auto device_obj = frame_obj[device_key];
-      const std::string device_name = device_obj["device_name"];
-      const auto &beacon_device = device_definitions.at(device_name);
-      cv::Mat view_img = cv::Mat::zeros(beacon_device.m_deviceTemplateSize, CV_8UC3);
+      GCB::TrackingState tracking_state; // frames of batch are independent pictures
+      gptr_beacon_analyzer->analyzePicture(picture, batch_context.m_detectionResultList[device_idx], tracking_state,
+                                           workspace, analyzation_result_list[device_idx]);
+      analyzation_result_list[device_idx].m_analyzedPictureResult.release(); // refers to workspace
+    }
 
-      if (view_img.size() == cv::Size())
-      {
-        std::cout << device_key + "'s result is None" << std::endl;
-        continue;
-      }
+    ApiServer::Metrics::get_counters().m_analyzedPictureNum.fetch_add(1, std::memory_order_relaxed);
+    ApiServer::Metrics::count_analyzation_results(analyzation_result_list);
+  }
+  catch (const std::exception &exception)
+  {
+    std::lock_guard<std::mutex> error_lock(batch_context.m_errorMutex);
+    if (batch_context.m_errorMessage.empty())
+      batch_context.m_errorMessage = "Frame" + std::to_string(frame_idx) + ": " + exception.what();
+  }
+
+  // acq_rel: last task sees results of all frames
+  if (batch_context.m_remainingFrameNum.fetch_sub(1, std::memory_order_acq_rel) == 1U)
+    finish_picture_batch(batch_context);
+}
 
-      for (const auto &[_, marker] : beacon_device.m_markerHash)
+/// @brief queue visualization job of completed analysis
+/// @param analysis_job_id Access id of completed analysis
+/// @param video_file_path Analyzed video path
+/// @param ptr_uploaded_video Uploaded video at video_file_path, kept until job finishes (nullptr: local video)
+/// @return Access id of job (0: job queue is full)
+static uint64_t submit_visualization_job(const uint64_t &analysis_job_id, const std::string &video_file_path,
+                                         const std::shared_ptr<ApiServer::UploadedVideoFile> &ptr_uploaded_video)
+{
+  return gptr_job_scheduler->submitJob(
+      ApiServer::Metrics::JobKind::VISUALIZE,
+      [analysis_job_id, video_file_path, ptr_uploaded_video](ApiServer::Job &job)
       {
-        cv::Scalar marker_color;
+        visualize_analyzation_result(
+            job, create_job_file_path("../data/analyze/result_", analysis_job_id, ".json"), video_file_path);
+      });
+}
+
+/// @brief find analysis of same video and request (cached result or running job)
+/// @param cache_key Key of video and request (empty: unknown)
+/// @param is_running_job_shared Running job of same key answers request
+/// @return Access id answering request (0: not found, analysis is needed)
+static uint64_t find_analysis_result(const std::string &cache_key, const bool &is_running_job_shared)
+{
+  if (gptr_result_cache == nullptr || cache_key.empty())
+    return 0U;
+
+  // identical request while job runs shares its access id
+  const auto running_job_id = is_running_job_shared ? gptr_result_cache->findRunningJob(cache_key) : 0U;
+  ApiServer::JobStatusTable::JobStatus job_status;
+  if (running_job_id != 0U && gptr_job_scheduler->readJobStatus(running_job_id, job_status) &&
+      job_status.m_state != ApiServer::JobState::FAILED)
+  {
+    ApiServer::Metrics::get_counters().m_coalescedJobNum.fetch_add(1, std::memory_order_relaxed);
+    return running_job_id;
+  }
+
+  if (!gptr_result_cache->containsResult(cache_key))
+    return 0U;
 
-        if (marker.m_color == "blue")
-          marker_color[0] = 255;
-        else
-          marker_color[1] = 255;
-        cv::circle(view_img, marker.m_position, static_cast<int32_t>(marker.m_radius), marker_color, -1);
-      }
+  // cached result is served as result of new completed job (same api as analyzed one)
+  const auto job_id = gptr_job_scheduler->registerCompletedJob(ApiServer::Metrics::JobKind::ANALYZE);
+  if (job_id == 0U)
+    return 0U;
+  const auto result_file_path = create_job_file_path("../data/analyze/result_", job_id, ".json");
+  if (!gptr_result_cache->copyResult(cache_key, result_file_path))
+  {
+    gptr_job_scheduler->eraseJob(job_id);
+    return 0U; // evicted meanwhile
+  }
 
-      for (const auto &[beacon_id, beacon] : beacon_device.m_beaconHash)
+  // same record as analyzed job, nothing is measured (frame_num of cached result)
+  std::ifstream result_ifs(result_file_path);
+  const auto result_json = nlohmann::json::parse(result_ifs, nullptr, false);
+  GCB::VideoAnalysisStatistics cached_analysis_statistics;
+  if (result_json.is_object())
+    cached_analysis_statistics.m_frameNum = result_json.value("frame_num", uint64_t(0));
+  write_timing_record(job_id, cached_analysis_statistics, 0U, true);
+
+  ApiServer::Metrics::get_counters().m_resultCacheHitNum.fetch_add(1, std::memory_order_relaxed);
+  return job_id;
+}
+
+/// @brief queue analysis job of video, its result is cached
+/// @param video_file_path Analyzed video path
+/// @param ptr_uploaded_video Video being uploaded to video_file_path (nullptr: video file is complete)
+/// @param request_json_string Request json
+/// @param cache_key Key of video and request (empty: created from digest of uploaded video after analysis)
+/// @param is_visualized Visualization is rendered in same pass (linked job)
+/// @param visualization_job_id Access id of linked visualization job (output)
+/// @return Access id of job (0: job queue is full)
+static uint64_t submit_analysis_job(const std::string &video_file_path,
+                                   const std::shared_ptr<ApiServer::UploadedVideoFile> &ptr_uploaded_video,
+                                   const std::string &request_json_string, const std::string &cache_key,
+                                   const bool &is_visualized, uint64_t &visualization_job_id)
+{
+  auto detection_result_list = GCB::get_detection_result_list_from_json(request_json_string);
+  std::function<void(ApiServer::Job &)> job_function =
+      [video_file_path, ptr_uploaded_video, request_json_string, cache_key,
+       detection_result_list = std::move(detection_result_list)](ApiServer::Job &job)
       {
-        const uint8_t beacon_pattern = device_obj["beacon"][beacon_id];
+        bool is_result_complete = false;
+        try
+        {
+          is_result_complete = analyze_video(job, video_file_path, ptr_uploaded_video, detection_result_list);
+        }
+        catch (...)
+        {
+          if (gptr_result_cache != nullptr && !cache_key.empty())
+            gptr_result_cache->finishRunningJob(cache_key, job.m_jobId);
+          throw;
+        }
+        if (gptr_result_cache == nullptr)
+          return;
+
+        // partial result (frames missing, interrupted upload) must not answer later requests
+        // local file may be rewritten while analyzed (result belongs to neither version)
+        auto result_cache_key = cache_key;
+        if (!is_result_complete)
+          result_cache_key.clear();
+        else if (ptr_uploaded_video == nullptr && !cache_key.empty() &&
+                 ApiServer::ResultCache::createKey(get_local_video_identity(video_file_path), request_json_string) != cache_key)
+          result_cache_key.clear();
+        else if (result_cache_key.empty() && ptr_uploaded_video != nullptr && !ptr_uploaded_video->getContentDigest().empty())
+          result_cache_key = ApiServer::ResultCache::createKey(ptr_uploaded_video->getContentDigest(), request_json_string);
+
+        // stored before running job is unregistered (identical request finds one of both)
+        if (!result_cache_key.empty())
+          gptr_result_cache->storeResult(result_cache_key, create_job_file_path("../data/analyze/result_", job.m_jobId, ".json"));
+        if (!cache_key.empty())
+          gptr_result_cache->finishRunningJob(cache_key, job.m_jobId);
+      };
+
+  visualization_job_id = 0U;
+  const auto job_id = is_visualized
+                          ? gptr_job_scheduler->submitLinkedJobs(ApiServer::Metrics::JobKind::ANALYZE,
+                                                                 ApiServer::Metrics::JobKind::VISUALIZE,
+                                                                 std::move(job_function), visualization_job_id)
+                          : gptr_job_scheduler->submitJob(ApiServer::Metrics::JobKind::ANALYZE, std::move(job_function));
+  // uploads are never overwritten (unique files), local file may change before job reads it: not shared
+  if (job_id != 0U && gptr_result_cache != nullptr && !cache_key.empty() && ptr_uploaded_video != nullptr)
+    gptr_result_cache->registerRunningJob(cache_key, job_id);
+
+  return job_id;
+}
 
-        cv::circle(view_img, beacon.m_position, static_cast<int32_t>(beacon.m_radius),
-                   cv::Scalar(0, 0, (255 / 32) * beacon_pattern), -1);
-      }
+/// @brief answer video analysis request by cached result, running job or new job
+/// @param video_file_path Analyzed video path
+/// @param ptr_uploaded_video Video being uploaded to video_file_path (nullptr: video file is complete)
+/// @param request_json_string Request json
+/// @param cache_key Key of video and request (empty: unknown), must be empty for visualized video still uploading
+/// @param is_visualized Visualization is requested (rendered in analysis pass, or from cached result)
+/// @param visualization_job_id Access id of visualization job (output, 0: not requested or job queue is full)
+/// @return Access id of analysis (0: job queue is full)
+static uint64_t request_video_analysis(const std::string &video_file_path,
+                                       const std::shared_ptr<ApiServer::UploadedVideoFile> &ptr_uploaded_video,
+                                       const std::string &request_json_string, const std::string &cache_key,
+                                       const bool &is_visualized, uint64_t &visualization_job_id)
+{
+  // running job without visualization cannot render it, only cached result is shared
+  // running job of local file is not shared either (file may be rewritten while it runs)
+  visualization_job_id = 0U;
+  const auto job_id = find_analysis_result(cache_key, !is_visualized && ptr_uploaded_video != nullptr);
+  if (job_id == 0U)
+    return submit_analysis_job(video_file_path, ptr_uploaded_video, request_json_string, cache_key,
+                               is_visualized, visualization_job_id);
+
+  if (is_visualized)
+    visualization_job_id = submit_visualization_job(job_id, video_file_path, ptr_uploaded_video);
+  return job_id;
+}
 
-      const auto img_high_ratio = 500.0 / view_img.size().height;
-      cv::resize(view_img, view_img, cv::Size(), img_high_ratio, img_high_ratio);
+/// @brief keep uploaded video for visualization requested after analysis (file of oldest one is removed when unused)
+/// @param analysis_job_id Access id of analysis
+/// @param ptr_uploaded_video Analyzed video
+static void keep_uploaded_video(const uint64_t &analysis_job_id,
+                                const std::shared_ptr<ApiServer::UploadedVideoFile> &ptr_uploaded_video)
+{
+  std::lock_guard<std::mutex> uploaded_video_lock(g_uploaded_video_mutex);
+  g_uploaded_video_map[analysis_job_id] = ptr_uploaded_video;
+  if (g_uploaded_video_map.size() > MAX_KEPT_UPLOADED_VIDEO_NUM)
+    g_uploaded_video_map.erase(g_uploaded_video_map.begin()); // access ids increase
+}
 
-      if (visualized_img.empty())
-        visualized_img = view_img.clone();
-      else
-        cv::hconcat(std::vector{visualized_img, view_img}, visualized_img);
-    }
+/// @brief find uploaded video analyzed by job
+/// @param analysis_job_id Access id of analysis
+/// @return Uploaded video (nullptr: not kept)
+static std::shared_ptr<ApiServer::UploadedVideoFile> find_uploaded_video(const uint64_t &analysis_job_id)
+{
+  std::lock_guard<std::mutex> uploaded_video_lock(g_uploaded_video_mutex);
+  const auto uploaded_video_iter = g_uploaded_video_map.find(analysis_job_id);
+  return (uploaded_video_iter != g_uploaded_video_map.end()) ? uploaded_video_iter->second : nullptr;
+}
 
-    if (!visualized_img.empty())
-    {
-      const auto img_wid_ratio = static_cast<double>(visualized_img.size().width) / frame.size().width;
-      cv::resize(frame, frame, cv::Size(), img_wid_ratio, img_wid_ratio);
-      cv::vconcat(std::vector{visualized_img, frame}, visualized_img);
+// State of /analyze_video request (body parts arrive in chunks on io thread)
+struct VideoUploadContext
+{
+  std::string m_videoFilePath;
+  std::string m_partName; // multipart field being received
+  std::string m_requestJsonString;
+  bool m_isRequestJsonReceived = false;
+  std::string m_declaredVideoDigest; // X-Video-SHA256 header (empty: not declared)
+  std::shared_ptr<ApiServer::UploadedVideoFile> m_ptrUploadedVideo = nullptr;
+  bool m_isVisualized = false; // visualization is rendered in analysis pass
+  bool m_isOverlapped = false; // analysis starts while video is uploading (streamable container only)
+  bool m_isJobSubmitted = false;
+  uint64_t m_jobId = 0;
+  uint64_t m_visualizationJobId = 0;
+  std::string m_errorMessage;
+};
 
-      cv::resize(visualized_img, visualized_img, cv::Size(1500, 1000), 1.0, 1.0);
-      video_writer.write(visualized_img);
-    }
+/// @brief queue analysis job of uploaded video (once per upload, video may be still uploading)
+/// @param upload_context Upload having video file and whole request json
+static void submit_video_analysis(VideoUploadContext &upload_context)
+{
+  if (upload_context.m_isJobSubmitted)
+    return;
+  upload_context.m_isJobSubmitted = true;
 
-    ProcessState visualization_state;
-    visualization_state.m_progression = static_cast<double>(frame_count) / static_cast<double>(frame_num);
-    visualization_state.m_frameCount = frame_count;
-    std::memcpy(file_mapped_memory, reinterpret_cast<char *>(&visualization_state), sizeof(ProcessState));
+  try
+  {
+    // declared digest lets still uploading video hit cache (upload fails if content differs)
+    // visualization of cached result reads video file, it needs finished upload
+    const auto &ptr_uploaded_video = upload_context.m_ptrUploadedVideo;
+    std::string video_digest;
+    if (ptr_uploaded_video->isFinished())
+      video_digest = ptr_uploaded_video->getContentDigest();
+    else if (!upload_context.m_isVisualized)
+      video_digest = upload_context.m_declaredVideoDigest;
+    const auto cache_key = (gptr_result_cache == nullptr || video_digest.empty())
+                               ? std::string()
+                               : ApiServer::ResultCache::createKey(video_digest, upload_context.m_requestJsonString);
+
+    upload_context.m_jobId = request_video_analysis(
+        ptr_uploaded_video->getFilePath(), ptr_uploaded_video, upload_context.m_requestJsonString, cache_key,
+        upload_context.m_isVisualized, upload_context.m_visualizationJobId);
+    if (upload_context.m_jobId != 0U)
+      keep_uploaded_video(upload_context.m_jobId, ptr_uploaded_video);
+  }
+  catch (const std::exception &exception)
+  {
+    upload_context.m_errorMessage = exception.what();
+  }
+}
 
-    frame_count++;
+/// @brief create video file of upload (hashed when results are cached)
+/// @param upload_context Upload receiving video part
+static void create_uploaded_video(VideoUploadContext &upload_context)
+{
+  upload_context.m_ptrUploadedVideo =
+      std::make_shared<ApiServer::UploadedVideoFile>(upload_context.m_videoFilePath, gptr_result_cache != nullptr);
+  if (!upload_context.m_declaredVideoDigest.empty())
+    upload_context.m_ptrUploadedVideo->setExpectedDigest(upload_context.m_declaredVideoDigest);
+}
+
+/// @brief create response of /analyze_video
+/// @param upload_context Finished upload
+/// @return Response ({"access_id", "visualization_access_id" (if visualized)} or {"error"})
+static drogon::HttpResponsePtr create_analysis_job_response(const VideoUploadContext &upload_context)
+{
+  auto response = drogon::HttpResponse::newHttpResponse();
+  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+  if (!upload_context.m_errorMessage.empty())
+  {
+    response->setStatusCode(drogon::k400BadRequest);
+    response->setBody(nlohmann::json({{"error", upload_context.m_errorMessage}}).dump());
+  }
+  else if (upload_context.m_jobId == 0U)
+  {
+    response->setStatusCode(drogon::k503ServiceUnavailable);
+    response->setBody(R"({ "error": "job queue is full" })");
+  }
+  else
+  {
+    nlohmann::json json_obj;
+    json_obj["access_id"] = upload_context.m_jobId;
+    if (upload_context.m_isVisualized)
+      json_obj["visualization_access_id"] = upload_context.m_visualizationJobId; // 0: job queue is full
+    response->setBody(json_obj.dump());
   }
-  video_writer.release();
 
-  ProcessState visualization_state;
-  visualization_state.m_isCompleted = true;
-  visualization_state.m_progression = 1.0;
-  visualization_state.m_frameCount = frame_count;
-  std::memcpy(file_mapped_memory, &visualization_state, sizeof(ProcessState));
-  ::munmap(file_mapped_memory, sizeof(ProcessState));
+  return response;
 }
 
 /// @brief regist api server's event handler (url method)
@@ -280,62 +846,300 @@ static void regist_request_handler()
                                 [](const drogon::HttpRequestPtr &request,
                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback)
                                 {
-                                  drogon::MultiPartParser uploaded_file;
-                                  uploaded_file.parse(request);
+                                  auto &queued_picture_num = ApiServer::Metrics::get_counters().m_queuedPictureNum;
+                                  if (queued_picture_num.fetch_add(1, std::memory_order_relaxed) >= g_max_queued_picture_num)
+                                  {
+                                    queued_picture_num.fetch_sub(1, std::memory_order_relaxed);
+                                    auto response = drogon::HttpResponse::newHttpResponse();
+                                    response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+                                    response->setStatusCode(drogon::k503ServiceUnavailable);
+                                    response->setBody(R"({ "error": "picture queue is full" })");
+                                    callback(response);
+                                    return;
+                                  }
 
-                                  const auto &image_binary_file = uploaded_file.getFilesMap().at("image_file");
-                                  std::vector<char> binary_list(image_binary_file.fileLength());
-                                  std::memcpy(binary_list.data(), image_binary_file.fileContent().data(), image_binary_file.fileLength());
-                                  const auto analyzed_picture = cv::imdecode(binary_list, cv::IMREAD_COLOR);
+                                  // decode and analysis run on compute pool, io thread keeps serving other connections
+                                  gptr_compute_queue->runTaskInQueue(
+                                      [request, callback = std::move(callback)]()
+                                      {
+                                        auto response = drogon::HttpResponse::newHttpResponse();
+                                        response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+                                        try
+                                        {
+                                          drogon::MultiPartParser uploaded_file;
+                                          uploaded_file.parse(request);
+                                          const auto &files_map = uploaded_file.getFilesMap();
+                                          for (const auto &[file_name, uploaded_part] : files_map)
+                                            ApiServer::Metrics::get_counters().m_uploadBytes.fetch_add(
+                                                uploaded_part.fileLength(), std::memory_order_relaxed);
+
+                                          // .fileContent() ignores tail of file added packet (not contained in original data).
+                                          const auto request_json_file_string = std::string(files_map.at("request_json").fileContent());
+                                          const auto detection_result_list = GCB::get_detection_result_list_from_json(request_json_file_string);
+                                          const auto request_json = nlohmann::json::parse(request_json_file_string);
+
+                                          // "image_tiles": device tiles cropped by client, "image_file": whole frame
+                                          if (const auto tile_file_iter = files_map.find("image_tiles"); tile_file_iter != files_map.end())
+                                            response->setBody(
+                                                analyze_picture_tiles(tile_file_iter->second.fileContent(), request_json, detection_result_list));
+                                          else
+                                          {
+                                            const auto analyzed_picture = decode_picture(
+                                                files_map.at("image_file").fileContent(), request_json.value("image_format", nlohmann::json::object()));
+                                            response->setBody(analyze_picture(analyzed_picture, detection_result_list));
+                                          }
+                                        }
+                                        catch (const std::exception &exception)
+                                        {
+                                          response->setStatusCode(drogon::k400BadRequest);
+                                          response->setBody(nlohmann::json({{"error", exception.what()}}).dump());
+                                        }
+
+                                        ApiServer::Metrics::get_counters().m_queuedPictureNum.fetch_sub(1, std::memory_order_relaxed);
+                                        callback(response); // response is sent by io thread of connection
+                                      });
+                                },
+                                {drogon::Post});
 
-                                  // .fileContent() ignores tail of file added packet (not contained in original data).
-                                  const auto request_json_file_string =
-                                      std::string(uploaded_file.getFilesMap().at("request_json").fileContent());
-                                  const auto detection_result_list = get_device_detection_list_from_json(request_json_file_string);
+  // analyze many frames with one shared request json (response: "FrameN" layout of video result)
+  drogon::app().registerHandler("/analyze_pictures",
+                                [](const drogon::HttpRequestPtr &request,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback)
+                                {
+                                  auto &queued_picture_num = ApiServer::Metrics::get_counters().m_queuedPictureNum;
+                                  if (queued_picture_num.fetch_add(1, std::memory_order_relaxed) >= g_max_queued_picture_num)
+                                  {
+                                    queued_picture_num.fetch_sub(1, std::memory_order_relaxed);
+                                    auto response = drogon::HttpResponse::newHttpResponse();
+                                    response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+                                    response->setStatusCode(drogon::k503ServiceUnavailable);
+                                    response->setBody(R"({ "error": "picture queue is full" })");
+                                    callback(response);
+                                    return;
+                                  }
 
-                                  const auto result_json_string = analyze_picture(analyzed_picture, detection_result_list);
-                                  auto response = drogon::HttpResponse::newHttpResponse();
-                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
-                                  response->setBody(result_json_string);
-                                  callback(response);
+                                  auto ptr_batch_context = std::make_shared<PictureBatchContext>();
+                                  ptr_batch_context->m_callback = std::move(callback);
+                                  gptr_compute_queue->runTaskInQueue(
+                                      [request, ptr_batch_context]()
+                                      {
+                                        auto &batch_context = *ptr_batch_context;
+                                        try
+                                        {
+                                          batch_context.m_ptrUploadedFile = std::make_shared<drogon::MultiPartParser>();
+                                          batch_context.m_ptrUploadedFile->parse(request);
+                                          for (const auto &uploaded_part : batch_context.m_ptrUploadedFile->getFiles())
+                                            ApiServer::Metrics::get_counters().m_uploadBytes.fetch_add(
+                                                uploaded_part.fileLength(), std::memory_order_relaxed);
+
+                                          const auto request_json_file_string =
+                                              std::string(batch_context.m_ptrUploadedFile->getFilesMap().at("request_json").fileContent());
+                                          batch_context.m_detectionResultList = GCB::get_detection_result_list_from_json(request_json_file_string);
+                                          batch_context.m_imageFormatJson =
+                                              nlohmann::json::parse(request_json_file_string).value("image_format", nlohmann::json::object());
+                                          split_picture_batch(batch_context);
+                                        }
+                                        catch (const std::exception &exception)
+                                        {
+                                          batch_context.m_errorMessage = exception.what();
+                                          finish_picture_batch(batch_context);
+                                          return;
+                                        }
+
+                                        // frames are queued as separate tasks (no task waits for another, pool cannot deadlock)
+                                        const auto frame_num = batch_context.m_frameDataList.size();
+                                        batch_context.m_frameResultList.resize(frame_num);
+                                        batch_context.m_remainingFrameNum.store(frame_num, std::memory_order_relaxed);
+                                        for (size_t frame_idx = 0; frame_idx < frame_num; frame_idx++)
+                                          gptr_compute_queue->runTaskInQueue([ptr_batch_context, frame_idx]()
+                                                                             { analyze_batch_frame(ptr_batch_context, frame_idx); });
+                                      });
                                 },
                                 {drogon::Post});
 
   drogon::app().registerHandler("/analyze_video/{video-path}",
-                                [](const drogon::HttpRequestPtr &request,
+                                [](const drogon::HttpRequestPtr &request, drogon::RequestStreamPtr &&ptr_request_stream,
                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback, const std::string &video_path)
                                 {
-                                  drogon::MultiPartParser uploaded_file;
-                                  uploaded_file.parse(request);
-                                  const auto &video_binary_file = uploaded_file.getFilesMap().at("video");
+                                  auto ptr_upload_context = std::make_shared<VideoUploadContext>();
+                                  ptr_upload_context->m_videoFilePath = "../uploads/upload_" + std::to_string(++g_upload_num) + "_" + video_path;
+                                  const auto &visualize_parameter = request->getParameter("visualize");
+                                  ptr_upload_context->m_isVisualized = (visualize_parameter == "true" || visualize_parameter == "1");
+                                  // opt-in: FIFO cannot seek, videos with index at end (usual MP4) fail to open
+                                  const auto &overlap_parameter = request->getParameter("overlap");
+                                  ptr_upload_context->m_isOverlapped = (overlap_parameter == "true" || overlap_parameter == "1");
+                                  if (gptr_result_cache != nullptr)
+                                  {
+                                    auto &declared_video_digest = ptr_upload_context->m_declaredVideoDigest;
+                                    declared_video_digest = request->getHeader("X-Video-SHA256");
+                                    std::transform(declared_video_digest.begin(), declared_video_digest.end(),
+                                                   declared_video_digest.begin(), [](const unsigned char c)
+                                                   { return static_cast<char>(std::tolower(c)); });
+                                  }
+                                  if (video_path == "")
+                                  {
+                                    ptr_upload_context->m_errorMessage = "filePath is not found";
+                                    callback(create_analysis_job_response(*ptr_upload_context));
+                                    return;
+                                  }
 
-                                  ::pid_t analyze_process_id;
-                                  if (video_path != "")
+                                  // body already received (small request): same as streamed one
+                                  if (ptr_request_stream == nullptr)
                                   {
-                                    video_binary_file.saveAs(video_path);
+                                    drogon::MultiPartParser uploaded_file;
+                                    uploaded_file.parse(request);
+                                    const auto &video_binary_file = uploaded_file.getFilesMap().at("video");
+                                    const auto &request_json_file = uploaded_file.getFilesMap().at("request_json");
+                                    ApiServer::Metrics::get_counters().m_uploadBytes.fetch_add(
+                                        video_binary_file.fileLength() + request_json_file.fileLength(), std::memory_order_relaxed);
+
+                                    auto &upload_context = *ptr_upload_context;
+                                    create_uploaded_video(upload_context);
+                                    upload_context.m_ptrUploadedVideo->append(video_binary_file.fileData(), video_binary_file.fileLength());
+                                    upload_context.m_ptrUploadedVideo->finish(false);
+                                    upload_context.m_requestJsonString = std::string(request_json_file.fileContent());
+                                    if (upload_context.m_ptrUploadedVideo->isFailed())
+                                      upload_context.m_errorMessage = "video is not saved or does not match X-Video-SHA256";
+                                    else
+                                      submit_video_analysis(upload_context);
+
+                                    callback(create_analysis_job_response(upload_context));
+                                    return;
+                                  }
 
-                                    const auto request_json_file_string = std::string(uploaded_file.getFilesMap().at("request_json").fileContent());
-                                    const auto detection_result_list = get_device_detection_list_from_json(request_json_file_string);
+                                  // body is written to disk chunk by chunk, never buffered whole
+                                  ptr_request_stream->setStreamReader(drogon::RequestStreamReader::newMultipartReader(
+                                      request,
+                                      [ptr_upload_context](drogon::MultipartHeader &&multipart_header)
+                                      {
+                                        auto &upload_context = *ptr_upload_context;
+                                        upload_context.m_partName = multipart_header.name;
+                                        if (upload_context.m_partName != "video" || upload_context.m_ptrUploadedVideo != nullptr)
+                                          return;
+
+                                        try
+                                        {
+                                          create_uploaded_video(upload_context);
+                                        }
+                                        catch (const std::exception &exception)
+                                        {
+                                          upload_context.m_errorMessage = exception.what();
+                                          return;
+                                        }
+
+                                        // request_json sent first with ?overlap=true: analysis overlaps rest of upload
+                                        // (otherwise analysis opens complete file after upload)
+                                        if (upload_context.m_isOverlapped && upload_context.m_isRequestJsonReceived)
+                                          submit_video_analysis(upload_context);
+                                      },
+                                      [ptr_upload_context](const char *data, size_t data_size)
+                                      {
+                                        auto &upload_context = *ptr_upload_context;
+                                        ApiServer::Metrics::get_counters().m_uploadBytes.fetch_add(data_size, std::memory_order_relaxed);
+
+                                        // data_size 0: end of part
+                                        if (upload_context.m_partName == "request_json")
+                                        {
+                                          if (data_size == 0U)
+                                            upload_context.m_isRequestJsonReceived = true;
+                                          else
+                                            upload_context.m_requestJsonString.append(data, data_size);
+                                        }
+                                        else if (upload_context.m_partName == "video" && upload_context.m_ptrUploadedVideo != nullptr)
+                                        {
+                                          if (data_size == 0U)
+                                            upload_context.m_ptrUploadedVideo->finish(false);
+                                          else
+                                            upload_context.m_ptrUploadedVideo->append(data, data_size);
+                                        }
+                                      },
+                                      [ptr_upload_context, callback = std::move(callback)](std::exception_ptr ptr_exception)
+                                      {
+                                        auto &upload_context = *ptr_upload_context;
+                                        if (upload_context.m_ptrUploadedVideo != nullptr)
+                                          upload_context.m_ptrUploadedVideo->finish(ptr_exception != nullptr);
+
+                                        if (ptr_exception != nullptr)
+                                          upload_context.m_errorMessage = "upload is interrupted";
+                                        else if (upload_context.m_ptrUploadedVideo != nullptr && upload_context.m_ptrUploadedVideo->isFailed())
+                                          upload_context.m_errorMessage = "video is not saved or does not match X-Video-SHA256"; // cache hit is not answered
+                                        else if (upload_context.m_errorMessage.empty())
+                                        {
+                                          if (upload_context.m_ptrUploadedVideo == nullptr || !upload_context.m_isRequestJsonReceived)
+                                            upload_context.m_errorMessage = "'video' or 'request_json' is not found";
+                                          else
+                                            submit_video_analysis(upload_context);
+                                        }
+
+                                        callback(create_analysis_job_response(upload_context));
+                                      }));
+                                },
+                                {drogon::Post});
 
-                                    if ((analyze_process_id = ::fork()) == 0)
+  // analyze video on shared storage in place (no upload, no copy to ../uploads)
+  drogon::app().registerHandler("/analyze_local_video",
+                                [](const drogon::HttpRequestPtr &request,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback)
+                                {
+                                  auto response = drogon::HttpResponse::newHttpResponse();
+                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+                                  if (g_local_video_root.empty())
+                                  {
+                                    response->setStatusCode(drogon::k403Forbidden);
+                                    response->setBody(R"({ "error": "local video root is not configured" })");
+                                    callback(response);
+                                    return;
+                                  }
+
+                                  try
+                                  {
+                                    // {"video_path": "...", "request_json": {...} or "...", "visualize": false}
+                                    const auto request_json = nlohmann::json::parse(request->body());
+                                    const auto video_file_path = resolve_local_video_path(request_json.at("video_path").get<std::string>());
+                                    if (video_file_path.empty())
                                     {
-                                      analyze_video("../uploads/" + video_path, detection_result_list);
-                                      ::_exit(EXIT_SUCCESS);
+                                      response->setStatusCode(drogon::k403Forbidden);
+                                      response->setBody(R"({ "error": "'video_path' is not a file under local video root" })");
+                                      callback(response);
+                                      return;
                                     }
-                                  }
 
-                                  g_video_request_id_set.insert(analyze_process_id);
+                                    const auto &detection_json = request_json.at("request_json");
+                                    const auto request_json_string =
+                                        detection_json.is_string() ? detection_json.get<std::string>() : detection_json.dump();
 
-                                  auto response = drogon::HttpResponse::newHttpResponse();
-                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
-                                  if (video_path != "")
+                                    // local file is identified by path, size and modification time (not hashed)
+                                    std::string cache_key;
+                                    if (gptr_result_cache != nullptr)
+                                    {
+                                      const auto video_identity = get_local_video_identity(video_file_path.string());
+                                      if (!video_identity.empty())
+                                        cache_key = ApiServer::ResultCache::createKey(video_identity, request_json_string);
+                                    }
+
+                                    const bool is_visualized = request_json.value("visualize", false);
+                                    uint64_t visualization_job_id = 0;
+                                    const auto job_id = request_video_analysis(video_file_path.string(), nullptr, request_json_string,
+                                                                               cache_key, is_visualized, visualization_job_id);
+                                    if (job_id == 0U)
+                                    {
+                                      response->setStatusCode(drogon::k503ServiceUnavailable);
+                                      response->setBody(R"({ "error": "job queue is full" })");
+                                    }
+                                    else
+                                    {
+                                      nlohmann::json json_obj;
+                                      json_obj["access_id"] = job_id;
+                                      if (is_visualized)
+                                        json_obj["visualization_access_id"] = visualization_job_id; // 0: job queue is full
+                                      response->setBody(json_obj.dump());
+                                    }
+                                  }
+                                  catch (const std::exception &exception)
                                   {
-                                    nlohmann::json json_obj;
-                                    json_obj["access_id"] = analyze_process_id;
-                                    response->setBody(json_obj.dump());
+                                    response->setStatusCode(drogon::k400BadRequest);
+                                    response->setBody(nlohmann::json({{"error", exception.what()}}).dump());
                                   }
-                                  else
-                                    response->setBody(R"({ "error": "filePath is not found" })");
 
                                   callback(response);
                                 },
@@ -344,44 +1148,76 @@ static void regist_request_handler()
   drogon::app().registerHandler("/analyzation_result/{access-id}",
                                 [](const drogon::HttpRequestPtr &,
                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback,
-                                   const ::pid_t &access_id)
+                                   const uint64_t &access_id)
                                 {
                                   auto response = drogon::HttpResponse::newHttpResponse();
                                   response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
 
-                                  if (g_video_request_id_set.find(access_id) == g_video_request_id_set.end())
+                                  // lock-free read of status slot (no file access while job runs)
+                                  ApiServer::JobStatusTable::JobStatus job_status;
+                                  if (!gptr_job_scheduler->readJobStatus(access_id, job_status) ||
+                                      job_status.m_jobKind != ApiServer::Metrics::JobKind::ANALYZE)
                                   {
                                     response->setBody(R"({ "error": "'access-id' is not valid" })");
                                     callback(response);
                                     return;
                                   }
 
-                                  const std::string mmap_file_path = create_process_file_path("../data/memory_map/analyze", access_id, ".dat");
-                                  const auto file_mapped_memory = create_mapped_memory(mmap_file_path, PROT_READ | PROT_WRITE);
-
-                                  ProcessState analyzation_state;
-                                  std::memcpy(reinterpret_cast<char *>(&analyzation_state), file_mapped_memory, sizeof(ProcessState));
-                                  ::munmap(file_mapped_memory, sizeof(ProcessState));
-
-                                  if (analyzation_state.m_isCompleted)
+                                  if (job_status.m_state == ApiServer::JobState::COMPLETED)
                                   {
-                                    std::ifstream json_ifs(create_process_file_path("../data/analyze/result_", access_id, ".json"));
+                                    std::ifstream json_ifs(create_job_file_path("../data/analyze/result_", access_id, ".json"));
                                     std::string file_content, line;
                                     while (std::getline(json_ifs, line))
                                       file_content.append(line);
 
-                                    ::remove(mmap_file_path.c_str());
                                     response->setBody(file_content);
                                   }
                                   else
+                                    response->setBody(job_status.getJson().dump()); // "progression", or "error" of failed job
+
+                                  callback(response);
+                                },
+                                {drogon::Get});
+
+  // send timing record (stage histograms) of completed video analysis
+  drogon::app().registerHandler("/analysis_timing/{access-id}",
+                                [](const drogon::HttpRequestPtr &,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                   const uint64_t &access_id)
+                                {
+                                  auto response = drogon::HttpResponse::newHttpResponse();
+                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+
+                                  // only analysis jobs have timing records (same ids as /analyzation_result)
+                                  ApiServer::JobStatusTable::JobStatus job_status;
+                                  if (!gptr_job_scheduler->readJobStatus(access_id, job_status) ||
+                                      job_status.m_jobKind != ApiServer::Metrics::JobKind::ANALYZE)
                                   {
-                                    const auto progression = analyzation_state.m_progression;
-                                    nlohmann::json json_obj;
-                                    json_obj["progression"] = progression;
+                                    response->setBody(R"({ "error": "'access-id' is not valid" })");
+                                    callback(response);
+                                    return;
+                                  }
 
-                                    response->setBody(json_obj.dump());
+                                  if (job_status.m_state != ApiServer::JobState::COMPLETED)
+                                  {
+                                    response->setBody(job_status.getJson().dump()); // "progression", or "error" of failed job
+                                    callback(response);
+                                    return;
                                   }
 
+                                  std::ifstream json_ifs(create_job_file_path("../data/analyze/timing_", access_id, ".json"));
+                                  if (json_ifs.fail())
+                                  {
+                                    response->setBody(R"({ "error": "timing record is not found" })");
+                                    callback(response);
+                                    return;
+                                  }
+
+                                  std::string file_content, line;
+                                  while (std::getline(json_ifs, line))
+                                    file_content.append(line);
+
+                                  response->setBody(file_content);
                                   callback(response);
                                 },
                                 {drogon::Get});
@@ -389,32 +1225,48 @@ static void regist_request_handler()
   drogon::app().registerHandler("/visualize_analyzation_result/{access-id}/{}",
                                 [](const drogon::HttpRequestPtr &,
                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback,
-                                   const pid_t &access_id, const std::string &video_path)
+                                   const uint64_t &access_id, const std::string &)
                                 {
-                                  ::pid_t visualize_process_id;
-                                  if (g_video_request_id_set.find(access_id) != g_video_request_id_set.end())
+                                  auto response = drogon::HttpResponse::newHttpResponse();
+                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+
+                                  ApiServer::JobStatusTable::JobStatus analysis_job_status;
+                                  if (!gptr_job_scheduler->readJobStatus(access_id, analysis_job_status) ||
+                                      analysis_job_status.m_jobKind != ApiServer::Metrics::JobKind::ANALYZE)
                                   {
-                                    if ((visualize_process_id = ::fork()) == 0)
-                                    {
-                                      visualize_analyzation_result(
-                                          create_process_file_path("../data/analyze/result_", access_id, ".json"),
-                                          "../uploads/" + video_path);
-                                      ::_exit(EXIT_SUCCESS);
-                                    }
+                                    response->setBody(R"({ "error": "'access-id' is not valid" })");
+                                    callback(response);
+                                    return;
+                                  }
+                                  if (analysis_job_status.m_state != ApiServer::JobState::COMPLETED)
+                                  {
+                                    response->setBody(R"({ "error": "analysis is not completed" })");
+                                    callback(response);
+                                    return;
                                   }
 
-                                  g_video_request_id_set.insert(visualize_process_id);
+                                  // video of this analysis (uploads are stored under unique names)
+                                  const auto ptr_uploaded_video = find_uploaded_video(access_id);
+                                  if (ptr_uploaded_video == nullptr)
+                                  {
+                                    response->setBody(R"({ "error": "video of 'access-id' is not kept" })");
+                                    callback(response);
+                                    return;
+                                  }
 
-                                  auto response = drogon::HttpResponse::newHttpResponse();
-                                  response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
-                                  if (g_video_request_id_set.find(access_id) != g_video_request_id_set.end())
+                                  const auto job_id =
+                                      submit_visualization_job(access_id, ptr_uploaded_video->getFilePath(), ptr_uploaded_video);
+                                  if (job_id == 0U)
+                                  {
+                                    response->setStatusCode(drogon::k503ServiceUnavailable);
+                                    response->setBody(R"({ "error": "job queue is full" })");
+                                  }
+                                  else
                                   {
                                     nlohmann::json json_obj;
-                                    json_obj["access_id"] = visualize_process_id;
+                                    json_obj["access_id"] = job_id;
                                     response->setBody(json_obj.dump());
                                   }
-                                  else
-                                    response->setBody(R"({ "error": "'access-id' is not valid" })");
 
                                   callback(response);
                                 },
@@ -423,9 +1275,11 @@ static void regist_request_handler()
   drogon::app().registerHandler("/visualization_result/{access-id}",
                                 [](const drogon::HttpRequestPtr &,
                                    std::function<void(const drogon::HttpResponsePtr &)> &&callback,
-                                   const ::pid_t &access_id)
+                                   const uint64_t &access_id)
                                 {
-                                  if (g_video_request_id_set.find(access_id) == g_video_request_id_set.end())
+                                  ApiServer::JobStatusTable::JobStatus job_status;
+                                  if (!gptr_job_scheduler->readJobStatus(access_id, job_status) ||
+                                      job_status.m_jobKind != ApiServer::Metrics::JobKind::VISUALIZE)
                                   {
                                     auto response = drogon::HttpResponse::newHttpResponse();
                                     response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
@@ -434,18 +1288,11 @@ static void regist_request_handler()
                                     return;
                                   }
 
-                                  const std::string mmap_file_path = create_process_file_path("../data/memory_map/visualize", access_id, ".dat");
-                                  const auto file_mapped_memory = create_mapped_memory(mmap_file_path, PROT_READ | PROT_WRITE);
-
-                                  ProcessState visualizaion_state;
-                                  std::memcpy(reinterpret_cast<char *>(&visualizaion_state), file_mapped_memory, sizeof(ProcessState));
-                                  ::munmap(file_mapped_memory, sizeof(ProcessState));
-
                                   auto response = drogon::HttpResponse::newHttpResponse();
-                                  if (visualizaion_state.m_isCompleted)
+                                  if (job_status.m_state == ApiServer::JobState::COMPLETED)
                                   {
                                     std::ifstream video_ifs(
-                                        create_process_file_path("../data/visualize/result_", access_id, ".mp4"),
+                                        create_job_file_path("../data/visualize/result_", access_id, ".mp4"),
                                         std::ios::binary);
 
                                     video_ifs.seekg(0, std::ios::end);
@@ -456,56 +1303,92 @@ static void regist_request_handler()
                                     file_content.resize(file_size);
                                     video_ifs.read(file_content.data(), file_size);
 
-                                    ::remove(mmap_file_path.c_str());
-                                    g_video_request_id_set.erase(access_id);
+                                    gptr_job_scheduler->eraseJob(access_id);
 
                                     response->setContentTypeCode(drogon::ContentType::CT_TEXT_PLAIN);
                                     response->setBody(file_content);
                                   }
                                   else
                                   {
-                                    const auto progression = visualizaion_state.m_progression;
-                                    nlohmann::json json_obj;
-                                    json_obj["progression"] = progression;
+                                    if (job_status.m_state == ApiServer::JobState::FAILED)
+                                      gptr_job_scheduler->eraseJob(access_id);
 
                                     response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
-                                    response->setBody(json_obj.dump());
+                                    response->setBody(job_status.getJson().dump()); // "progression", or "error" of failed job
                                   }
 
                                   callback(response);
                                 },
                                 {drogon::Get});
-}
 
-/// @brief observe child process (if this func is not running, parent 'drogon-core' process will not be released forever.)
-static void mask_signal_child()
-{
-  ::sigset_t sigset;
-  ::sigemptyset(&sigset);
-  ::sigaddset(&sigset, SIGCHLD);
-  ::pthread_sigmask(SIG_BLOCK, &sigset, NULL);
-}
+  // push progress and completion of job (Server-Sent Events, replaces polling of result apis)
+  drogon::app().registerHandler("/job_events/{access-id}",
+                                [](const drogon::HttpRequestPtr &,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback,
+                                   const uint64_t &access_id)
+                                {
+                                  ApiServer::JobStatusTable::JobStatus job_status;
+                                  if (!gptr_job_scheduler->readJobStatus(access_id, job_status))
+                                  {
+                                    auto response = drogon::HttpResponse::newHttpResponse();
+                                    response->setContentTypeCode(drogon::ContentType::CT_APPLICATION_JSON);
+                                    response->setBody(R"({ "error": "'access-id' is not valid" })");
+                                    callback(response);
+                                    return;
+                                  }
 
-/// @brief stop to observe child process (it is called only when server program exit)
-static void unmask_signal_child()
-{
-  int status;
-  ::wait(&status); // wait for all child process stopped
-  std::cout << "chiled process kill" << std::endl;
-
-  ::sigset_t sigset;
-  ::sigemptyset(&sigset);
-  ::sigaddset(&sigset, SIGCHLD);
-  ::pthread_sigmask(SIG_UNBLOCK, &sigset, NULL);
+                                  auto response = drogon::HttpResponse::newAsyncStreamResponse(
+                                      [access_id](drogon::ResponseStreamPtr ptr_stream)
+                                      { gptr_job_event_hub->subscribe(access_id, std::move(ptr_stream)); },
+                                      true);
+                                  response->setContentTypeString("text/event-stream");
+                                  response->addHeader("Cache-Control", "no-cache");
+                                  callback(response);
+                                },
+                                {drogon::Get});
+
+  // send operational counters (Prometheus text format)
+  drogon::app().registerHandler("/metrics",
+                                [](const drogon::HttpRequestPtr &,
+                                   std::function<void(const drogon::HttpResponsePtr &)> &&callback)
+                                {
+                                  auto response = drogon::HttpResponse::newHttpResponse();
+                                  response->setContentTypeString("text/plain; version=0.0.4; charset=utf-8");
+                                  response->setBody(ApiServer::Metrics::get_prometheus_text());
+                                  callback(response);
+                                },
+                                {drogon::Get});
 }
 
-void ApiServer::bootServer(const std::string &ip_addr_str, const uint16_t &port_num)
+void ApiServer::bootServer(const std::string &ip_addr_str, const uint16_t &port_num, const ServerOption &server_option)
 {
   std::ios::sync_with_stdio(false);
-  std::filesystem::create_directory("../data/memory_map");
   std::filesystem::create_directory("../data/analyze");
   std::filesystem::create_directory("../data/visualize");
-  mask_signal_child();
+
+  if (!server_option.m_localVideoRoot.empty())
+  {
+    std::error_code error_code;
+    g_local_video_root = std::filesystem::canonical(server_option.m_localVideoRoot, error_code);
+    if (error_code)
+      std::cout << "local video root is not found: " << server_option.m_localVideoRoot << std::endl;
+  }
+
+  gptr_analysis_slot_pool = std::make_unique<GCB::AnalysisSlotPool>(server_option.m_analysisWorkerNum);
+  const auto compute_thread_num = (server_option.m_computeThreadNum == 0U)
+                                      ? std::max(1U, std::thread::hardware_concurrency())
+                                      : server_option.m_computeThreadNum;
+  gptr_compute_queue = std::make_unique<trantor::ConcurrentTaskQueue>(compute_thread_num, "gcb_compute");
+  g_max_queued_picture_num = static_cast<int64_t>(server_option.m_maxQueuedPictureNum);
+  gptr_job_scheduler = std::make_unique<JobScheduler>(
+      server_option.m_maxRunningJobNum, server_option.m_maxQueuedJobNum, server_option.m_jobStatusSlotNum);
+  gptr_job_event_hub = std::make_unique<JobEventHub>(
+      *gptr_job_scheduler, std::chrono::milliseconds(server_option.m_eventPushIntervalMilliseconds));
+  gptr_job_scheduler->setJobFinishedListener([](const uint64_t &)
+                                             { gptr_job_event_hub->requestPush(); });
+  if (server_option.m_resultCacheMegabytes != 0U)
+    gptr_result_cache = std::make_unique<ResultCache>(
+        "../data/cache", static_cast<uint64_t>(server_option.m_resultCacheMegabytes) * 1000U * 1000U);
 
   gptr_beacon_analyzer =
       std::make_shared<GCB::BeaconAnalyzer>(
@@ -517,13 +1400,16 @@ void ApiServer::bootServer(const std::string &ip_addr_str, const uint16_t &port_
 
   drogon::app()
       .setClientMaxBodySize(CLIENT_MAX_BODY_SIZE)
-      .setThreadNum(0)
+      .enableRequestStream() // large uploads reach handlers in chunks
+      .setThreadNum(server_option.m_ioThreadNum)
       .setUploadPath("../uploads")
       .addListener(ip_addr_str, port_num)
       .run();
 
-  unmask_signal_child();
-  std::filesystem::remove_all("../data/memory_map");
+  gptr_compute_queue.reset(); // wait for running picture requests
+  gptr_job_scheduler->stop(); // wait for running jobs
+  gptr_job_event_hub->stop();
+  gptr_result_cache.reset(); // cached results are kept for next boot
   std::filesystem::remove_all("../data/analyze");
   std::filesystem::remove_all("../data/visualize");
   std::filesystem::remove_all("../uploads");
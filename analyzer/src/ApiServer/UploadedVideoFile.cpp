@@ -0,0 +1,193 @@
+#include "UploadedVideoFile.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ApiServer;
+
+static constexpr size_t FEED_CHUNK_SIZE = 1U << 20U; // bytes copied to FIFO at once
+
+/// @brief write whole buffer (retry partial writes)
+/// @param file_descriptor Destination
+/// @param data Buffer
+/// @param data_size Bytes of buffer
+/// @return false on error (EPIPE: reader closed)
+static bool write_all(const int &file_descriptor, const char *data, size_t data_size)
+{
+  while (data_size > 0U)
+  {
+    const auto written_size = ::write(file_descriptor, data, data_size);
+    if (written_size < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+
+    data += written_size;
+    data_size -= static_cast<size_t>(written_size);
+  }
+
+  return true;
+}
+
+UploadedVideoFile::UploadedVideoFile(const std::string &file_path, const bool &is_hashed)
+    : m_filePath(file_path), m_writtenBytes(0), m_isFinished(false), m_isFailed(false), m_isFeedingStopped(false),
+      m_ptrContentHasher(is_hashed ? std::make_unique<ContentHasher>() : nullptr)
+{
+  m_fileDescriptor = ::open(m_filePath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (m_fileDescriptor < 0)
+    throw std::runtime_error("Video Open Error: " + m_filePath);
+}
+
+UploadedVideoFile::~UploadedVideoFile()
+{
+  ::close(m_fileDescriptor);
+  ::remove(m_filePath.c_str()); // jobs reading it hold this object
+}
+
+bool UploadedVideoFile::append(const char *data, const size_t &data_size)
+{
+  // unbuffered, feeder reads bytes as soon as they are counted
+  if (!write_all(m_fileDescriptor, data, data_size))
+  {
+    finish(true);
+    return false;
+  }
+  if (m_ptrContentHasher != nullptr)
+    m_ptrContentHasher->update(data, data_size); // same thread as finish()
+
+  {
+    std::lock_guard<std::mutex> file_lock(m_mutex);
+    m_writtenBytes += data_size;
+  }
+  m_writtenCv.notify_all();
+
+  return true;
+}
+
+void UploadedVideoFile::finish(const bool &is_failed)
+{
+  {
+    std::lock_guard<std::mutex> file_lock(m_mutex);
+    if (!m_isFinished && m_ptrContentHasher != nullptr)
+    {
+      m_contentDigest = m_ptrContentHasher->finishHex();
+      if (!m_expectedDigest.empty() && m_expectedDigest != m_contentDigest)
+        m_isFailed = true; // decoder sees failure together with end of video
+    }
+    m_isFinished = true;
+    m_isFailed = m_isFailed || is_failed;
+  }
+  m_writtenCv.notify_all();
+}
+
+void UploadedVideoFile::setExpectedDigest(const std::string &expected_digest)
+{
+  std::lock_guard<std::mutex> file_lock(m_mutex);
+  m_expectedDigest = expected_digest;
+}
+
+std::string UploadedVideoFile::getContentDigest() const
+{
+  std::lock_guard<std::mutex> file_lock(m_mutex);
+  return m_isFailed ? std::string() : m_contentDigest;
+}
+
+void UploadedVideoFile::feedFifo(const std::string &fifo_path)
+{
+  // FIFO is opened without blocking, decoder may fail before opening it
+  int fifo_descriptor = -1;
+  while (true)
+  {
+    fifo_descriptor = ::open(fifo_path.c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fifo_descriptor >= 0 || errno != ENXIO)
+      break;
+
+    std::unique_lock<std::mutex> file_lock(m_mutex);
+    if (m_writtenCv.wait_for(file_lock, std::chrono::milliseconds(10), [&]()
+                             { return m_isFeedingStopped; }))
+      return;
+  }
+  if (fifo_descriptor < 0)
+    return;
+  ::fcntl(fifo_descriptor, F_SETFL, ::fcntl(fifo_descriptor, F_GETFL) & ~O_NONBLOCK); // decoder paces feeder
+
+  const int file_descriptor = ::open(m_filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  std::vector<char> chunk(FEED_CHUNK_SIZE);
+  uint64_t fed_bytes = 0;
+  while (file_descriptor >= 0)
+  {
+    uint64_t written_bytes = 0;
+    {
+      std::unique_lock<std::mutex> file_lock(m_mutex);
+      m_writtenCv.wait(file_lock, [&]()
+                       { return m_isFeedingStopped || m_isFinished || m_writtenBytes > fed_bytes; });
+      if (m_isFeedingStopped)
+        break;
+      written_bytes = m_writtenBytes;
+    }
+    if (written_bytes == fed_bytes)
+      break; // upload finished
+
+    const auto chunk_size = static_cast<size_t>(std::min<uint64_t>(written_bytes - fed_bytes, chunk.size()));
+    const auto read_size = ::pread(file_descriptor, chunk.data(), chunk_size, static_cast<off_t>(fed_bytes));
+    if (read_size <= 0 || !write_all(fifo_descriptor, chunk.data(), static_cast<size_t>(read_size)))
+      break; // decoder closed FIFO (EPIPE, SIGPIPE is ignored by trantor)
+
+    fed_bytes += static_cast<uint64_t>(read_size);
+  }
+
+  if (file_descriptor >= 0)
+    ::close(file_descriptor);
+  ::close(fifo_descriptor); // decoder reads end of video
+}
+
+void UploadedVideoFile::stopFeeding()
+{
+  {
+    std::lock_guard<std::mutex> file_lock(m_mutex);
+    m_isFeedingStopped = true;
+  }
+  m_writtenCv.notify_all();
+}
+
+bool UploadedVideoFile::isFinished() const
+{
+  std::lock_guard<std::mutex> file_lock(m_mutex);
+  return m_isFinished;
+}
+
+bool UploadedVideoFile::isFailed() const
+{
+  std::lock_guard<std::mutex> file_lock(m_mutex);
+  return m_isFailed;
+}
+
+UploadedVideoFeeder::UploadedVideoFeeder(UploadedVideoFile &uploaded_video_file)
+    : m_uploadedVideoFile(uploaded_video_file), m_fifoPath(uploaded_video_file.getFilePath() + ".fifo")
+{
+  ::remove(m_fifoPath.c_str());
+  if (::mkfifo(m_fifoPath.c_str(), 0600) != 0)
+    throw std::runtime_error("FIFO Create Error: " + m_fifoPath);
+
+  m_feeder = std::thread(&UploadedVideoFile::feedFifo, &m_uploadedVideoFile, m_fifoPath);
+}
+
+UploadedVideoFeeder::~UploadedVideoFeeder()
+{
+  m_uploadedVideoFile.stopFeeding();
+  if (m_feeder.joinable())
+    m_feeder.join();
+
+  ::remove(m_fifoPath.c_str());
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "ResultCache.hpp"
+
+namespace ApiServer
+{
+  // Video file written chunk by chunk while it is uploaded (readable by analysis job before upload finishes), removed with this object
+  class UploadedVideoFile
+  {
+  private:
+    std::string m_filePath;
+    int m_fileDescriptor;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_writtenCv;
+    uint64_t m_writtenBytes;
+    bool m_isFinished;
+    bool m_isFailed;
+    bool m_isFeedingStopped;
+    std::unique_ptr<ContentHasher> m_ptrContentHasher; // nullptr: digest is not needed
+    std::string m_expectedDigest; // declared by client (upload fails on mismatch)
+    std::string m_contentDigest;
+
+  public:
+    /// @brief constructor (create file, fails if it exists so that uploads never share a file)
+    /// @param file_path Path of uploaded video (unique per upload)
+    /// @param is_hashed Compute SHA-256 of content while it is written
+    explicit UploadedVideoFile(const std::string &file_path, const bool &is_hashed = false);
+
+    /// @brief destructor (close and remove file)
+    ~UploadedVideoFile();
+
+    /* forbid copy action */
+    UploadedVideoFile(const UploadedVideoFile &other) = delete;
+    UploadedVideoFile &operator=(const UploadedVideoFile &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief write received chunk at end of file (called by upload's io thread)
+    /// @param data Chunk of request body
+    /// @param data_size Bytes of chunk
+    /// @return false if writing failed (upload is marked failed)
+    bool append(const char *data, const size_t &data_size);
+
+    /// @brief mark end of upload (wake feeder), digest is fixed by first call
+    /// @param is_failed Upload was interrupted
+    void finish(const bool &is_failed);
+
+    /// @brief set digest declared by client (called before finish, hashed file only)
+    void setExpectedDigest(const std::string &expected_digest);
+
+    /// @brief get SHA-256 of content (hex, empty until finished or when not hashed)
+    std::string getContentDigest() const;
+
+    /// @brief copy written bytes to FIFO until upload finishes (blocking, runs on feeder thread)
+    /// @param fifo_path Path of FIFO opened by decoder
+    void feedFifo(const std::string &fifo_path);
+
+    /// @brief make feedFifo() return (also while FIFO has no reader)
+    void stopFeeding();
+
+    /// @brief getter isFinished
+    bool isFinished() const;
+
+    /// @brief getter isFailed
+    bool isFailed() const;
+
+    /// @brief getter filePath
+    const std::string &getFilePath() const { return m_filePath; }
+  };
+
+  // Decoder input of video still uploading (FIFO fed by thread, removed on destruction)
+  class UploadedVideoFeeder
+  {
+  private:
+    UploadedVideoFile &m_uploadedVideoFile;
+    std::string m_fifoPath;
+    std::thread m_feeder;
+
+  public:
+    /// @brief constructor (create FIFO, start feeder thread)
+    /// @param uploaded_video_file Video being uploaded
+    explicit UploadedVideoFeeder(UploadedVideoFile &uploaded_video_file);
+
+    /// @brief destructor (stop feeder thread, remove FIFO), close decoder's input first
+    ~UploadedVideoFeeder();
+
+    /* forbid copy action */
+    UploadedVideoFeeder(const UploadedVideoFeeder &other) = delete;
+    UploadedVideoFeeder &operator=(const UploadedVideoFeeder &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief getter fifoPath
+    const std::string &getFifoPath() const { return m_fifoPath; }
+  };
+};
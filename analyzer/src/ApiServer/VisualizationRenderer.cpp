@@ -0,0 +1,134 @@
+#include "VisualizationRenderer.hpp"
+
+#include <cmath>
+#include <iostream>
+
+using namespace ApiServer;
+
+static constexpr int32_t SHIFT_BITS = 4; // sub-pixel bits of drawn LEDs
+
+VisualizationRenderer::VisualizationRenderer(
+    const std::unordered_map<std::string, GCB::Inside::DeviceDefinition> &device_definitions)
+    : m_deviceDefinitions(device_definitions), m_canvas(CANVAS_HEIGHT, CANVAS_WIDTH, CV_8UC3)
+{
+}
+
+const cv::Mat &VisualizationRenderer::getBackground(const GCB::Inside::DeviceDefinition &device_definition,
+                                                    const cv::Size &cell_size)
+{
+  const auto background_key = device_definition.m_deviceName + ":" + std::to_string(cell_size.width) + "x" +
+                              std::to_string(cell_size.height);
+  auto &background = m_backgroundMap[background_key];
+  if (!background.empty())
+    return background;
+
+  // markers on black at template size, scaled once (unlit beacons are drawn per frame)
+  cv::Mat template_img = cv::Mat::zeros(device_definition.m_deviceTemplateSize, CV_8UC3);
+  for (const auto &marker : device_definition.m_markerList)
+  {
+    cv::Scalar marker_color;
+    if (marker.m_color == "blue")
+      marker_color[0] = 255;
+    else
+      marker_color[1] = 255;
+    cv::circle(template_img, marker.m_position, static_cast<int32_t>(marker.m_radius), marker_color, -1);
+  }
+  cv::resize(template_img, background, cell_size, 0.0, 0.0, cv::INTER_AREA);
+
+  return background;
+}
+
+void VisualizationRenderer::createLayout(const cv::Size &frame_size,
+                                         const std::vector<DeviceLedPattern> &device_led_pattern_list)
+{
+  m_layoutFrameSize = frame_size;
+  m_layoutDeviceNames.clear();
+  m_deviceCellList.clear();
+
+  // device views of DEVICE_VIEW_HEIGHT side by side, frame below at same width, all scaled to canvas
+  std::vector<double> view_width_list;
+  double total_view_width = 0.0;
+  for (const auto &device_led_pattern : device_led_pattern_list)
+  {
+    m_layoutDeviceNames.push_back(device_led_pattern.m_deviceName);
+    const auto &device_definition = m_deviceDefinitions.at(device_led_pattern.m_deviceName);
+    const auto &template_size = device_definition.m_deviceTemplateSize;
+    if (template_size.empty())
+    {
+      std::cout << device_led_pattern.m_deviceName + "'s result is None" << std::endl;
+      continue;
+    }
+
+    DeviceCell device_cell;
+    device_cell.m_ptrDeviceDefinition = &device_definition;
+    m_deviceCellList.push_back(device_cell);
+    view_width_list.push_back(std::round(static_cast<double>(template_size.width) * DEVICE_VIEW_HEIGHT / template_size.height));
+    total_view_width += view_width_list.back();
+  }
+  if (m_deviceCellList.empty())
+    return;
+
+  const auto frame_view_height = std::round(static_cast<double>(frame_size.height) * total_view_width / frame_size.width);
+  const auto scale_x = CANVAS_WIDTH / total_view_width;
+  const auto scale_y = CANVAS_HEIGHT / (DEVICE_VIEW_HEIGHT + frame_view_height);
+  const auto cell_height = static_cast<int32_t>(std::lround(DEVICE_VIEW_HEIGHT * scale_y));
+
+  double view_left = 0.0;
+  for (size_t cell_idx = 0; cell_idx < m_deviceCellList.size(); cell_idx++)
+  {
+    auto &device_cell = m_deviceCellList[cell_idx];
+    const auto cell_left = static_cast<int32_t>(std::lround(view_left * scale_x));
+    view_left += view_width_list[cell_idx];
+    const auto cell_right = static_cast<int32_t>(std::lround(view_left * scale_x));
+
+    device_cell.m_cellRect = cv::Rect(cell_left, 0, cell_right - cell_left, cell_height);
+    device_cell.m_background = getBackground(*device_cell.m_ptrDeviceDefinition, device_cell.m_cellRect.size());
+  }
+  m_frameRect = cv::Rect(0, cell_height, CANVAS_WIDTH, CANVAS_HEIGHT - cell_height);
+}
+
+bool VisualizationRenderer::renderFrame(const cv::Mat &frame, const std::vector<DeviceLedPattern> &device_led_pattern_list)
+{
+  bool is_layout_changed = m_layoutDeviceNames.empty() || frame.size() != m_layoutFrameSize ||
+                           m_layoutDeviceNames.size() != device_led_pattern_list.size();
+  for (size_t device_idx = 0; !is_layout_changed && device_idx < device_led_pattern_list.size(); device_idx++)
+    is_layout_changed = (m_layoutDeviceNames[device_idx] != device_led_pattern_list[device_idx].m_deviceName);
+  if (is_layout_changed)
+    createLayout(frame.size(), device_led_pattern_list);
+  if (m_deviceCellList.empty())
+    return false;
+
+  // only beacon intensities are drawn over prerendered backgrounds
+  size_t cell_idx = 0;
+  for (const auto &device_led_pattern : device_led_pattern_list)
+  {
+    if (cell_idx == m_deviceCellList.size() ||
+        m_deviceCellList[cell_idx].m_ptrDeviceDefinition->m_deviceName != device_led_pattern.m_deviceName)
+      continue; // device without template
+
+    const auto &device_cell = m_deviceCellList[cell_idx++];
+    const auto &template_size = device_cell.m_ptrDeviceDefinition->m_deviceTemplateSize;
+    auto cell_img = m_canvas(device_cell.m_cellRect);
+    device_cell.m_background.copyTo(cell_img);
+
+    const double shift_scale_x = static_cast<double>(1 << SHIFT_BITS) * device_cell.m_cellRect.width / template_size.width;
+    const double shift_scale_y = static_cast<double>(1 << SHIFT_BITS) * device_cell.m_cellRect.height / template_size.height;
+    for (const auto &beacon : device_cell.m_ptrDeviceDefinition->m_beaconList)
+    {
+      const auto beacon_idx = beacon.m_ordinal - 1U;
+      const uint8_t beacon_pattern = device_led_pattern.m_ledPatternList.at(beacon_idx);
+      const cv::Point center(static_cast<int32_t>(std::lround(beacon.m_position.x * shift_scale_x)),
+                             static_cast<int32_t>(std::lround(beacon.m_position.y * shift_scale_y)));
+      const cv::Size axes(static_cast<int32_t>(std::lround(beacon.m_radius * shift_scale_x)),
+                          static_cast<int32_t>(std::lround(beacon.m_radius * shift_scale_y)));
+      cv::ellipse(cell_img, center, axes, 0.0, 0.0, 360.0, cv::Scalar(0, 0, (255 / 32) * beacon_pattern),
+                  cv::FILLED, cv::LINE_8, SHIFT_BITS);
+    }
+  }
+
+  // resized into canvas in place (no intermediate image)
+  auto frame_img = m_canvas(m_frameRect);
+  cv::resize(frame, frame_img, m_frameRect.size());
+
+  return true;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../GCB.hpp"
+
+namespace ApiServer
+{
+  // LED patterns of one device on one frame (rendered in order of device key)
+  struct DeviceLedPattern
+  {
+    std::string m_deviceName;
+    std::vector<uint8_t> m_ledPatternList; // index: beacon ordinal - 1
+  };
+
+  // Renderer of visualization frames (device views over resized video frame) into preallocated canvas
+  class VisualizationRenderer
+  {
+  public:
+    static constexpr int32_t CANVAS_WIDTH = 1500;
+    static constexpr int32_t CANVAS_HEIGHT = 1000;
+    static constexpr int32_t DEVICE_VIEW_HEIGHT = 500; // height of device views before canvas scaling
+
+  private:
+    // Device view placed on canvas
+    struct DeviceCell
+    {
+      const GCB::Inside::DeviceDefinition *m_ptrDeviceDefinition;
+      cv::Rect m_cellRect;
+      cv::Mat m_background; // markers prerendered at cell size
+    };
+
+    const std::unordered_map<std::string, GCB::Inside::DeviceDefinition> &m_deviceDefinitions;
+    cv::Mat m_canvas;
+    std::vector<std::string> m_layoutDeviceNames; // devices of current layout (empty: no layout)
+    cv::Size m_layoutFrameSize;
+    std::vector<DeviceCell> m_deviceCellList;
+    cv::Rect m_frameRect;
+    std::unordered_map<std::string, cv::Mat> m_backgroundMap; // key: device name and cell size
+
+    /// @brief place device views and video frame on canvas (called when devices or frame size change)
+    /// @param frame_size Size of video frame
+    /// @param device_led_pattern_list Devices of frame
+    void createLayout(const cv::Size &frame_size, const std::vector<DeviceLedPattern> &device_led_pattern_list);
+
+    /// @brief get markers of device rendered at cell size (cached)
+    const cv::Mat &getBackground(const GCB::Inside::DeviceDefinition &device_definition, const cv::Size &cell_size);
+
+  public:
+    /// @brief constructor (allocate canvas)
+    /// @param device_definitions Definitions of devices (must outlive renderer)
+    explicit VisualizationRenderer(const std::unordered_map<std::string, GCB::Inside::DeviceDefinition> &device_definitions);
+
+    /* forbid copy action */
+    VisualizationRenderer(const VisualizationRenderer &other) = delete;
+    VisualizationRenderer &operator=(const VisualizationRenderer &other) = delete;
+    /* end: forbid copy action */
+
+    /// @brief render visualization of frame into canvas
+    /// @param frame Video frame (BGR)
+    /// @param device_led_pattern_list LED patterns of devices (sorted by device key)
+    /// @return false if no device is drawable (canvas is not updated, frame is not visualized)
+    bool renderFrame(const cv::Mat &frame, const std::vector<DeviceLedPattern> &device_led_pattern_list);
+
+    /// @brief getter canvas (CANVAS_WIDTH x CANVAS_HEIGHT, valid until next renderFrame)
+    const cv::Mat &getCanvas() const { return m_canvas; }
+  };
+};
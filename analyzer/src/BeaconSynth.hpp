@@ -0,0 +1,39 @@
+#pragma once
+
+#include "GCB.hpp"
+
+// Rendering of synthetic beacon devices (inputs of gcb-bench, no camera footage needed)
+namespace BeaconSynth
+{
+	constexpr uint8_t LED_LEVEL_NUM = 32; // LED levels 0 ~ 31 (same as analyzed LED pattern)
+
+	/// @brief get BGR color of lit LED
+	/// @param led_color LED color of device definition ("red", "yellow", "green", "blue")
+	/// @param led_level Lighting level (0 ~ 31, markers are drawn with 31)
+	/// @return BGR color
+	cv::Scalar get_led_bgr_color(const std::string &led_color, const uint8_t &led_level);
+
+	/// @brief render device template (markers are lit, beacon LEDs are lit by "led_level_list")
+	/// @param device_definition Rendered device
+	/// @param led_level_list Level of beacon LEDs (0 ~ 31, index: beacon ordinal - 1)
+	/// @param scale Render scale (rendering near drawn size is cheaper than full size template)
+	/// @return BGR image of device_definition.m_deviceTemplateSize * scale
+	cv::Mat render_device_template(const GCB::Inside::DeviceDefinition &device_definition,
+																 const std::vector<uint8_t> &led_level_list, const double &scale = 1.0);
+
+	/// @brief get corners of device placed in roi (clockwise from top-left)
+	/// @param template_size Size of device template
+	/// @param roi_rect Roi of device in frame
+	/// @param fill_ratio Ratio of device size to roi size (0.0 ~ 1.0)
+	/// @param tilt_ratio Perspective distortion (0.0: fronto-parallel, ratio of roi size)
+	/// @return Device corners in frame
+	std::array<cv::Point2f, 4> get_device_corners(const cv::Size &template_size, const cv::Rect2f &roi_rect,
+																								const double &fill_ratio, const double &tilt_ratio);
+
+	/// @brief draw device template onto frame
+	/// @param frame Frame drawn on (BGR)
+	/// @param device_template_img Rendered device template
+	/// @param device_corners Device corners in frame (clockwise from top-left)
+	void draw_device(cv::Mat &frame, const cv::Mat &device_template_img,
+									 const std::array<cv::Point2f, 4> &device_corners);
+};
@@ -0,0 +1,95 @@
+#include "../BeaconSynth.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+static const cv::Scalar DEVICE_PANEL_COLOR(24, 24, 24); // unlit body of device
+static constexpr double LED_MIN_BRIGHTNESS = 48.0;      // brightness of level 0 (unlit LED is not black)
+
+cv::Scalar BeaconSynth::get_led_bgr_color(const std::string &led_color, const uint8_t &led_level)
+{
+  const auto level = std::min<uint8_t>(led_level, LED_LEVEL_NUM - 1U);
+  const auto brightness = LED_MIN_BRIGHTNESS + (255.0 - LED_MIN_BRIGHTNESS) * level / (LED_LEVEL_NUM - 1U);
+
+  if (led_color == "green")
+    return cv::Scalar(0.0, brightness, 0.0);
+  if (led_color == "blue")
+    return cv::Scalar(brightness, brightness / 2.0, 0.0);
+  if (led_color == "yellow")
+    return cv::Scalar(0.0, brightness, brightness);
+
+  return cv::Scalar(0.0, 0.0, brightness);
+}
+
+cv::Mat BeaconSynth::render_device_template(const GCB::Inside::DeviceDefinition &device_definition,
+                                            const std::vector<uint8_t> &led_level_list, const double &scale)
+{
+  const auto &template_size = device_definition.m_deviceTemplateSize;
+  cv::Mat device_template_img(cv::Size(static_cast<int32_t>(std::lround(template_size.width * scale)),
+                                       static_cast<int32_t>(std::lround(template_size.height * scale))),
+                              CV_8UC3, DEVICE_PANEL_COLOR);
+
+  // sub-pixel centers (same geometry as LED masks of analyzer)
+  constexpr int32_t shift_bits = 4;
+  const double shift_scale = (1 << shift_bits) * scale;
+  const auto draw_led = [&](const GCB::Inside::LedData &led_data, const uint8_t &led_level)
+  {
+    const cv::Point center(static_cast<int32_t>(std::lround(led_data.m_position.x * shift_scale)),
+                           static_cast<int32_t>(std::lround(led_data.m_position.y * shift_scale)));
+    const auto radius = static_cast<int32_t>(std::lround(led_data.m_radius * shift_scale));
+    cv::circle(device_template_img, center, radius, get_led_bgr_color(led_data.m_color, led_level),
+               cv::FILLED, cv::LINE_AA, shift_bits);
+  };
+
+  for (const auto &marker : device_definition.m_markerList)
+    draw_led(marker, LED_LEVEL_NUM - 1U);
+
+  for (const auto &beacon : device_definition.m_beaconList)
+  {
+    const auto beacon_idx = beacon.m_ordinal - 1U;
+    draw_led(beacon, beacon_idx < led_level_list.size() ? led_level_list[beacon_idx] : 0U);
+  }
+
+  return device_template_img;
+}
+
+std::array<cv::Point2f, 4> BeaconSynth::get_device_corners(const cv::Size &template_size, const cv::Rect2f &roi_rect,
+                                                           const double &fill_ratio, const double &tilt_ratio)
+{
+  // keep aspect of template, centered in roi
+  const auto scale = fill_ratio * std::min(static_cast<double>(roi_rect.width) / template_size.width,
+                                           static_cast<double>(roi_rect.height) / template_size.height);
+  const cv::Size2f device_size(static_cast<float_t>(template_size.width * scale),
+                               static_cast<float_t>(template_size.height * scale));
+  const auto device_tl = cv::Point2f(roi_rect.x, roi_rect.y) +
+                         cv::Point2f((roi_rect.width - device_size.width) / 2.0f, (roi_rect.height - device_size.height) / 2.0f);
+
+  // right edge is nearer to camera than left edge
+  const auto tilt = static_cast<float_t>(tilt_ratio * std::min(roi_rect.width, roi_rect.height));
+  return {device_tl + cv::Point2f(0.0f, tilt),
+          device_tl + cv::Point2f(device_size.width, -tilt),
+          device_tl + cv::Point2f(device_size.width, device_size.height + tilt),
+          device_tl + cv::Point2f(0.0f, device_size.height - tilt)};
+}
+
+void BeaconSynth::draw_device(cv::Mat &frame, const cv::Mat &device_template_img,
+                              const std::array<cv::Point2f, 4> &device_corners)
+{
+  /* shrink template near drawn size first (warpPerspective alone aliases LED edges) */
+  const auto device_bounding_rect = cv::boundingRect(std::vector<cv::Point2f>(device_corners.begin(), device_corners.end()));
+  const auto shrink_ratio = std::min(1.0, std::max(static_cast<double>(device_bounding_rect.width) / device_template_img.cols,
+                                                   static_cast<double>(device_bounding_rect.height) / device_template_img.rows));
+  cv::Mat device_img;
+  cv::resize(device_template_img, device_img, cv::Size(), shrink_ratio, shrink_ratio, cv::INTER_AREA);
+  /* end: shrink template near drawn size first */
+
+  const std::array<cv::Point2f, 4> device_img_corners = {
+      cv::Point2f(0.0f, 0.0f),
+      cv::Point2f(static_cast<float_t>(device_img.cols), 0.0f),
+      cv::Point2f(static_cast<float_t>(device_img.cols), static_cast<float_t>(device_img.rows)),
+      cv::Point2f(0.0f, static_cast<float_t>(device_img.rows))};
+  const auto homography_mat = cv::getPerspectiveTransform(device_img_corners.data(), device_corners.data());
+
+  // pixels outside of device keep frame content
+  cv::warpPerspective(device_img, frame, homography_mat, frame.size(), cv::INTER_LINEAR, cv::BORDER_TRANSPARENT);
+}
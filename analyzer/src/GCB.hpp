@@ -1,13 +1,21 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <thread>
+#include <vector>
 
 #include <opencv2/opencv.hpp>
 
 #define JSON_HAS_CPP_17 1 // nlohmann-json magic code
 #include "GCB/json.hpp"
+#include "GCB/Pipeline.hpp"
 
 // API providing for detection or analyzation of GCB device
 namespace GCB
@@ -18,11 +26,43 @@ namespace GCB
 		// Information of LED on beacon device
 		struct LedData
 		{
+			uint32_t m_ordinal; // number of "ID" key in JSON (1 ~ led_num)
 			cv::Rect m_boundingRect;
 			cv::Point2f m_position;
 			float_t m_radius;
 			std::string m_color;
-			cv::Mat m_ledMask;
+		};
+
+		// Horizontal run of LED mask pixels on device template
+		struct PixelRun
+		{
+			uint32_t m_offset; // y * template_width + x
+			uint32_t m_length;
+		};
+
+		// Sampled range of one LED in SamplingPlan
+		struct LedSampler
+		{
+			uint32_t m_ordinal;
+			uint32_t m_runBegin; // index of SamplingPlan::m_pixelRuns
+			uint32_t m_runEnd;
+			uint32_t m_pixelCount;
+		};
+
+		// Flat LED sampling plan of device template (compiled once by BeaconAnalyzer constructor)
+		struct SamplingPlan
+		{
+			std::vector<LedSampler> m_ledSamplers; // sorted by LED position (row-major)
+			std::vector<PixelRun> m_pixelRuns; // packed runs of all LEDs
+		};
+
+		// Device template resized for analysis (LED geometry is scaled to match)
+		struct AnalysisTemplate
+		{
+			double m_scale;
+			cv::Size m_templateSize;
+			std::array<cv::Point2f, 4> m_markerPositions; // homography dst points
+			SamplingPlan m_beaconSamplingPlan;
 		};
 
 		// Information of beacon device
@@ -30,17 +70,177 @@ namespace GCB
 		{
 			std::string m_deviceName;
 			cv::Size m_deviceTemplateSize;
-			std::unordered_map<std::string, LedData> m_markerHash;
-			std::unordered_map<std::string, LedData> m_beaconHash;
+			std::vector<LedData> m_markerList; // index: ordinal - 1
+			std::vector<LedData> m_beaconList; // index: ordinal - 1
+			std::vector<AnalysisTemplate> m_analysisTemplateList; // scale: 1, 1/2, 1/4, ... (head is full size)
+			double m_analysisScale; // default of DetectionResult::m_analysisScale ("analysis_scale" in JSON)
 		};
 	}
 
+	// Way of reading LED pixels in BeaconAnalyzer::analyzePicture
+	enum class SamplingMode
+	{
+		WARP_TEMPLATE, // warp device roi to template size, then read LED masks on it
+		SOURCE_ROI,    // project LED discs into device roi, then read only their source pixels (no warp)
+	};
+
+	// Special values of DetectionResult::m_analysisScale
+	constexpr double ANALYSIS_SCALE_DEVICE_DEFAULT = 0.0; // use scale of device definition
+	constexpr double ANALYSIS_SCALE_AUTO = -1.0;          // decide scale from m_positionRect size
+
 	// Device type and position of a detected beacon device
 	struct DetectionResult
 	{
 		cv::Rect2f m_positionRect;
 		std::string m_deviceName;
 		uint64_t m_deviceId;
+		SamplingMode m_samplingMode = SamplingMode::WARP_TEMPLATE;
+		double m_analysisScale = ANALYSIS_SCALE_DEVICE_DEFAULT; // template scale (0.0 < scale <= 1.0, or special value) used by SamplingMode::WARP_TEMPLATE
+		bool m_useMarkerTracking = false; // reuse markers of previous frame (BeaconAnalyzer::analyzePicture with TrackingState)
+	};
+
+	// Marker tracking state of one device across video frames (caller keeps one per DetectionResult, and passes frames in order)
+	struct TrackingState
+	{
+		bool m_isTracking = false;
+		std::array<cv::Point2f, 4> m_markerPoints; // marker points on device roi of previous frame (head: blue marker)
+		double m_lightnessThreshold = 0.0;         // Otsu threshold of last full detection
+		uint64_t m_trackedFrameNum = 0;            // frames confirmed by local search
+		uint64_t m_detectedFrameNum = 0;           // frames processed by full detection
+	};
+
+	// Stages of BeaconAnalyzer::analyzePicture measured by stage timers
+	enum class AnalysisStage : size_t
+	{
+		ANALYZE_PICTURE,       // whole analyzePicture
+		COLOR_CONVERSION,      // Lab / HSV conversion of device roi (full detection), Lab of template (fallback of fused kernel)
+		OTSU_THRESHOLD,        // lightness mask
+		CHANNEL_NORMALIZATION, // normalization of a* and b* in lightness mask
+		CONTOUR_DETECTION,     // cv::findContours
+		MARKER_EXTRACTION,     // green / blue marker selection
+		MARKER_TRACKING,       // local search around previous markers
+		HOMOGRAPHY,
+		WARP,
+		LED_SAMPLING,
+		STAGE_NUM,
+	};
+
+#ifdef GCB_STAGE_TIMING
+	constexpr bool STAGE_TIMING_ENABLED = true; // built with GCB_STAGE_TIMING
+#else
+	constexpr bool STAGE_TIMING_ENABLED = false;
+#endif
+
+	// Histograms of stage durations (log2 buckets of nanoseconds, one profile per thread, merged per job)
+	class StageTimingProfile
+	{
+	public:
+		static constexpr size_t BUCKET_NUM = 40; // bucket i: 2^i ~ 2^(i+1) nanoseconds
+
+		// Histogram of one stage
+		struct StageHistogram
+		{
+			std::array<uint64_t, BUCKET_NUM> m_bucketCounts{};
+			uint64_t m_sampleNum = 0;
+			uint64_t m_totalNanoseconds = 0;
+			uint64_t m_maxNanoseconds = 0;
+		};
+
+	private:
+		std::array<StageHistogram, static_cast<size_t>(AnalysisStage::STAGE_NUM)> m_stageHistograms;
+
+	public:
+		/// @brief add duration of stage
+		/// @param stage Measured stage
+		/// @param nanoseconds Duration
+		void addSample(const AnalysisStage &stage, const uint64_t &nanoseconds);
+
+		/// @brief add all samples of another profile
+		/// @param other Merged profile
+		void merge(const StageTimingProfile &other);
+
+		/// @brief get upper bound of percentile (resolution of log2 bucket)
+		/// @param stage Measured stage
+		/// @param percentile 0.0 ~ 1.0
+		/// @return Nanoseconds (0 if no sample)
+		uint64_t getPercentileNanoseconds(const AnalysisStage &stage, const double &percentile) const;
+
+		/// @brief get histograms as json ({"stage_name": {"count", "mean_us", "p50_us", ...}})
+		nlohmann::json getJson() const;
+
+		/// @brief getter stageHistogram
+		const StageHistogram &getStageHistogram(const AnalysisStage &stage) const { return m_stageHistograms[static_cast<size_t>(stage)]; }
+
+		/// @brief get bucket index of duration
+		/// @param nanoseconds Duration
+		/// @return floor(log2(nanoseconds)) (clamped into buckets)
+		static size_t getBucketIdx(const uint64_t &nanoseconds);
+
+		/// @brief get name of stage ("analyze_picture", "color_conversion", ...)
+		static const std::string &getStageName(const AnalysisStage &stage);
+	};
+
+	// Reusable buffers of BeaconAnalyzer::analyzePicture (grow to high-water size, never shrink; one per thread)
+	struct AnalyzerWorkspace
+	{
+		/* image buffers (continuous images are viewed on them) */
+		cv::Mat m_labBuffer;
+		cv::Mat m_hsvBuffer;
+		std::array<cv::Mat, 3> m_channelBuffers; // split channels of m_labBuffer
+		std::array<cv::Mat, 4> m_maskBuffers;    // beacon masks, lightness mask
+		cv::Mat m_normalizeBuffer;
+		cv::Mat m_contourMaskBuffer;
+		cv::Mat m_warpBuffer; // warped device roi (AnalyzationResult::m_analyzedPictureResult refers to it)
+		/* end: image buffers */
+
+		/* marker detection */
+		std::vector<std::vector<cv::Point>> m_contours;
+		std::vector<cv::Vec4i> m_hierarchy;
+		std::vector<cv::Point> m_shiftedContour;
+		std::vector<cv::Point> m_markerPixels; // marker pixels of tracking search window
+		std::vector<std::pair<int32_t, cv::Point2f>> m_greenMarkerList;
+		std::vector<std::pair<int32_t, cv::Point2f>> m_blueMarkerList;
+		std::vector<std::pair<int32_t, size_t>> m_markerAngleList;
+		std::vector<cv::Point2f> m_exceptPoints;
+		std::vector<cv::Point2f> m_markerPoints; // homography src points
+		/* end: marker detection */
+
+		StageTimingProfile m_stageTimingProfile; // filled only when built with GCB_STAGE_TIMING
+	};
+
+	// Stages of BeaconAnalyzer::analyzePicture (exposed for gcb-bench, applications use analyzePicture)
+	namespace Inside
+	{
+		/// @brief detect beacon_device_markers (green or blue LED x 4 <1:3>)
+		/// @param analyzed_picture Image which have LED markers
+		/// @param workspace Buffers of detection (four center points of detected markers are set to m_markerPoints, empty if not found)
+		/// @param lightness_threshold Otsu threshold of lightness used for detection (output)
+		void detect_beacon_device_markers(const cv::Mat &analyzed_picture, AnalyzerWorkspace &workspace,
+																			double &lightness_threshold);
+
+		/// @brief analyze LED_pattern
+		/// @param analyzed_picture Image which has analyzed LED beacons (warped to "analysis_template")
+		/// @param device_definition DeviceDefinition object
+		/// @param analysis_template Template which "analyzed_picture" is warped to
+		/// @param workspace Buffers of Lab image (used only when fused kernel is out of tolerance)
+		/// @param led_pattern_list Analyzed LED Pattern (Level of 0~31, index: beacon ordinal - 1)
+		void analyze_led_pattern(
+				const cv::Mat &analyzed_picture,
+				const DeviceDefinition &device_definition,
+				const AnalysisTemplate &analysis_template,
+				AnalyzerWorkspace &workspace,
+				std::vector<uint8_t> &led_pattern_list);
+	}
+
+	// Counter of heap allocations (counts only when built with GCB_COUNT_ALLOCATIONS)
+	namespace AllocationCounter
+	{
+		/// @brief whether allocations are counted
+		bool is_enabled();
+
+		/// @brief get number of allocations by calling thread (operator new and cv::Mat buffers)
+		/// @return Number of allocations since thread start (always 0 when disabled)
+		uint64_t get_thread_allocation_num();
 	};
 
 	// Analysis result of LED lighting patterns by BeaconAnalyzer class
@@ -49,8 +249,9 @@ namespace GCB
 		std::string m_deviceName;
 		uint64_t m_deviceId; // Use only when GCB::AnalyzationResultWriter::getJsonString called
 		cv::Rect m_devicePositionRect;
-		std::unordered_map<std::string, uint8_t> m_ledPatternHash;
-		cv::Mat m_analyzedPictureResult;
+		std::vector<uint8_t> m_ledPatternList; // index: beacon ordinal - 1
+		cv::Mat m_analyzedPictureResult; // empty when analyzed by SamplingMode::SOURCE_ROI
+		bool m_isMarkerFound = false; // false: markers are not found, m_ledPatternList is dummy (all 0)
 	};
 
 	// Analyzer of LED beacon patterns on device
@@ -74,12 +275,32 @@ namespace GCB
 		/// @brief output device_definitions
 		void dump_device_definitions() const;
 
-		/// @brief analyze LED lighting patterns on beacon device located in picture
+		/// @brief analyze LED lighting patterns on beacon device located in picture (thread-safe: may be called concurrently)
 		/// @param picture Picture used for detection and analyzed
 		/// @param detection_result Device type and position of a detected beacon device (in the "picture")
 		/// @return Analysis result of LED lighting patterns
 		AnalyzationResult analyzePicture(const cv::Mat &picture, const DetectionResult &detection_result) const;
 
+		/// @brief analyze LED lighting patterns on beacon device located in video frame (thread-safe: may be called concurrently)
+		/// @param picture Video frame used for detection and analyzed
+		/// @param detection_result Device type and position of a detected beacon device (in the "picture")
+		/// @param tracking_state Marker tracking state of this device (updated for next frame, must not be shared by threads)
+		/// @return Analysis result of LED lighting patterns
+		AnalyzationResult analyzePicture(
+				const cv::Mat &picture, const DetectionResult &detection_result,
+				TrackingState &tracking_state) const;
+
+		/// @brief analyze LED lighting patterns into caller's buffers (no allocation after buffers reach high-water size)
+		/// @param picture Video frame used for detection and analyzed
+		/// @param detection_result Device type and position of a detected beacon device (in the "picture")
+		/// @param tracking_state Marker tracking state of this device (updated for next frame, must not be shared by threads)
+		/// @param workspace Buffers used by analysis (must not be shared by threads)
+		/// @param analyzation_result Analysis result (output, m_analyzedPictureResult refers to "workspace" until next call)
+		void analyzePicture(
+				const cv::Mat &picture, const DetectionResult &detection_result,
+				TrackingState &tracking_state, AnalyzerWorkspace &workspace,
+				AnalyzationResult &analyzation_result) const;
+
 		const std::vector<std::string> &getDeviceNames() const { return m_deviceNames; }
 
 		/// @brief getter deviceDefinitions
@@ -122,4 +343,178 @@ namespace GCB
 		/// @return String (Json content)
 		std::string getJsonString(const uint64_t &frame_count = 0);
 	};
+
+	/// @brief get detection results from request JSON ({"device_key": [...], "<device_key>": {"device_name", "device_id", "rect_x", ...}})
+	/// @param json_string Request JSON string
+	/// @return Detection results (order of "device_key", throws std::invalid_argument on invalid option value)
+	std::vector<DetectionResult> get_detection_result_list_from_json(const std::string &json_string);
+
+	// Decoder thread reading video frames ahead of consumers into pooled buffers
+	class FrameDecoder
+	{
+	public:
+		// Decoded frame lent to consumer (give back by releaseFrame)
+		struct DecodedFrame
+		{
+			uint64_t m_frameCount = 0;
+			size_t m_bufferIdx = 0;
+			cv::Mat m_image; // shares pooled buffer
+		};
+
+	private:
+		cv::VideoCapture &m_videoCap;
+		std::vector<cv::Mat> m_framePool;
+		Pipeline::BoundedQueue<size_t> m_freeBufferQueue; // decoder <- consumers
+		Pipeline::BoundedQueue<std::pair<uint64_t, size_t>> m_decodedFrameQueue; // decoder -> consumers (frame_count, buffer_idx)
+		Pipeline::Notifier m_freeBufferNotifier;   // decoder waits for free buffer
+		Pipeline::Notifier m_decodedFrameNotifier; // consumers wait for decoded frame
+		std::atomic<bool> m_isFinished;
+		std::atomic<bool> m_isStopped;
+		std::atomic<uint64_t> m_decodedFrameNum;
+		std::atomic<uint64_t> m_decodeNanoseconds;
+		std::thread m_decodeThread;
+
+		/// @brief decoder thread's loop
+		void decodeFrames();
+
+	public:
+		/// @brief constructor (start decoder thread)
+		/// @param video_cap Opened video (must outlive this object)
+		/// @param buffer_num Number of pooled frame buffers (decoder waits when all buffers are lent)
+		FrameDecoder(cv::VideoCapture &video_cap, const size_t &buffer_num);
+
+		/// @brief destructor (stop and join decoder thread)
+		~FrameDecoder();
+
+		/* forbid copy action */
+		FrameDecoder(const FrameDecoder &other) = delete;
+		FrameDecoder &operator=(const FrameDecoder &other) = delete;
+		/* end: forbid copy action */
+
+		/// @brief take next decoded frame (wait until decoded, thread-safe)
+		/// @param decoded_frame Decoded frame (output)
+		/// @return false at the end of video
+		bool acquireFrame(DecodedFrame &decoded_frame);
+
+		/// @brief give back frame buffer to decoder (thread-safe)
+		/// @param decoded_frame Frame taken by acquireFrame
+		void releaseFrame(DecodedFrame &decoded_frame);
+
+		/// @brief stop decoding (acquireFrame returns false after queued frames)
+		void stop();
+
+		/// @brief getter decodedFrameNum
+		uint64_t getDecodedFrameNum() const { return m_decodedFrameNum.load(std::memory_order_relaxed); }
+
+		/// @brief get time spent in decoding
+		double getDecodeSeconds() const { return static_cast<double>(m_decodeNanoseconds.load(std::memory_order_relaxed)) * 1e-9; }
+	};
+
+	// Throughput of video analysis (decode and analysis are measured separately)
+	struct VideoAnalysisStatistics
+	{
+		uint64_t m_frameNum = 0;
+		double m_decodeSeconds = 0.0;   // time of decoder thread spent in reading frames
+		double m_analysisSeconds = 0.0; // sum of worker time spent in analyzePicture
+		double m_elapsedSeconds = 0.0;  // wall-clock time of whole video
+		uint64_t m_steadyAllocationNum = 0; // allocations of workers after their first frame (AllocationCounter)
+		uint64_t m_trackedFrameNum = 0;      // frames whose markers of all devices are tracked (no full detection)
+		uint64_t m_trackedAllocationNum = 0; // allocations of workers on tracked frames after their first one
+		StageTimingProfile m_stageTimingProfile; // stages of all workers (GCB_STAGE_TIMING)
+		std::vector<uint64_t> m_frameLatencyNanoseconds; // from frame taken by worker to its result merged (index: frame count)
+	};
+
+	// Slots of concurrent frame analysis shared by video analyzers (granted in FIFO order, fair between videos)
+	class AnalysisSlotPool
+	{
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_slotCv;
+		uint32_t m_slotNum;
+		uint32_t m_freeSlotNum;
+		uint64_t m_nextTicket;    // ticket of next waiter
+		uint64_t m_servingTicket; // ticket granted next
+
+	public:
+		/// @brief constructor
+		/// @param slot_num Number of frames analyzed at the same time (0: number of hardware threads)
+		explicit AnalysisSlotPool(const uint32_t &slot_num = 0);
+
+		/* forbid copy action */
+		AnalysisSlotPool(const AnalysisSlotPool &other) = delete;
+		AnalysisSlotPool &operator=(const AnalysisSlotPool &other) = delete;
+		/* end: forbid copy action */
+
+		/// @brief take slot (wait until earlier waiters are granted and slot is free, thread-safe)
+		void acquireSlot();
+
+		/// @brief give back slot taken by acquireSlot (thread-safe)
+		void releaseSlot();
+
+		/// @brief getter slotNum
+		const uint32_t &getSlotNum() const { return m_slotNum; }
+	};
+
+	// Frame-parallel analyzer of video (frames are analyzed by worker threads, results are merged in frame order)
+	class VideoAnalyzer
+	{
+	public:
+		/// @brief callback receiving analysis results of one frame (called in frame order, on caller's thread)
+		using FrameResultCallback =
+				std::function<void(const uint64_t &frame_count, const std::vector<AnalyzationResult> &analyzation_result_list)>;
+
+		/// @brief callback receiving analysis results of one frame with the frame (called in frame order, on caller's thread)
+		using AnalyzedFrameCallback =
+				std::function<void(const uint64_t &frame_count, const cv::Mat &frame,
+													 const std::vector<AnalyzationResult> &analyzation_result_list)>;
+
+		// consecutive frames analyzed by one worker when marker tracking is used (first one by full detection)
+		static constexpr size_t TRACKING_SEGMENT_FRAME_NUM = 8;
+
+	private:
+		const BeaconAnalyzer &m_beaconAnalyzer;
+		uint32_t m_workerNum;
+		AnalysisSlotPool *m_ptrSlotPool; // nullptr: workers analyze without slots
+
+		/// @brief analyze all frames of video (frame buffers are kept until merged if is_frame_retained)
+		VideoAnalysisStatistics analyzeFrames(
+				cv::VideoCapture &video_cap,
+				const std::vector<DetectionResult> &detection_result_list,
+				const AnalyzedFrameCallback &analyzed_frame_callback,
+				const bool &is_frame_retained) const;
+
+	public:
+		/// @brief constructor
+		/// @param beacon_analyzer Analyzer shared by all worker threads (must outlive this object)
+		/// @param worker_num Number of worker threads (0: number of hardware threads, or slots of ptr_slot_pool)
+		/// @param ptr_slot_pool Slots shared with other videos, each frame is analyzed holding one slot (must outlive this object)
+		VideoAnalyzer(const BeaconAnalyzer &beacon_analyzer, const uint32_t &worker_num = 0,
+									AnalysisSlotPool *ptr_slot_pool = nullptr);
+
+		/// @brief destructor (non action)
+		~VideoAnalyzer() {}
+
+		/// @brief analyze all frames of video
+		/// @param video_cap Opened video
+		/// @param detection_result_list Devices analyzed in every frame
+		/// @param frame_result_callback Receiver of frame results (m_analyzedPictureResult is released to bound memory)
+		/// @return Number of analyzed frames and throughput
+		VideoAnalysisStatistics analyzeVideo(
+				cv::VideoCapture &video_cap,
+				const std::vector<DetectionResult> &detection_result_list,
+				const FrameResultCallback &frame_result_callback) const;
+
+		/// @brief analyze all frames of video, results are merged with their frames (e.g. to render them without decoding again)
+		/// @param video_cap Opened video
+		/// @param detection_result_list Devices analyzed in every frame
+		/// @param analyzed_frame_callback Receiver of frames and results (frame buffer is given back to decoder after return)
+		/// @return Number of analyzed frames and throughput
+		VideoAnalysisStatistics analyzeVideo(
+				cv::VideoCapture &video_cap,
+				const std::vector<DetectionResult> &detection_result_list,
+				const AnalyzedFrameCallback &analyzed_frame_callback) const;
+
+		/// @brief getter workerNum
+		const uint32_t &getWorkerNum() const { return m_workerNum; }
+	};
 };
\ No newline at end of file
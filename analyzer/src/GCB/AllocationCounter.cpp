@@ -0,0 +1,86 @@
+#include "../GCB.hpp"
+
+#ifdef GCB_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+static thread_local uint64_t g_thread_allocation_num = 0; // trivially initialized (safe in operator new)
+
+/* count operator new (operator new[] and nothrow versions are forwarded to these) */
+void *operator new(std::size_t size)
+{
+  g_thread_allocation_num++;
+  if (auto ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  g_thread_allocation_num++;
+  const auto align = static_cast<std::size_t>(alignment);
+  // aligned_alloc requires size of multiple of alignment
+  if (auto ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { std::free(ptr); }
+/* end: count operator new */
+
+// Counter of cv::Mat buffers (OpenCV allocates them by cv::fastMalloc, not by operator new)
+class CountingMatAllocator : public cv::MatAllocator
+{
+private:
+  cv::MatAllocator *m_baseAllocator;
+
+public:
+  CountingMatAllocator(cv::MatAllocator *base_allocator) : m_baseAllocator(base_allocator) {}
+
+  cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step,
+                         cv::AccessFlag flags, cv::UMatUsageFlags usage_flags) const override
+  {
+    // user data (e.g. workspace views) is not allocated
+    if (data == nullptr)
+      g_thread_allocation_num++;
+
+    return m_baseAllocator->allocate(dims, sizes, type, data, step, flags, usage_flags);
+  }
+
+  bool allocate(cv::UMatData *data, cv::AccessFlag access_flags, cv::UMatUsageFlags usage_flags) const override
+  {
+    return m_baseAllocator->allocate(data, access_flags, usage_flags);
+  }
+
+  void deallocate(cv::UMatData *data) const override { m_baseAllocator->deallocate(data); }
+};
+
+/// @brief install counting allocator as default allocator of cv::Mat
+/// @return true
+static bool install_counting_mat_allocator()
+{
+  static CountingMatAllocator counting_mat_allocator(cv::Mat::getStdAllocator());
+  cv::Mat::setDefaultAllocator(&counting_mat_allocator);
+
+  return true;
+}
+
+static const bool g_is_counting_mat_allocator_installed = install_counting_mat_allocator();
+
+bool GCB::AllocationCounter::is_enabled() { return g_is_counting_mat_allocator_installed; }
+
+uint64_t GCB::AllocationCounter::get_thread_allocation_num() { return g_thread_allocation_num; }
+
+#else
+
+bool GCB::AllocationCounter::is_enabled() { return false; }
+
+uint64_t GCB::AllocationCounter::get_thread_allocation_num() { return 0; }
+
+#endif
@@ -0,0 +1,34 @@
+#include "../GCB.hpp"
+
+using namespace GCB;
+
+AnalysisSlotPool::AnalysisSlotPool(const uint32_t &slot_num)
+    : m_slotNum(slot_num), m_freeSlotNum(0), m_nextTicket(0), m_servingTicket(0)
+{
+  if (m_slotNum == 0)
+    m_slotNum = std::max(1U, std::thread::hardware_concurrency());
+  m_freeSlotNum = m_slotNum;
+}
+
+void AnalysisSlotPool::acquireSlot()
+{
+  std::unique_lock<std::mutex> slot_lock(m_mutex);
+  const auto ticket = m_nextTicket++;
+  m_slotCv.wait(slot_lock, [&]()
+                { return ticket == m_servingTicket && m_freeSlotNum > 0; });
+
+  m_servingTicket++;
+  m_freeSlotNum--;
+  // next waiter may be granted a remaining slot
+  slot_lock.unlock();
+  m_slotCv.notify_all();
+}
+
+void AnalysisSlotPool::releaseSlot()
+{
+  {
+    std::lock_guard<std::mutex> slot_lock(m_mutex);
+    m_freeSlotNum++;
+  }
+  m_slotCv.notify_all();
+}
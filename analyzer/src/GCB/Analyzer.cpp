@@ -1,17 +1,28 @@
 #include "../GCB.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cfloat>
 #include <cmath>
 #include <fstream>
+#include <mutex>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
 #include "ImgFunc.hpp"
 #include "GCB.hpp"
+#include "StageTimer.hpp"
 
 using namespace GCB;
 using namespace Inside;
 
+static constexpr size_t ANALYSIS_TEMPLATE_LEVEL_NUM = 5; // scale: 1, 1/2, 1/4, 1/8, 1/16
+
+static constexpr int32_t LAB_B_KERNEL_TOLERANCE = 1; // max difference of b* per pixel between ImgColor kernel and cv::cvtColor
+
+static std::mutex g_log_mutex; // analyzePicture is called by several threads (std::cout may be unsynchronized with stdio)
+
 /// @brief output content of LedData object
 /// @param led_label Led_data' ID
 /// @param led_data Browsed data
@@ -29,10 +40,10 @@ static void dump_led_data(const std::string &led_label, const LedData &led_data)
 static void dump_device_definition(const DeviceDefinition &definition)
 {
   std::cout << "*[" + definition.m_deviceName + "]*" << std::endl;
-  for (const auto &[key, led_data] : definition.m_markerHash)
-    dump_led_data("marker_" + key, led_data);
-  for (const auto &[key, led_data] : definition.m_beaconHash)
-    dump_led_data("beacon_" + key, led_data);
+  for (const auto &led_data : definition.m_markerList)
+    dump_led_data("marker_ID" + std::to_string(led_data.m_ordinal), led_data);
+  for (const auto &led_data : definition.m_beaconList)
+    dump_led_data("beacon_ID" + std::to_string(led_data.m_ordinal), led_data);
   std::cout << std::endl;
 }
 
@@ -55,46 +66,241 @@ static std::string read_file(const std::string &file_path)
   return file_content;
 }
 
+/// @brief get bounding rect of LED circle
+/// @param position LED's center position
+/// @param radius LED's radius
+/// @return Bounding rect
+static cv::Rect get_led_bounding_rect(const cv::Point2f &position, const float_t &radius)
+{
+  const auto led_mask_rect_tl = position - cv::Point2f(radius, radius);
+  const auto led_mask_rect_br = position + cv::Point2f(radius, radius);
+  return cv::Rect(led_mask_rect_tl, led_mask_rect_br);
+}
+
 /// @brief get LedData from JSON
 /// @param led_json JSON object
-/// @param device_template_size Size of device template image
+/// @param led_ordinal Number of "ID" key
 /// @return LedData object
-static LedData get_led_data_from_json(
-    const nlohmann::json &led_json,
-    const cv::Size &device_template_size)
+static LedData get_led_data_from_json(const nlohmann::json &led_json, const uint32_t &led_ordinal)
 {
   LedData led_data;
+  led_data.m_ordinal = led_ordinal;
   led_data.m_position.x = led_json["center_x"];
   led_data.m_position.y = led_json["center_y"];
   led_data.m_radius = led_json["radius"];
   led_data.m_color = led_json["color"];
 
-  /* decide calculated area */
-  const auto led_mask_rect_tl = led_data.m_position - cv::Point2f(led_data.m_radius, led_data.m_radius);
-  const auto led_mask_rect_br = led_data.m_position + cv::Point2f(led_data.m_radius, led_data.m_radius);
-  led_data.m_boundingRect = cv::Rect(led_mask_rect_tl, led_mask_rect_br);
-
-  cv::Mat led_mask = cv::Mat::zeros(device_template_size, CV_8UC1);
-  cv::circle(led_mask, led_data.m_position, static_cast<int32_t>(led_data.m_radius), cv::Scalar(255, 0, 0), -1);
-  led_data.m_ledMask = ImgSize::get_img_roi(led_mask, led_data.m_boundingRect).clone();
-  /* end: decide calculated area */
+  led_data.m_boundingRect = get_led_bounding_rect(led_data.m_position, led_data.m_radius);
 
   return led_data;
 }
 
+/// @brief get "analysis_scale" of device definition or request
+/// @param analysis_scale_json JSON value ("auto" or number)
+/// @return Scale (0.0 < scale <= 1.0) or ANALYSIS_SCALE_AUTO (throws std::invalid_argument on other values)
+static double get_analysis_scale_from_json(const nlohmann::json &analysis_scale_json)
+{
+  if (analysis_scale_json.is_string() && analysis_scale_json.get<std::string>() == "auto")
+    return ANALYSIS_SCALE_AUTO;
+
+  if (analysis_scale_json.is_number())
+  {
+    const auto analysis_scale = analysis_scale_json.get<double>();
+    if (analysis_scale > 0.0 && analysis_scale <= 1.0)
+      return analysis_scale;
+  }
+
+  throw std::invalid_argument("analysis_scale must be \"auto\" or a number in (0, 1]: " + analysis_scale_json.dump());
+}
+
+/// @brief get LedData scaled for analysis template
+/// @param led_data Original LedData object
+/// @param scale Template scale
+/// @return Scaled LedData object
+static LedData get_scaled_led_data(const LedData &led_data, const double &scale)
+{
+  LedData scaled_led_data = led_data;
+  scaled_led_data.m_position = led_data.m_position * static_cast<float_t>(scale);
+  scaled_led_data.m_radius = led_data.m_radius * static_cast<float_t>(scale);
+  scaled_led_data.m_boundingRect = get_led_bounding_rect(scaled_led_data.m_position, scaled_led_data.m_radius);
+
+  return scaled_led_data;
+}
+
+/// @brief compile flat sampling plan of LEDs (pixels are the same as LED circle masks on device template)
+/// @param led_list LedData list
+/// @param device_template_size Size of device template image
+/// @return SamplingPlan object
+static SamplingPlan compile_sampling_plan(const std::vector<LedData> &led_list, const cv::Size &device_template_size)
+{
+  // read LEDs in memory order of template image
+  std::vector<const LedData *> sorted_led_list;
+  for (const auto &led_data : led_list)
+    sorted_led_list.push_back(&led_data);
+  std::sort(sorted_led_list.begin(), sorted_led_list.end(),
+            [](const auto &a, const auto &b)
+            {
+              return std::tie(a->m_boundingRect.y, a->m_boundingRect.x) < std::tie(b->m_boundingRect.y, b->m_boundingRect.x);
+            });
+
+  SamplingPlan sampling_plan;
+  for (const auto &led_data : sorted_led_list)
+  {
+    // rounding of scaled template may push bounding rect out of template
+    const auto bounding_rect = led_data->m_boundingRect & cv::Rect(cv::Point(0, 0), device_template_size);
+
+    /* draw LED circle mask only in its bounding rect */
+    cv::Mat led_mask = cv::Mat::zeros(bounding_rect.size(), CV_8UC1);
+    const auto led_center = cv::Point(static_cast<cv::Point>(led_data->m_position) - bounding_rect.tl());
+    cv::circle(led_mask, led_center, static_cast<int32_t>(led_data->m_radius), cv::Scalar(255, 0, 0), -1);
+    /* end: draw LED circle mask only in its bounding rect */
+
+    /* pack mask rows into pixel runs */
+    LedSampler led_sampler;
+    led_sampler.m_ordinal = led_data->m_ordinal;
+    led_sampler.m_runBegin = static_cast<uint32_t>(sampling_plan.m_pixelRuns.size());
+    led_sampler.m_pixelCount = 0U;
+    for (int32_t y = 0; y < led_mask.rows; y++)
+    {
+      const auto mask_row = led_mask.ptr<uint8_t>(y);
+      int32_t x = 0;
+      while (x < led_mask.cols)
+      {
+        if (mask_row[x] == 0)
+        {
+          x++;
+          continue;
+        }
+
+        const auto run_begin_x = x;
+        while (x < led_mask.cols && mask_row[x] != 0)
+          x++;
+
+        PixelRun pixel_run;
+        pixel_run.m_offset = static_cast<uint32_t>(
+            (bounding_rect.y + y) * device_template_size.width + bounding_rect.x + run_begin_x);
+        pixel_run.m_length = static_cast<uint32_t>(x - run_begin_x);
+        sampling_plan.m_pixelRuns.push_back(pixel_run);
+        led_sampler.m_pixelCount += pixel_run.m_length;
+      }
+    }
+    led_sampler.m_runEnd = static_cast<uint32_t>(sampling_plan.m_pixelRuns.size());
+    /* end: pack mask rows into pixel runs */
+
+    sampling_plan.m_ledSamplers.push_back(led_sampler);
+  }
+
+  return sampling_plan;
+}
+
+/// @brief create device template resized for analysis
+/// @param marker_list Marker LedData list of full size template
+/// @param beacon_list Beacon LedData list of full size template
+/// @param device_template_size Size of full size template
+/// @param scale Template scale
+/// @return AnalysisTemplate object
+static AnalysisTemplate create_analysis_template(
+    const std::vector<LedData> &marker_list, const std::vector<LedData> &beacon_list,
+    const cv::Size &device_template_size, const double &scale)
+{
+  AnalysisTemplate analysis_template;
+  analysis_template.m_scale = scale;
+  analysis_template.m_templateSize =
+      cv::Size(static_cast<int32_t>(std::lround(device_template_size.width * scale)),
+               static_cast<int32_t>(std::lround(device_template_size.height * scale)));
+
+  for (size_t marker_idx = 0; marker_idx < analysis_template.m_markerPositions.size(); marker_idx++)
+    analysis_template.m_markerPositions[marker_idx] = marker_list.at(marker_idx).m_position * static_cast<float_t>(scale);
+
+  std::vector<LedData> scaled_beacon_list;
+  for (const auto &beacon : beacon_list)
+    scaled_beacon_list.push_back(get_scaled_led_data(beacon, scale));
+  analysis_template.m_beaconSamplingPlan = compile_sampling_plan(scaled_beacon_list, analysis_template.m_templateSize);
+
+  return analysis_template;
+}
+
+/// @brief select analysis template for detected device
+/// @param device_definition DeviceDefinition object
+/// @param detection_result Detected device (its m_analysisScale and m_positionRect are used)
+/// @return Smallest template whose scale is not less than requested scale
+static const AnalysisTemplate &select_analysis_template(
+    const DeviceDefinition &device_definition, const DetectionResult &detection_result)
+{
+  auto scale = detection_result.m_analysisScale;
+  if (scale == ANALYSIS_SCALE_DEVICE_DEFAULT)
+    scale = device_definition.m_analysisScale;
+
+  // fit template to pixel footprint of device roi
+  if (scale < 0.0)
+  {
+    const auto &template_size = device_definition.m_deviceTemplateSize;
+    scale = std::max(detection_result.m_positionRect.width / static_cast<double>(template_size.width),
+                     detection_result.m_positionRect.height / static_cast<double>(template_size.height));
+  }
+
+  const auto &analysis_template_list = device_definition.m_analysisTemplateList;
+  for (auto iter = analysis_template_list.rbegin(); iter != analysis_template_list.rend(); iter++)
+  {
+    if (iter->m_scale >= scale)
+      return *iter;
+  }
+
+  return analysis_template_list.front();
+}
+
+/// @brief get continuous image on workspace buffer (buffer grows to high-water size, never shrinks)
+/// @param buffer Workspace buffer
+/// @param img_size Size of image
+/// @param img_type Type of image (CV_8UC1, CV_8UC3, ...)
+/// @return Image sharing "buffer" (valid until "buffer" grows)
+static cv::Mat get_buffer_img(cv::Mat &buffer, const cv::Size &img_size, const int32_t &img_type)
+{
+  const auto img_bytes = static_cast<size_t>(img_size.area()) * static_cast<size_t>(CV_ELEM_SIZE(img_type));
+  if (buffer.total() < img_bytes)
+    buffer.create(1, static_cast<int32_t>(img_bytes), CV_8UC1);
+
+  return cv::Mat(img_size, img_type, buffer.data);
+}
+
+/// @brief normalize image (cv::NORM_MINMAX) in region of mask, in place (same result as cv::normalize with mask)
+/// @param img Normalized image
+/// @param min_value Minimum value after normalization
+/// @param max_value Maximum value after normalization
+/// @param mask Specifying normalized range
+/// @param normalize_buffer Workspace buffer of converted image
+static void normalize_img_with_mask(cv::Mat &img, const double &min_value, const double &max_value,
+                                    const cv::Mat &mask, cv::Mat &normalize_buffer)
+{
+  double img_min_value = 0.0, img_max_value = 0.0;
+  cv::minMaxIdx(img, &img_min_value, &img_max_value, nullptr, nullptr, mask);
+
+  const auto img_range = img_max_value - img_min_value;
+  const auto scale = (max_value - min_value) * ((img_range > DBL_EPSILON) ? 1.0 / img_range : 0.0);
+  const auto shift = min_value - img_min_value * scale;
+
+  auto normalized_img = get_buffer_img(normalize_buffer, img.size(), img.type());
+  img.convertTo(normalized_img, img.type(), scale, shift);
+  normalized_img.copyTo(img, mask);
+}
+
 /// @brief detect markers using circularity and color and lightness
 /// @param contours Detected contours
 /// @param value_calculate_callback function (ImgProc::sum or ImgProc::mean)
 /// @param lightness_img Lightness channel image
 /// @param single_color_img Single channel image
-/// @return Pair of ixel value and center position of marker list
-static std::vector<std::pair<int32_t, cv::Point2f>> extract_marker_list(
+/// @param except_points Center points of contours not to be markers
+/// @param workspace Buffers of contour mask
+/// @param marker_list Pair of pixel value and center position of markers (output, sorted by value)
+static void extract_marker_list(
     const std::vector<std::vector<cv::Point>> &contours,
     const std::function<double(const cv::Mat &, const cv::Mat &)> value_calculate_callback,
     const cv::Mat &lightness_img, const cv::Mat &single_color_img,
-    const std::vector<cv::Point2f> &except_points = std::vector<cv::Point2f>())
+    const std::vector<cv::Point2f> &except_points,
+    AnalyzerWorkspace &workspace,
+    std::vector<std::pair<int32_t, cv::Point2f>> &marker_list)
 {
-  std::vector<std::pair<int32_t, cv::Point2f>> marker_list;
+  marker_list.clear();
   for (const auto &contour : contours)
   {
     // erase tiny-area contour
@@ -109,11 +315,16 @@ static std::vector<std::pair<int32_t, cv::Point2f>> extract_marker_list(
     if (std::find(except_points.begin(), except_points.end(), contour_center) != except_points.end())
       continue;
 
-    cv::Mat circle_mask = cv::Mat::zeros(lightness_img.size(), CV_8UC1);
-    cv::fillConvexPoly(circle_mask, contour, cv::Scalar(255, 0, 0));
-
+    // draw contour on mask of bounding rect only (same pixels as cropped full-size mask)
     const auto bounding_rect = cv::boundingRect(contour);
-    circle_mask = ImgSize::get_img_roi(circle_mask, bounding_rect).clone();
+    workspace.m_shiftedContour.clear();
+    for (const auto &point : contour)
+      workspace.m_shiftedContour.push_back(point - bounding_rect.tl());
+
+    auto circle_mask = get_buffer_img(workspace.m_contourMaskBuffer, bounding_rect.size(), CV_8UC1);
+    circle_mask.setTo(cv::Scalar(0));
+    cv::fillConvexPoly(circle_mask, workspace.m_shiftedContour, cv::Scalar(255, 0, 0));
+
     const auto single_color_img_roi = ImgSize::get_img_roi(single_color_img, bounding_rect);
     /* end: create contour_mask for calculating pixel value in only region of contour */
 
@@ -124,22 +335,23 @@ static std::vector<std::pair<int32_t, cv::Point2f>> extract_marker_list(
   std::sort(marker_list.begin(), marker_list.end(),
             [](const auto &a, const auto &b)
             { return a.first > b.first; });
-
-  return marker_list;
 }
 
 /// @brief arrange and get markers so that blue marker is the head: direction -> clockwise
 /// @param rotate_base_point Rotate base point
 /// @param blue_marker_center Blue marker's center position
 /// @param green_marker_centers Green markers' center position
-/// @return Arranged marker's center position list, head is blue marker
-static std::vector<cv::Point2f> get_clockwise_direction_markers(
+/// @param angle_to_idx_conversion_list Buffer of green markers' angle
+/// @param detected_marker_points Arranged marker's center position list, head is blue marker (output)
+static void get_clockwise_direction_markers(
     const cv::Point2f &rotate_base_point,
     const std::vector<std::pair<int32_t, cv::Point2f>> &blue_marker_centers,
-    const std::vector<std::pair<int32_t, cv::Point2f>> &green_marker_centers)
+    const std::vector<std::pair<int32_t, cv::Point2f>> &green_marker_centers,
+    std::vector<std::pair<int32_t, size_t>> &angle_to_idx_conversion_list,
+    std::vector<cv::Point2f> &detected_marker_points)
 {
   const auto &blue_marker_center = blue_marker_centers.at(0).second;
-  std::vector<std::pair<int32_t, size_t>> angle_to_idx_conversion_list;
+  angle_to_idx_conversion_list.clear();
 
   for (size_t marker_idx = 0; marker_idx < green_marker_centers.size(); marker_idx++)
   {
@@ -159,81 +371,185 @@ static std::vector<cv::Point2f> get_clockwise_direction_markers(
             [](const auto &a, const auto &b)
             { return a.first < b.first; });
 
-  std::vector<cv::Point2f> detected_marker_points{blue_marker_center};
+  detected_marker_points.clear();
+  detected_marker_points.push_back(blue_marker_center);
   for (const auto &angle_to_idx_conversion : angle_to_idx_conversion_list)
   {
     const auto &green_marker_idx = angle_to_idx_conversion.second;
     const auto &green_marker_center = green_marker_centers.at(green_marker_idx).second;
     detected_marker_points.push_back(green_marker_center);
   }
-
-  return detected_marker_points;
 }
 
-/// @brief detect beacon_device_markers (green or blue LED x 4 <1:3>)
-/// @param analyzed_picture Image which have LED markers
-/// @return Four center points of detected beacon_device_markers
-static std::vector<cv::Point2f> detect_beacon_device_markers(const cv::Mat &analyzed_picture)
+void GCB::Inside::detect_beacon_device_markers(const cv::Mat &analyzed_picture, AnalyzerWorkspace &workspace,
+                                               double &lightness_threshold)
 {
+  workspace.m_markerPoints.clear();
+  const auto analyzed_picture_size = analyzed_picture.size();
+
   /* split color_channels (Lab space, hsv space) */
-  cv::Mat analyzed_picture_lab;
+  GCB_STAGE_TIMER(color_conversion_timer, workspace.m_stageTimingProfile, AnalysisStage::COLOR_CONVERSION);
+  auto analyzed_picture_lab = get_buffer_img(workspace.m_labBuffer, analyzed_picture_size, CV_8UC3);
   cv::cvtColor(analyzed_picture, analyzed_picture_lab, cv::COLOR_BGR2Lab);
-  std::vector<cv::Mat> analyzed_picture_lab_list;
-  cv::split(analyzed_picture_lab, analyzed_picture_lab_list);
+  std::array<cv::Mat, 3> analyzed_picture_lab_list;
+  for (size_t channel_idx = 0; channel_idx < analyzed_picture_lab_list.size(); channel_idx++)
+    analyzed_picture_lab_list[channel_idx] =
+        get_buffer_img(workspace.m_channelBuffers[channel_idx], analyzed_picture_size, CV_8UC1);
+  cv::split(analyzed_picture_lab, analyzed_picture_lab_list.data());
   auto &analyzed_picture_l = analyzed_picture_lab_list.at(0);
   auto &analyzed_picture_lab_g = analyzed_picture_lab_list.at(1);
   auto &analyzed_picture_lab_b = analyzed_picture_lab_list.at(2);
 
-  cv::Mat analyzed_picture_hsv, beacon_mask_1, beacon_mask_2, beacon_mask;
+  auto analyzed_picture_hsv = get_buffer_img(workspace.m_hsvBuffer, analyzed_picture_size, CV_8UC3);
+  auto beacon_mask_1 = get_buffer_img(workspace.m_maskBuffers[0], analyzed_picture_size, CV_8UC1);
+  auto beacon_mask_2 = get_buffer_img(workspace.m_maskBuffers[1], analyzed_picture_size, CV_8UC1);
+  auto beacon_mask = get_buffer_img(workspace.m_maskBuffers[2], analyzed_picture_size, CV_8UC1);
   cv::cvtColor(analyzed_picture, analyzed_picture_hsv, cv::COLOR_BGR2HSV);
   cv::inRange(analyzed_picture_hsv, cv::Scalar(0, 0, 0), cv::Scalar(40, 255, 255), beacon_mask_1);
   cv::inRange(analyzed_picture_hsv, cv::Scalar(150, 0, 0), cv::Scalar(180, 255, 255), beacon_mask_2);
   cv::bitwise_or(beacon_mask_1, beacon_mask_2, beacon_mask);
+  GCB_STAGE_TIMER_STOP(color_conversion_timer);
   /* end: split color_channels (Lab space, hsv space) */
 
   /* preprocess */
-  cv::Mat analyzed_picture_l_mask;
-  cv::threshold(analyzed_picture_l, analyzed_picture_l_mask, 0.0, 255.0, cv::THRESH_OTSU);
-  analyzed_picture_l_mask -= beacon_mask;
-  cv::normalize(analyzed_picture_lab_b, analyzed_picture_lab_b, 0.0, 255.0, cv::NORM_MINMAX, -1, analyzed_picture_l_mask);
-  cv::normalize(analyzed_picture_lab_g, analyzed_picture_lab_g, 0.0, 255.0, cv::NORM_MINMAX, -1, analyzed_picture_l_mask);
+  GCB_STAGE_TIMER(otsu_threshold_timer, workspace.m_stageTimingProfile, AnalysisStage::OTSU_THRESHOLD);
+  auto analyzed_picture_l_mask = get_buffer_img(workspace.m_maskBuffers[3], analyzed_picture_size, CV_8UC1);
+  lightness_threshold = cv::threshold(analyzed_picture_l, analyzed_picture_l_mask, 0.0, 255.0, cv::THRESH_OTSU);
+  cv::subtract(analyzed_picture_l_mask, beacon_mask, analyzed_picture_l_mask);
+  GCB_STAGE_TIMER_STOP(otsu_threshold_timer);
+
+  GCB_STAGE_TIMER(channel_normalization_timer, workspace.m_stageTimingProfile, AnalysisStage::CHANNEL_NORMALIZATION);
+  normalize_img_with_mask(analyzed_picture_lab_b, 0.0, 255.0, analyzed_picture_l_mask, workspace.m_normalizeBuffer);
+  normalize_img_with_mask(analyzed_picture_lab_g, 0.0, 255.0, analyzed_picture_l_mask, workspace.m_normalizeBuffer);
   cv::bitwise_not(analyzed_picture_lab_g, analyzed_picture_lab_g);
   cv::bitwise_not(analyzed_picture_lab_b, analyzed_picture_lab_b);
+  GCB_STAGE_TIMER_STOP(channel_normalization_timer);
   /* end: preprocess */
 
   /* find contours */
-  std::vector<cv::Vec4i> _hierarchy;
-  std::vector<std::vector<cv::Point>> analyzed_picture_contours;
-  cv::findContours(analyzed_picture_l_mask, analyzed_picture_contours, _hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+  GCB_STAGE_TIMER(contour_detection_timer, workspace.m_stageTimingProfile, AnalysisStage::CONTOUR_DETECTION);
+  cv::findContours(analyzed_picture_l_mask, workspace.m_contours, workspace.m_hierarchy, cv::RETR_TREE, cv::CHAIN_APPROX_SIMPLE);
+  GCB_STAGE_TIMER_STOP(contour_detection_timer);
   /* end: find contours */
 
-  auto green_marker_centers =
-      extract_marker_list(analyzed_picture_contours, ImgProc::calc_pixel_mean_with_mask,
-                          analyzed_picture_l_mask, analyzed_picture_lab_g);
+  GCB_STAGE_TIMER(marker_extraction_timer, workspace.m_stageTimingProfile, AnalysisStage::MARKER_EXTRACTION);
+
+  auto &green_marker_centers = workspace.m_greenMarkerList;
+  auto &except_points = workspace.m_exceptPoints;
+  except_points.clear();
+  extract_marker_list(workspace.m_contours, ImgProc::calc_pixel_mean_with_mask,
+                      analyzed_picture_l_mask, analyzed_picture_lab_g, except_points,
+                      workspace, green_marker_centers);
 
   if (green_marker_centers.size() < 3)
-    return std::vector<cv::Point2f>();
+    return;
 
   green_marker_centers.erase(green_marker_centers.begin() + 3, green_marker_centers.end());
 
-  std::vector<cv::Point2f> except_points;
   for (const auto &[_, point] : green_marker_centers)
     except_points.push_back(point);
 
-  auto blue_marker_centers =
-      extract_marker_list(analyzed_picture_contours, ImgProc::calc_pixel_mean_with_mask,
-                          analyzed_picture_l_mask, analyzed_picture_lab_b, except_points);
+  auto &blue_marker_centers = workspace.m_blueMarkerList;
+  extract_marker_list(workspace.m_contours, ImgProc::calc_pixel_mean_with_mask,
+                      analyzed_picture_l_mask, analyzed_picture_lab_b, except_points,
+                      workspace, blue_marker_centers);
 
   if (blue_marker_centers.empty())
-    return std::vector<cv::Point2f>();
+    return;
 
   blue_marker_centers.erase(blue_marker_centers.begin() + 1, blue_marker_centers.end());
 
-  const auto analyzed_picture_center = static_cast<cv::Point2f>(analyzed_picture.size()) / 2.0f;
-  const auto detected_marker_points =
-      get_clockwise_direction_markers(analyzed_picture_center, blue_marker_centers, green_marker_centers);
+  const auto analyzed_picture_center = static_cast<cv::Point2f>(analyzed_picture_size) / 2.0f;
+  get_clockwise_direction_markers(analyzed_picture_center, blue_marker_centers, green_marker_centers,
+                                  workspace.m_markerAngleList, workspace.m_markerPoints);
+}
+
+/// @brief track beacon_device_markers of previous frame by local search (no full detection)
+/// @param analyzed_picture Image which have LED markers
+/// @param device_definition DeviceDefinition object
+/// @param tracking_state Tracking state of previous frame (m_isTracking must be true)
+/// @param workspace Buffers of search window (four center points of tracked markers are set to m_markerPoints, empty if not confirmed)
+static void track_beacon_device_markers(
+    const cv::Mat &analyzed_picture,
+    const DeviceDefinition &device_definition,
+    const TrackingState &tracking_state,
+    AnalyzerWorkspace &workspace)
+{
+  auto &tracked_marker_points = workspace.m_markerPoints;
+  tracked_marker_points.clear();
+
+  // markers predicted by previous homography are the previous marker points (tripod shot)
+  const auto &predicted_points = tracking_state.m_markerPoints;
+
+  /* estimate marker radius on device roi from previous marker distance */
+  const auto &template_markers = device_definition.m_markerList;
+  const auto template_distance = cv::norm(template_markers.at(1).m_position - template_markers.at(0).m_position);
+  const auto src_distance = cv::norm(predicted_points[1] - predicted_points[0]);
+  if (template_distance <= 0.0 || src_distance <= 0.0)
+    return;
+
+  const auto marker_radius = template_markers.at(0).m_radius * src_distance / template_distance;
+  // smaller than distance to neighbor LED
+  const auto search_half_size = std::max(2, static_cast<int32_t>(std::ceil(marker_radius * 1.5)));
+  const auto min_marker_area = 0.3 * M_PI * marker_radius * marker_radius;
+  /* end: estimate marker radius on device roi from previous marker distance */
+
+  const auto analyzed_picture_rect = cv::Rect(cv::Point(0, 0), analyzed_picture.size());
+  std::array<double, 4> marker_color_b;
+  for (size_t marker_idx = 0; marker_idx < predicted_points.size(); marker_idx++)
+  {
+    const auto &predicted_point = predicted_points[marker_idx];
+    const auto predicted_center = cv::Point(static_cast<int32_t>(std::lround(predicted_point.x)),
+                                            static_cast<int32_t>(std::lround(predicted_point.y)));
+    const auto search_rect =
+        cv::Rect(predicted_center - cv::Point(search_half_size, search_half_size),
+                 predicted_center + cv::Point(search_half_size + 1, search_half_size + 1)) &
+        analyzed_picture_rect;
+    if (search_rect.empty())
+    {
+      tracked_marker_points.clear();
+      return;
+    }
+
+    /* threshold search window by lightness of last full detection */
+    const auto search_size = search_rect.size();
+    auto search_lab = get_buffer_img(workspace.m_labBuffer, search_size, CV_8UC3);
+    auto search_l = get_buffer_img(workspace.m_channelBuffers[0], search_size, CV_8UC1);
+    auto search_b = get_buffer_img(workspace.m_channelBuffers[2], search_size, CV_8UC1);
+    auto search_mask = get_buffer_img(workspace.m_maskBuffers[3], search_size, CV_8UC1);
+    cv::cvtColor(ImgSize::get_img_roi(analyzed_picture, search_rect), search_lab, cv::COLOR_BGR2Lab);
+    cv::extractChannel(search_lab, search_l, 0);
+    cv::extractChannel(search_lab, search_b, 2);
+    cv::threshold(search_l, search_mask, tracking_state.m_lightnessThreshold, 255.0, cv::THRESH_BINARY);
+    /* end: threshold search window by lightness of last full detection */
+
+    // window holds only one marker, centered by minEnclosingCircle like full detection (no drift between both paths)
+    // (pixels are listed into reused vector, findContours would allocate its storage every call)
+    auto &marker_pixels = workspace.m_markerPixels;
+    cv::findNonZero(search_mask, marker_pixels);
+    if (marker_pixels.empty() || static_cast<double>(marker_pixels.size()) < min_marker_area)
+    {
+      tracked_marker_points.clear();
+      return;
+    }
+
+    cv::Point2f marker_center;
+    float_t marker_enclosing_radius;
+    cv::minEnclosingCircle(marker_pixels, marker_center, marker_enclosing_radius);
+    const auto tracked_point = marker_center + cv::Point2f(static_cast<float_t>(search_rect.x), static_cast<float_t>(search_rect.y));
+    if (cv::norm(tracked_point - predicted_point) > marker_radius)
+    {
+      tracked_marker_points.clear();
+      return;
+    }
 
-  return detected_marker_points;
+    marker_color_b[marker_idx] = ImgProc::calc_pixel_mean_with_mask(search_b, search_mask);
+    tracked_marker_points.push_back(tracked_point);
+  }
+
+  // head marker must still be the blue one (lowest b* value)
+  if (*std::min_element(marker_color_b.begin() + 1, marker_color_b.end()) <= marker_color_b[0])
+    tracked_marker_points.clear();
 }
 
 /// @brief normalize led_value
@@ -250,53 +566,234 @@ static uint8_t normalize_led_value(const uint8_t &led_value, const uint8_t &norm
   return static_cast<uint8_t>((static_cast<double>(delta) / divider) * static_cast<uint32_t>(normalize_level));
 }
 
-/// @brief analyze LED_pattern
-/// @param analyzed_picture Image which has analyzed LED beacons
+/// @brief normalize all led_values on device into level of 0~31
+/// @param led_pattern_list Original led values (normalized in place)
+static void normalize_led_pattern(std::vector<uint8_t> &led_pattern_list)
+{
+  const auto [led_pattern_min_iter, led_pattern_max_iter] =
+      std::minmax_element(led_pattern_list.begin(), led_pattern_list.end());
+  const auto led_pattern_min_value = *led_pattern_min_iter;
+  const auto led_pattern_max_value = *led_pattern_max_iter;
+
+  for (auto &led_pattern : led_pattern_list)
+    led_pattern = normalize_led_value(led_pattern, 31U, led_pattern_min_value, led_pattern_max_value);
+}
+
+/// @brief check fused Lab b* kernel against cv::cvtColor (once per process)
+/// @return Whether the kernel is within LAB_B_KERNEL_TOLERANCE
+static bool is_lab_b_kernel_usable()
+{
+  static const bool is_usable = []()
+  {
+    const auto lab_b_max_error = ImgColor::get_lab_b_max_error();
+    if (lab_b_max_error > LAB_B_KERNEL_TOLERANCE)
+    {
+      std::lock_guard<std::mutex> log_lock(g_log_mutex);
+      std::cout << "Lab b* kernel is out of tolerance (" << lab_b_max_error << "): use cv::cvtColor" << std::endl;
+    }
+
+    return lab_b_max_error <= LAB_B_KERNEL_TOLERANCE;
+  }();
+
+  return is_usable;
+}
+
+void GCB::Inside::analyze_led_pattern(
+    const cv::Mat &analyzed_picture,
+    const DeviceDefinition &device_definition,
+    const AnalysisTemplate &analysis_template,
+    AnalyzerWorkspace &workspace,
+    std::vector<uint8_t> &led_pattern_list)
+{
+  // b* is computed only for LED pixels, in the same pass as summation
+  const auto use_lab_b_kernel = is_lab_b_kernel_usable();
+
+  /* extract b channel (Lab space) */
+  cv::Mat analyzed_picture_b;
+  if (!use_lab_b_kernel)
+  {
+    GCB_STAGE_TIMER(color_conversion_timer, workspace.m_stageTimingProfile, AnalysisStage::COLOR_CONVERSION);
+    auto analyzed_picture_lab = get_buffer_img(workspace.m_labBuffer, analyzed_picture.size(), CV_8UC3);
+    analyzed_picture_b = get_buffer_img(workspace.m_channelBuffers[2], analyzed_picture.size(), CV_8UC1);
+    cv::cvtColor(analyzed_picture, analyzed_picture_lab, cv::COLOR_BGR2Lab);
+    cv::extractChannel(analyzed_picture_lab, analyzed_picture_b, 2);
+  }
+  /* end: extract b channel (Lab space) */
+
+  /* calculate led_value for classification (pixel runs index continuous template image) */
+  GCB_STAGE_TIMER(led_sampling_timer, workspace.m_stageTimingProfile, AnalysisStage::LED_SAMPLING);
+  const auto &sampling_plan = analysis_template.m_beaconSamplingPlan;
+  const auto analyzed_picture_data = analyzed_picture.ptr<uint8_t>(0);
+  const auto analyzed_picture_b_data = analyzed_picture_b.ptr<uint8_t>(0);
+  led_pattern_list.assign(device_definition.m_beaconList.size(), 0U);
+  for (const auto &led_sampler : sampling_plan.m_ledSamplers)
+  {
+    if (led_sampler.m_pixelCount == 0U)
+      continue;
+
+    uint64_t pixel_sum = 0U;
+    for (auto run_idx = led_sampler.m_runBegin; run_idx < led_sampler.m_runEnd; run_idx++)
+    {
+      const auto &pixel_run = sampling_plan.m_pixelRuns[run_idx];
+      if (use_lab_b_kernel)
+      {
+        pixel_sum += ImgColor::sum_lab_b_of_bgr_pixels(analyzed_picture_data + pixel_run.m_offset * 3U, pixel_run.m_length);
+        continue;
+      }
+
+      const auto run_data = analyzed_picture_b_data + pixel_run.m_offset;
+      for (uint32_t pixel_idx = 0U; pixel_idx < pixel_run.m_length; pixel_idx++)
+        pixel_sum += run_data[pixel_idx];
+    }
+
+    // same value as cv::mean with LED mask (fused kernel: within LAB_B_KERNEL_TOLERANCE)
+    led_pattern_list[led_sampler.m_ordinal - 1U] =
+        static_cast<uint8_t>(static_cast<double>(pixel_sum) / led_sampler.m_pixelCount);
+  }
+  /* end: calculate led_value for classification */
+
+  normalize_led_pattern(led_pattern_list);
+}
+
+/// @brief project point by homography
+/// @param homography 3x3 homography matrix
+/// @param point Projected point
+/// @return Projected point
+static cv::Point2f project_point(const cv::Matx33d &homography, const cv::Point2f &point)
+{
+  const auto w = homography(2, 0) * point.x + homography(2, 1) * point.y + homography(2, 2);
+  const auto x = (homography(0, 0) * point.x + homography(0, 1) * point.y + homography(0, 2)) / w;
+  const auto y = (homography(1, 0) * point.x + homography(1, 1) * point.y + homography(1, 2)) / w;
+
+  return cv::Point2f(static_cast<float_t>(x), static_cast<float_t>(y));
+}
+
+/// @brief get homography from four point pairs (same linear system as cv::getPerspectiveTransform, solved on stack)
+/// @param src_points Four points on device roi
+/// @param dst_points Four points on template
+/// @return 3x3 homography matrix
+static cv::Matx33d get_perspective_transform(const std::vector<cv::Point2f> &src_points,
+                                             const std::array<cv::Point2f, 4> &dst_points)
+{
+  auto coefficient_mat = cv::Matx<double, 8, 8>::zeros();
+  cv::Matx<double, 8, 1> constant_vec;
+  for (int32_t point_idx = 0; point_idx < 4; point_idx++)
+  {
+    const auto &src_point = src_points[static_cast<size_t>(point_idx)];
+    const auto &dst_point = dst_points[static_cast<size_t>(point_idx)];
+
+    coefficient_mat(point_idx, 0) = coefficient_mat(point_idx + 4, 3) = src_point.x;
+    coefficient_mat(point_idx, 1) = coefficient_mat(point_idx + 4, 4) = src_point.y;
+    coefficient_mat(point_idx, 2) = coefficient_mat(point_idx + 4, 5) = 1.0;
+    coefficient_mat(point_idx, 6) = -static_cast<double>(src_point.x) * dst_point.x;
+    coefficient_mat(point_idx, 7) = -static_cast<double>(src_point.y) * dst_point.x;
+    coefficient_mat(point_idx + 4, 6) = -static_cast<double>(src_point.x) * dst_point.y;
+    coefficient_mat(point_idx + 4, 7) = -static_cast<double>(src_point.y) * dst_point.y;
+    constant_vec(point_idx, 0) = dst_point.x;
+    constant_vec(point_idx + 4, 0) = dst_point.y;
+  }
+
+  const auto solution_vec = coefficient_mat.solve(constant_vec, cv::DECOMP_LU);
+
+  cv::Matx33d homography;
+  for (int32_t element_idx = 0; element_idx < 8; element_idx++)
+    homography.val[element_idx] = solution_vec(element_idx, 0);
+  homography.val[8] = 1.0;
+
+  return homography;
+}
+
+/// @brief analyze LED_pattern without warping device roi (read only source pixels inside each projected LED disc)
+/// @param analyzed_picture Device roi on original picture
+/// @param src_to_template Homography from "analyzed_picture" to device template
 /// @param device_definition DeviceDefinition object
-/// @return Analyzed LED Pattern (Level of 0~31)
-static std::unordered_map<std::string, uint8_t> analyze_led_pattern(
+/// @param workspace Buffers of Lab image
+/// @param led_pattern_list Analyzed LED Pattern (Level of 0~31, index: beacon ordinal - 1)
+static void analyze_led_pattern_in_source_roi(
     const cv::Mat &analyzed_picture,
-    const DeviceDefinition &device_definition)
+    const cv::Matx33d &src_to_template,
+    const DeviceDefinition &device_definition,
+    AnalyzerWorkspace &workspace,
+    std::vector<uint8_t> &led_pattern_list)
 {
-  /* split color channels (Lab space) */
-  cv::Mat analyzed_picture_lab;
-  std::vector<cv::Mat> analyzed_picture_lab_list;
+  // LED sampling in source roi includes its color conversion
+  GCB_STAGE_TIMER(led_sampling_timer, workspace.m_stageTimingProfile, AnalysisStage::LED_SAMPLING);
+
+  /* extract b channel (Lab space) of device roi only */
+  auto analyzed_picture_lab = get_buffer_img(workspace.m_labBuffer, analyzed_picture.size(), CV_8UC3);
+  auto analyzed_picture_b = get_buffer_img(workspace.m_channelBuffers[2], analyzed_picture.size(), CV_8UC1);
   cv::cvtColor(analyzed_picture, analyzed_picture_lab, cv::COLOR_BGR2Lab);
-  cv::split(analyzed_picture_lab, analyzed_picture_lab_list);
-  const auto &analyzed_picture_b = analyzed_picture_lab_list.at(2);
-  /* end: split color channels (Lab space) */
+  cv::extractChannel(analyzed_picture_lab, analyzed_picture_b, 2);
+  /* end: extract b channel (Lab space) of device roi only */
+
+  const cv::Matx33d template_to_src = src_to_template.inv();
+  const auto analyzed_picture_rect = cv::Rect(cv::Point(0, 0), analyzed_picture_b.size());
 
   /* calculate led_value for classification */
-  std::unordered_map<std::string, uint8_t> led_pattern_hash;
-  for (const auto &[beacon_key, beacon] : device_definition.m_beaconHash)
+  led_pattern_list.assign(device_definition.m_beaconList.size(), 0U);
+  // LED geometry of full size template
+  for (const auto &led_sampler : device_definition.m_analysisTemplateList.front().m_beaconSamplingPlan.m_ledSamplers)
   {
-    // improve software performance using roi
-    const auto analyzed_picture_b_roi = ImgSize::get_img_roi(analyzed_picture_b, beacon.m_boundingRect);
-    led_pattern_hash[beacon_key] = static_cast<uint8_t>(ImgProc::calc_pixel_mean_with_mask(analyzed_picture_b_roi, beacon.m_ledMask));
+    const auto &beacon = device_definition.m_beaconList[led_sampler.m_ordinal - 1U];
+
+    // same disc as template LED mask (cv::circle with integer radius)
+    const auto radius = static_cast<float_t>(static_cast<int32_t>(beacon.m_radius));
+    const auto radius_square = radius * radius;
+
+    /* project disc's bounding box into device roi */
+    const std::array<cv::Point2f, 4> template_corners{
+        beacon.m_position + cv::Point2f(-radius, -radius), beacon.m_position + cv::Point2f(radius, -radius),
+        beacon.m_position + cv::Point2f(radius, radius), beacon.m_position + cv::Point2f(-radius, radius)};
+    auto src_corner_min = project_point(template_to_src, template_corners[0]);
+    auto src_corner_max = src_corner_min;
+    for (size_t corner_idx = 1; corner_idx < template_corners.size(); corner_idx++)
+    {
+      const auto src_corner = project_point(template_to_src, template_corners[corner_idx]);
+      src_corner_min = cv::Point2f(std::min(src_corner_min.x, src_corner.x), std::min(src_corner_min.y, src_corner.y));
+      src_corner_max = cv::Point2f(std::max(src_corner_max.x, src_corner.x), std::max(src_corner_max.y, src_corner.y));
+    }
+
+    const auto src_bounding_rect =
+        cv::Rect(cv::Point(static_cast<int32_t>(std::floor(src_corner_min.x)), static_cast<int32_t>(std::floor(src_corner_min.y))),
+                 cv::Point(static_cast<int32_t>(std::ceil(src_corner_max.x)) + 1, static_cast<int32_t>(std::ceil(src_corner_max.y)) + 1)) &
+        analyzed_picture_rect;
+    /* end: project disc's bounding box into device roi */
+
+    /* read source pixels whose center is mapped into the disc */
+    double pixel_sum = 0.0;
+    uint32_t pixel_count = 0U;
+    for (int32_t y = src_bounding_rect.y; y < src_bounding_rect.y + src_bounding_rect.height; y++)
+    {
+      const auto b_row = analyzed_picture_b.ptr<uint8_t>(y);
+      for (int32_t x = src_bounding_rect.x; x < src_bounding_rect.x + src_bounding_rect.width; x++)
+      {
+        const auto template_point =
+            project_point(src_to_template, cv::Point2f(static_cast<float_t>(x), static_cast<float_t>(y)));
+        const auto delta = template_point - beacon.m_position;
+        if (delta.dot(delta) > radius_square)
+          continue;
+
+        pixel_sum += b_row[x];
+        pixel_count++;
+      }
+    }
+    /* end: read source pixels whose center is mapped into the disc */
+
+    // LED is smaller than one source pixel: use the pixel under the projected center
+    if (pixel_count == 0U)
+    {
+      const auto src_center = project_point(template_to_src, beacon.m_position);
+      const auto x = std::clamp(static_cast<int32_t>(std::lround(src_center.x)), 0, analyzed_picture_b.cols - 1);
+      const auto y = std::clamp(static_cast<int32_t>(std::lround(src_center.y)), 0, analyzed_picture_b.rows - 1);
+      pixel_sum = analyzed_picture_b.at<uint8_t>(y, x);
+      pixel_count = 1U;
+    }
+
+    led_pattern_list[led_sampler.m_ordinal - 1U] = static_cast<uint8_t>(pixel_sum / pixel_count);
   }
   /* end: calculate led_value for classification */
 
-  /* normalize (unordered_map's default sort: by 'key' -> sort by 'value') */
-  std::unordered_map<std::string, uint8_t> led_pattern_normalized_hash;
-  const auto &[_max_key, led_pattern_max_value] =
-      *std::max_element(led_pattern_hash.begin(), led_pattern_hash.end(),
-                        [](const auto &a, const auto &b)
-                        {
-                          return a.second < b.second;
-                        });
-  const auto &[_min_key, led_pattern_min_value] =
-      *std::min_element(led_pattern_hash.begin(), led_pattern_hash.end(),
-                        [](const auto &a, const auto &b)
-                        {
-                          return a.second < b.second;
-                        });
-
-  for (const auto &[beacon_key, led_pattern] : led_pattern_hash)
-    led_pattern_normalized_hash[beacon_key] =
-        normalize_led_value(led_pattern, 31U, led_pattern_min_value, led_pattern_max_value);
-  /* end: normalize */
-
-  return led_pattern_normalized_hash;
+  normalize_led_pattern(led_pattern_list);
 }
 
 BeaconAnalyzer::BeaconAnalyzer(const std::string &definition_file_path)
@@ -312,34 +809,48 @@ BeaconAnalyzer::BeaconAnalyzer(const std::string &definition_file_path)
 
     const auto device_template_size = cv::Size(device_json["template_width"], device_json["template_height"]);
 
-    std::unordered_map<std::string, LedData> marker_hash;
+    std::vector<LedData> marker_list;
     const int32_t marker_led_num = marker_json["led_num"];
 
     for (int32_t led_idx = 1; led_idx <= marker_led_num; led_idx++)
     {
-      const auto led_key = "ID" + std::to_string(led_idx);
-      const auto &led_json = marker_json[led_key];
-      marker_hash[led_key] = get_led_data_from_json(led_json, device_template_size);
+      const auto &led_json = marker_json["ID" + std::to_string(led_idx)];
+      marker_list.push_back(get_led_data_from_json(led_json, static_cast<uint32_t>(led_idx)));
     }
 
-    std::unordered_map<std::string, LedData> beacon_hash;
+    std::vector<LedData> beacon_list;
     const int32_t beacon_led_num = beacon_json["led_num"];
 
     for (int32_t led_idx = 1; led_idx <= beacon_led_num; led_idx++)
     {
-      const auto led_key = "ID" + std::to_string(led_idx);
-      const auto &led_json = beacon_json[led_key];
-      beacon_hash[led_key] = get_led_data_from_json(led_json, device_template_size);
+      const auto &led_json = beacon_json["ID" + std::to_string(led_idx)];
+      beacon_list.push_back(get_led_data_from_json(led_json, static_cast<uint32_t>(led_idx)));
     }
 
     DeviceDefinition definition;
     definition.m_deviceName = device_name;
+
+    for (size_t level = 0; level < ANALYSIS_TEMPLATE_LEVEL_NUM; level++)
+    {
+      const auto scale = 1.0 / static_cast<double>(1U << level);
+      definition.m_analysisTemplateList.push_back(
+          create_analysis_template(marker_list, beacon_list, device_template_size, scale));
+    }
+
+    // optional: number (0.0 < scale <= 1.0) or "auto" (default: 1.0)
+    definition.m_analysisScale = 1.0;
+    if (device_json.contains("analysis_scale"))
+      definition.m_analysisScale = get_analysis_scale_from_json(device_json["analysis_scale"]);
+
     definition.m_deviceTemplateSize = std::move(device_template_size);
-    definition.m_markerHash = std::move(marker_hash);
-    definition.m_beaconHash = std::move(beacon_hash);
+    definition.m_markerList = std::move(marker_list);
+    definition.m_beaconList = std::move(beacon_list);
 
     m_deviceDefinitions[device_name] = std::move(definition);
   }
+
+  // check fused kernel before first analysis
+  is_lab_b_kernel_usable();
 }
 
 void BeaconAnalyzer::dump_device_definitions() const
@@ -350,47 +861,108 @@ void BeaconAnalyzer::dump_device_definitions() const
 
 AnalyzationResult BeaconAnalyzer::analyzePicture(const cv::Mat &picture, const DetectionResult &detection_result) const
 {
+  // no previous frame: always full detection
+  TrackingState tracking_state;
+  return analyzePicture(picture, detection_result, tracking_state);
+}
+
+AnalyzationResult BeaconAnalyzer::analyzePicture(
+    const cv::Mat &picture, const DetectionResult &detection_result,
+    TrackingState &tracking_state) const
+{
+  // buffers are kept by each thread and reused by next call
+  thread_local AnalyzerWorkspace workspace;
+
+  AnalyzationResult analyzation_result;
+  analyzePicture(picture, detection_result, tracking_state, workspace, analyzation_result);
+
+  // returned image must not refer to workspace
+  analyzation_result.m_analyzedPictureResult = analyzation_result.m_analyzedPictureResult.clone();
+
+  return analyzation_result;
+}
+
+void BeaconAnalyzer::analyzePicture(
+    const cv::Mat &picture, const DetectionResult &detection_result,
+    TrackingState &tracking_state, AnalyzerWorkspace &workspace,
+    AnalyzationResult &analyzation_result) const
+{
+  GCB_STAGE_TIMER(analyze_picture_timer, workspace.m_stageTimingProfile, AnalysisStage::ANALYZE_PICTURE);
+
   const auto &device_definition = m_deviceDefinitions.at(detection_result.m_deviceName);
-  auto analyzed_picture = ImgSize::get_img_roi(picture, detection_result.m_positionRect).clone();
+  // processed images are written to workspace, so device roi is not copied
+  const auto analyzed_picture = ImgSize::get_img_roi(picture, detection_result.m_positionRect);
+
+  analyzation_result.m_deviceName = detection_result.m_deviceName;
+  analyzation_result.m_deviceId = detection_result.m_deviceId;
+  analyzation_result.m_devicePositionRect = detection_result.m_positionRect;
+  analyzation_result.m_analyzedPictureResult.release();
+  analyzation_result.m_isMarkerFound = false;
+
+  /* get four marker points (local search around previous markers, or full detection) */
+  const auto &homography_src_points = workspace.m_markerPoints;
+  workspace.m_markerPoints.clear();
+  if (detection_result.m_useMarkerTracking && tracking_state.m_isTracking)
+  {
+    GCB_STAGE_TIMER(marker_tracking_timer, workspace.m_stageTimingProfile, AnalysisStage::MARKER_TRACKING);
+    track_beacon_device_markers(analyzed_picture, device_definition, tracking_state, workspace);
+  }
+
+  if (homography_src_points.size() == 4)
+    tracking_state.m_trackedFrameNum++;
+  else
+  {
+    detect_beacon_device_markers(analyzed_picture, workspace, tracking_state.m_lightnessThreshold);
+    tracking_state.m_detectedFrameNum++;
+  }
+
+  tracking_state.m_isTracking = (homography_src_points.size() == 4);
+  if (tracking_state.m_isTracking)
+    std::copy(homography_src_points.begin(), homography_src_points.end(), tracking_state.m_markerPoints.begin());
+  /* end: get four marker points (local search around previous markers, or full detection) */
 
-  // perform beacon_device_markers detection, and get four points
-  const auto homography_src_points = detect_beacon_device_markers(analyzed_picture);
   if (homography_src_points.size() != 4)
   {
-    std::cout << "failed to find markers" << std::endl;
-    AnalyzationResult dummy;
-    dummy.m_deviceName = detection_result.m_deviceName;
-    dummy.m_deviceId = detection_result.m_deviceId;
-    dummy.m_devicePositionRect = detection_result.m_positionRect;
-    for (const auto &[led_key, _] : device_definition.m_beaconHash)
-      dummy.m_ledPatternHash[led_key] = 0;
-
-    return dummy;
+    {
+      std::lock_guard<std::mutex> log_lock(g_log_mutex);
+      std::cout << "failed to find markers" << std::endl;
+    }
+
+    // dummy result
+    analyzation_result.m_ledPatternList.assign(device_definition.m_beaconList.size(), 0U);
+    return;
   }
 
-  /* create homography dst points from marker points on device_definition_json */
-  std::vector<cv::Point2f> homography_dst_points;
-  for (uint32_t marker_id = 1; marker_id <= 4; marker_id++)
+  analyzation_result.m_isMarkerFound = true;
+
+  // source roi sampling reads LED geometry of full size template
+  const auto &analysis_template =
+      (detection_result.m_samplingMode == SamplingMode::SOURCE_ROI)
+          ? device_definition.m_analysisTemplateList.front()
+          : select_analysis_template(device_definition, detection_result);
+
+  // homography dst points: marker points on (scaled) device_definition_json
+  GCB_STAGE_TIMER(homography_timer, workspace.m_stageTimingProfile, AnalysisStage::HOMOGRAPHY);
+  const auto homography_mat = get_perspective_transform(homography_src_points, analysis_template.m_markerPositions);
+  GCB_STAGE_TIMER_STOP(homography_timer);
+
+  // read LED pixels on device roi directly (cost depends on roi size, not template size)
+  if (detection_result.m_samplingMode == SamplingMode::SOURCE_ROI)
   {
-    const auto &marker = device_definition.m_markerHash.at("ID" + std::to_string(marker_id));
-    homography_dst_points.push_back(marker.m_position);
+    analyze_led_pattern_in_source_roi(analyzed_picture, homography_mat, device_definition, workspace,
+                                      analyzation_result.m_ledPatternList);
+    return;
   }
-  /* end: create homography dst points from marker points on device_definition_json */
 
   /* perform image registration and transform */
-  const auto homography_mat = cv::getPerspectiveTransform(homography_src_points, homography_dst_points);
-  cv::warpPerspective(ImgSize::get_img_roi(picture, detection_result.m_positionRect), analyzed_picture,
-                      homography_mat, device_definition.m_deviceTemplateSize);
+  GCB_STAGE_TIMER(warp_timer, workspace.m_stageTimingProfile, AnalysisStage::WARP);
+  auto warped_picture = get_buffer_img(workspace.m_warpBuffer, analysis_template.m_templateSize, analyzed_picture.type());
+  cv::warpPerspective(analyzed_picture, warped_picture, homography_mat, analysis_template.m_templateSize);
+  GCB_STAGE_TIMER_STOP(warp_timer);
   /* end: perform image registration and transform */
 
-  AnalyzationResult analyzation_result;
-  analyzation_result.m_deviceName = detection_result.m_deviceName;
-  analyzation_result.m_deviceId = detection_result.m_deviceId;
-  analyzation_result.m_devicePositionRect = detection_result.m_positionRect;
-  analyzation_result.m_ledPatternHash = analyze_led_pattern(analyzed_picture, device_definition);
-  analyzation_result.m_analyzedPictureResult = std::move(analyzed_picture);
-
-  return analyzation_result;
+  analyze_led_pattern(warped_picture, device_definition, analysis_template, workspace, analyzation_result.m_ledPatternList);
+  analyzation_result.m_analyzedPictureResult = warped_picture;
 }
 
 void GCB::AnalyzationResultWriter::writeAnalyzedLedPattern(
@@ -412,8 +984,9 @@ void GCB::AnalyzationResultWriter::writeAnalyzedLedPattern(
       {"width", position_rect.width},
       {"height", position_rect.height}};
 
-  for (const auto &[beacon_id, led_pattern] : analyzation_result.m_ledPatternHash)
-    m_jsonData[frame_id][device_key]["beacon"][beacon_id] = led_pattern;
+  auto &beacon_json = m_jsonData[frame_id][device_key]["beacon"];
+  for (size_t led_idx = 0; led_idx < analyzation_result.m_ledPatternList.size(); led_idx++)
+    beacon_json["ID" + std::to_string(led_idx + 1)] = analyzation_result.m_ledPatternList[led_idx];
 }
 
 void GCB::AnalyzationResultWriter::outputJson(const std::string &json_file_path, const uint64_t &frame_count)
@@ -429,4 +1002,38 @@ std::string GCB::AnalyzationResultWriter::getJsonString(const uint64_t &frame_co
   m_jsonData["frame_num"] = frame_count;
 
   return m_jsonData.dump();
+}
+
+std::vector<GCB::DetectionResult> GCB::get_detection_result_list_from_json(const std::string &json_string)
+{
+  std::vector<DetectionResult> detection_result_list;
+
+  const auto json_obj = nlohmann::json::parse(json_string);
+  const std::vector<std::string> device_key_list = json_obj["device_key"];
+
+  for (const auto &device_key : device_key_list)
+  {
+    DetectionResult detection_result;
+    detection_result.m_deviceName = json_obj[device_key]["device_name"];
+    detection_result.m_deviceId = json_obj[device_key]["device_id"];
+    detection_result.m_positionRect.x = json_obj[device_key]["rect_x"];
+    detection_result.m_positionRect.y = json_obj[device_key]["rect_y"];
+    detection_result.m_positionRect.width = json_obj[device_key]["rect_width"];
+    detection_result.m_positionRect.height = json_obj[device_key]["rect_height"];
+
+    // optional: "warp_template" (default) or "source_roi"
+    if (json_obj[device_key].value("sampling_mode", "warp_template") == "source_roi")
+      detection_result.m_samplingMode = SamplingMode::SOURCE_ROI;
+
+    // optional: number (0.0 < scale <= 1.0) or "auto" (default: "analysis_scale" of device definition)
+    if (json_obj[device_key].contains("analysis_scale"))
+      detection_result.m_analysisScale = get_analysis_scale_from_json(json_obj[device_key]["analysis_scale"]);
+
+    // optional: reuse markers of previous video frame (default: false)
+    detection_result.m_useMarkerTracking = json_obj[device_key].value("marker_tracking", false);
+
+    detection_result_list.push_back(detection_result);
+  }
+
+  return detection_result_list;
 }
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "../GCB.hpp"
+
+#include <chrono>
+
+using namespace GCB;
+
+FrameDecoder::FrameDecoder(cv::VideoCapture &video_cap, const size_t &buffer_num)
+    : m_videoCap(video_cap),
+      m_framePool(std::max<size_t>(buffer_num, 1U)),
+      m_freeBufferQueue(m_framePool.size()),
+      m_decodedFrameQueue(m_framePool.size()),
+      m_isFinished(false),
+      m_isStopped(false),
+      m_decodedFrameNum(0),
+      m_decodeNanoseconds(0)
+{
+  for (size_t buffer_idx = 0; buffer_idx < m_framePool.size(); buffer_idx++)
+    m_freeBufferQueue.tryPush(buffer_idx);
+
+  m_decodeThread = std::thread(&FrameDecoder::decodeFrames, this);
+}
+
+FrameDecoder::~FrameDecoder()
+{
+  stop();
+  if (m_decodeThread.joinable())
+    m_decodeThread.join();
+}
+
+void FrameDecoder::decodeFrames()
+{
+  uint64_t frame_count = 0;
+  while (true)
+  {
+    // backpressure: block until consumer gives back a buffer (or decoding is stopped)
+    size_t buffer_idx = 0;
+    bool is_popped = false;
+    m_freeBufferNotifier.wait(
+        [&]()
+        {
+          if (m_isStopped.load(std::memory_order_acquire))
+            return true;
+          is_popped = m_freeBufferQueue.tryPop(buffer_idx);
+          return is_popped;
+        });
+    if (!is_popped)
+      break;
+
+    const auto decode_begin = std::chrono::steady_clock::now();
+    const auto is_read = m_videoCap.read(m_framePool[buffer_idx]);
+    const auto decode_time = std::chrono::steady_clock::now() - decode_begin;
+    m_decodeNanoseconds.fetch_add(
+        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(decode_time).count()),
+        std::memory_order_relaxed);
+
+    if (!is_read)
+      break;
+
+    // never full: number of buffer indices equals queue capacity
+    m_decodedFrameQueue.tryPush({frame_count, buffer_idx});
+    frame_count++;
+    m_decodedFrameNum.store(frame_count, std::memory_order_relaxed);
+    m_decodedFrameNotifier.notifyOne();
+  }
+
+  m_isFinished.store(true, std::memory_order_release);
+  m_decodedFrameNotifier.notifyAll();
+}
+
+bool FrameDecoder::acquireFrame(DecodedFrame &decoded_frame)
+{
+  std::pair<uint64_t, size_t> queued_frame;
+  bool is_popped = false;
+  m_decodedFrameNotifier.wait(
+      [&]()
+      {
+        // check "finished" before pop, so that frames pushed just before finish are not missed
+        const auto is_finished = m_isFinished.load(std::memory_order_acquire);
+        is_popped = m_decodedFrameQueue.tryPop(queued_frame);
+        return is_popped || is_finished;
+      });
+  if (!is_popped)
+    return false;
+
+  decoded_frame.m_frameCount = queued_frame.first;
+  decoded_frame.m_bufferIdx = queued_frame.second;
+  decoded_frame.m_image = m_framePool[queued_frame.second];
+  return true;
+}
+
+void FrameDecoder::releaseFrame(DecodedFrame &decoded_frame)
+{
+  decoded_frame.m_image.release();
+  m_freeBufferQueue.tryPush(decoded_frame.m_bufferIdx);
+  m_freeBufferNotifier.notifyOne();
+}
+
+void FrameDecoder::stop()
+{
+  m_isStopped.store(true, std::memory_order_release);
+  m_freeBufferNotifier.notifyAll();
+}
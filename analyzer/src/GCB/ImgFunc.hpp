@@ -46,4 +46,18 @@ namespace ImgProc
 	float_t calc_angle_degree_formed_by_vectors(
 			const cv::Point2f &vec1, const cv::Point2f &vec2,
 			const cv::Point2f &base_point = cv::Point2f(0.0f, 0.0f));
+};
+
+// color conversion of selected pixels
+namespace ImgColor
+{
+	/// @brief sum Lab b* values of BGR pixels (same integer pipeline as cv::COLOR_BGR2Lab of 8-bit image, without L* and a*)
+	/// @param bgr_data Head of continuous BGR pixels
+	/// @param pixel_num Number of pixels
+	/// @return Sum of b* values (0 ~ 255 per pixel)
+	uint64_t sum_lab_b_of_bgr_pixels(const uint8_t *bgr_data, const size_t &pixel_num);
+
+	/// @brief get max difference of b* between sum_lab_b_of_bgr_pixels and cv::cvtColor (checked on 64 x 64 x 64 colors)
+	/// @return Max difference per pixel
+	int32_t get_lab_b_max_error();
 };
\ No newline at end of file
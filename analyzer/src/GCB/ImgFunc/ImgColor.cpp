@@ -0,0 +1,212 @@
+#include "../ImgFunc.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/* fixed-point parameters of OpenCV's 8-bit RGB -> Lab conversion */
+static constexpr int32_t GAMMA_SHIFT = 3;
+static constexpr int32_t LAB_SHIFT = 12;
+static constexpr int32_t LAB_SHIFT2 = LAB_SHIFT + GAMMA_SHIFT;
+static constexpr int32_t LAB_CBRT_TABLE_SIZE = 256 * 3 / 2 * (1 << GAMMA_SHIFT);
+static constexpr int32_t LAB_B_BIAS = (128 << LAB_SHIFT2) + (1 << (LAB_SHIFT2 - 1)); // offset of b* and rounding
+/* end: fixed-point parameters of OpenCV's 8-bit RGB -> Lab conversion */
+
+// Lookup tables of b* (Y and Z rows of sRGB -> XYZ matrix are premultiplied by gamma-corrected channel value)
+struct LabBTable
+{
+	std::array<std::array<int32_t, 256>, 3> m_yTable; // index: B, G, R
+	std::array<std::array<int32_t, 256>, 3> m_zTable; // index: B, G, R
+	std::array<int32_t, LAB_CBRT_TABLE_SIZE> m_cbrtTable;
+};
+
+/// @brief create lookup tables of b* (same constants as OpenCV: sRGB gamma, D65 white point)
+/// @return Lookup tables
+static LabBTable create_lab_b_table()
+{
+	static constexpr std::array<double, 9> SRGB_TO_XYZ{
+			0.412453, 0.357580, 0.180423,
+			0.212671, 0.715160, 0.072169,
+			0.019334, 0.119193, 0.950227};
+	static constexpr std::array<double, 3> D65_WHITE_POINT{0.950456, 1.0, 1.088754};
+
+	std::array<int32_t, 256> gamma_table;
+	for (size_t value = 0; value < gamma_table.size(); value++)
+	{
+		const auto x = static_cast<double>(value) / 255.0;
+		const auto linear_x = (x <= 0.04045) ? x / 12.92 : std::pow((x + 0.055) / 1.055, 2.4);
+		gamma_table[value] = static_cast<int32_t>(std::lrint(255.0 * (1 << GAMMA_SHIFT) * linear_x));
+	}
+
+	LabBTable lab_b_table;
+	for (size_t channel_idx = 0; channel_idx < 3; channel_idx++)
+	{
+		// XYZ matrix is RGB order, table is BGR order
+		const auto y_coefficient = static_cast<int32_t>(
+				std::lrint((1 << LAB_SHIFT) * SRGB_TO_XYZ[3 + 2 - channel_idx] / D65_WHITE_POINT[1]));
+		const auto z_coefficient = static_cast<int32_t>(
+				std::lrint((1 << LAB_SHIFT) * SRGB_TO_XYZ[6 + 2 - channel_idx] / D65_WHITE_POINT[2]));
+		for (size_t value = 0; value < gamma_table.size(); value++)
+		{
+			lab_b_table.m_yTable[channel_idx][value] = gamma_table[value] * y_coefficient;
+			lab_b_table.m_zTable[channel_idx][value] = gamma_table[value] * z_coefficient;
+		}
+	}
+
+	// single precision like OpenCV's table (its software cube root is not reproduced: few entries may differ by 1)
+	const auto cbrt_scale = 1.0f / (255.0f * (1 << GAMMA_SHIFT));
+	for (size_t idx = 0; idx < lab_b_table.m_cbrtTable.size(); idx++)
+	{
+		const auto x = cbrt_scale * static_cast<float_t>(idx);
+		const auto f_x = (x < 0.008856f) ? x * 7.787f + 16.0f / 116.0f
+																		 : static_cast<float_t>(std::cbrt(static_cast<double>(x)));
+		lab_b_table.m_cbrtTable[idx] = static_cast<int32_t>(std::lrint(static_cast<float_t>(1 << LAB_SHIFT2) * f_x));
+	}
+
+	return lab_b_table;
+}
+
+/// @brief get lookup tables of b* (created once)
+/// @return Lookup tables
+static const LabBTable &get_lab_b_table()
+{
+	static const LabBTable lab_b_table = create_lab_b_table();
+	return lab_b_table;
+}
+
+/// @brief convert one BGR pixel to b*
+/// @param lab_b_table Lookup tables
+/// @param pixel BGR pixel
+/// @return b* (0 ~ 255)
+static inline int32_t convert_bgr_to_lab_b(const LabBTable &lab_b_table, const uint8_t *pixel)
+{
+	const auto y_idx = (lab_b_table.m_yTable[0][pixel[0]] + lab_b_table.m_yTable[1][pixel[1]] +
+											lab_b_table.m_yTable[2][pixel[2]] + (1 << (LAB_SHIFT - 1))) >>
+										 LAB_SHIFT;
+	const auto z_idx = (lab_b_table.m_zTable[0][pixel[0]] + lab_b_table.m_zTable[1][pixel[1]] +
+											lab_b_table.m_zTable[2][pixel[2]] + (1 << (LAB_SHIFT - 1))) >>
+										 LAB_SHIFT;
+	const auto f_y = lab_b_table.m_cbrtTable[static_cast<size_t>(y_idx)];
+	const auto f_z = lab_b_table.m_cbrtTable[static_cast<size_t>(z_idx)];
+
+	return std::clamp((200 * (f_y - f_z) + LAB_B_BIAS) >> LAB_SHIFT2, 0, 255);
+}
+
+#ifdef __AVX2__
+/// @brief lookup and sum table values of eight pixels, then descale (AVX2)
+/// @param table Table of B, G, R
+/// @param b_idx Indices of B
+/// @param g_idx Indices of G
+/// @param r_idx Indices of R
+/// @return Descaled sum (index of cbrt table)
+static inline __m256i gather_descaled_sum(const std::array<std::array<int32_t, 256>, 3> &table,
+																					const __m256i &b_idx, const __m256i &g_idx, const __m256i &r_idx)
+{
+	const auto sum = _mm256_add_epi32(_mm256_add_epi32(_mm256_i32gather_epi32(table[0].data(), b_idx, 4),
+																										 _mm256_i32gather_epi32(table[1].data(), g_idx, 4)),
+																		_mm256_i32gather_epi32(table[2].data(), r_idx, 4));
+	return _mm256_srai_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(1 << (LAB_SHIFT - 1))), LAB_SHIFT);
+}
+#endif
+
+uint64_t ImgColor::sum_lab_b_of_bgr_pixels(const uint8_t *bgr_data, const size_t &pixel_num)
+{
+	const auto &lab_b_table = get_lab_b_table();
+
+	uint64_t lab_b_sum = 0U;
+	size_t pixel_idx = 0;
+
+#ifdef __AVX2__
+	/* eight pixels per step (same integer operations as scalar version, so results are identical) */
+	const auto b_shuffle_lo = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const auto b_shuffle_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, -1, -1, -1, -1, -1, -1, -1, -1);
+	const auto g_shuffle_lo = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const auto g_shuffle_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1);
+	const auto r_shuffle_lo = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+	const auto r_shuffle_hi = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+
+	auto lab_b_sum_vec = _mm256_setzero_si256();
+	for (; pixel_idx + 8 <= pixel_num; pixel_idx += 8)
+	{
+		// 24 bytes of eight pixels (no read beyond them)
+		const auto pixels = bgr_data + pixel_idx * 3;
+		const auto pixels_lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pixels));
+		const auto pixels_hi = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pixels + 16));
+
+		const auto b_idx = _mm256_cvtepu8_epi32(
+				_mm_or_si128(_mm_shuffle_epi8(pixels_lo, b_shuffle_lo), _mm_shuffle_epi8(pixels_hi, b_shuffle_hi)));
+		const auto g_idx = _mm256_cvtepu8_epi32(
+				_mm_or_si128(_mm_shuffle_epi8(pixels_lo, g_shuffle_lo), _mm_shuffle_epi8(pixels_hi, g_shuffle_hi)));
+		const auto r_idx = _mm256_cvtepu8_epi32(
+				_mm_or_si128(_mm_shuffle_epi8(pixels_lo, r_shuffle_lo), _mm_shuffle_epi8(pixels_hi, r_shuffle_hi)));
+
+		const auto y_idx = gather_descaled_sum(lab_b_table.m_yTable, b_idx, g_idx, r_idx);
+		const auto z_idx = gather_descaled_sum(lab_b_table.m_zTable, b_idx, g_idx, r_idx);
+		const auto f_y = _mm256_i32gather_epi32(lab_b_table.m_cbrtTable.data(), y_idx, 4);
+		const auto f_z = _mm256_i32gather_epi32(lab_b_table.m_cbrtTable.data(), z_idx, 4);
+
+		auto lab_b = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(f_y, f_z), _mm256_set1_epi32(200)),
+																	_mm256_set1_epi32(LAB_B_BIAS));
+		lab_b = _mm256_srai_epi32(lab_b, LAB_SHIFT2);
+		lab_b = _mm256_min_epi32(_mm256_max_epi32(lab_b, _mm256_setzero_si256()), _mm256_set1_epi32(255));
+		lab_b_sum_vec = _mm256_add_epi32(lab_b_sum_vec, lab_b);
+	}
+
+	alignas(32) std::array<int32_t, 8> lab_b_sum_lanes;
+	_mm256_store_si256(reinterpret_cast<__m256i *>(lab_b_sum_lanes.data()), lab_b_sum_vec);
+	for (const auto &lab_b_sum_lane : lab_b_sum_lanes)
+		lab_b_sum += static_cast<uint64_t>(lab_b_sum_lane);
+	/* end: eight pixels per step */
+#endif
+
+	for (; pixel_idx < pixel_num; pixel_idx++)
+		lab_b_sum += static_cast<uint64_t>(convert_bgr_to_lab_b(lab_b_table, bgr_data + pixel_idx * 3));
+
+	return lab_b_sum;
+}
+
+int32_t ImgColor::get_lab_b_max_error()
+{
+	/* create all combinations of 64 levels (64 x 64 x 64 colors) */
+	cv::Mat color_img(512, 512, CV_8UC3);
+	for (int32_t color_idx = 0; color_idx < 64 * 64 * 64; color_idx++)
+	{
+		auto &pixel = color_img.at<cv::Vec3b>(color_idx / 512, color_idx % 512);
+		for (int32_t channel_idx = 0; channel_idx < 3; channel_idx++)
+			pixel[channel_idx] = static_cast<uint8_t>(((color_idx >> (channel_idx * 6)) & 63) * 255 / 63);
+	}
+	/* end: create all combinations of 64 levels */
+
+	cv::Mat color_img_lab, color_img_b;
+	cv::cvtColor(color_img, color_img_lab, cv::COLOR_BGR2Lab);
+	cv::extractChannel(color_img_lab, color_img_b, 2);
+
+	const auto &lab_b_table = get_lab_b_table();
+	int32_t lab_b_max_error = 0;
+	for (int32_t y = 0; y < color_img.rows; y++)
+	{
+		const auto color_row = color_img.ptr<uint8_t>(y);
+		const auto b_row = color_img_b.ptr<uint8_t>(y);
+
+		int64_t row_error = 0;
+		for (int32_t x = 0; x < color_img.cols; x++)
+		{
+			const auto pixel_error = convert_bgr_to_lab_b(lab_b_table, color_row + x * 3) - b_row[x];
+			lab_b_max_error = std::max(lab_b_max_error, std::abs(pixel_error));
+			row_error += pixel_error;
+		}
+
+		// vectorized version must be identical to scalar version
+		const auto row_sum = static_cast<int64_t>(sum_lab_b_of_bgr_pixels(color_row, static_cast<size_t>(color_img.cols)));
+		const auto b_row_sum = static_cast<int64_t>(cv::sum(color_img_b.row(y))[0]);
+		if (row_sum - b_row_sum != row_error)
+			return std::numeric_limits<int32_t>::max();
+	}
+
+	return lab_b_max_error;
+}
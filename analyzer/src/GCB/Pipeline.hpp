@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// building blocks of frame pipeline (lock-free queue, blocking wait)
+namespace Pipeline
+{
+	/// @brief bounded lock-free queue (ring buffer of D. Vyukov, safe for multi-producer / multi-consumer)
+	/// @tparam T Trivially copyable item
+	template <typename T>
+	class BoundedQueue
+	{
+	private:
+		struct Cell
+		{
+			std::atomic<size_t> m_sequence;
+			T m_data;
+		};
+
+		std::unique_ptr<Cell[]> m_cells;
+		size_t m_capacity;
+		alignas(64) std::atomic<size_t> m_pushPosition;
+		alignas(64) std::atomic<size_t> m_popPosition;
+
+	public:
+		/// @brief constructor
+		/// @param capacity Maximum number of queued items
+		explicit BoundedQueue(const size_t &capacity)
+				: m_cells(new Cell[capacity]), m_capacity(capacity), m_pushPosition(0), m_popPosition(0)
+		{
+			for (size_t cell_idx = 0; cell_idx < m_capacity; cell_idx++)
+				m_cells[cell_idx].m_sequence.store(cell_idx, std::memory_order_relaxed);
+		}
+
+		/* forbid copy action */
+		BoundedQueue(const BoundedQueue &other) = delete;
+		BoundedQueue &operator=(const BoundedQueue &other) = delete;
+		/* end: forbid copy action */
+
+		/// @brief push item (non blocking)
+		/// @param data Pushed item
+		/// @return false if queue is full
+		bool tryPush(const T &data)
+		{
+			auto position = m_pushPosition.load(std::memory_order_relaxed);
+			while (true)
+			{
+				auto &cell = m_cells[position % m_capacity];
+				const auto sequence = cell.m_sequence.load(std::memory_order_acquire);
+				const auto delta = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+				if (delta == 0)
+				{
+					if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						cell.m_data = data;
+						cell.m_sequence.store(position + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (delta < 0)
+					return false;
+				else
+					position = m_pushPosition.load(std::memory_order_relaxed);
+			}
+		}
+
+		/// @brief pop item (non blocking)
+		/// @param data Popped item (output)
+		/// @return false if queue is empty
+		bool tryPop(T &data)
+		{
+			auto position = m_popPosition.load(std::memory_order_relaxed);
+			while (true)
+			{
+				auto &cell = m_cells[position % m_capacity];
+				const auto sequence = cell.m_sequence.load(std::memory_order_acquire);
+				const auto delta = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+
+				if (delta == 0)
+				{
+					if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					{
+						data = cell.m_data;
+						cell.m_sequence.store(position + m_capacity, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (delta < 0)
+					return false;
+				else
+					position = m_popPosition.load(std::memory_order_relaxed);
+			}
+		}
+	};
+
+	/// @brief wakeup of threads waiting for lock-free queue (mutex is taken only to wait and to notify)
+	class Notifier
+	{
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+
+	public:
+		Notifier() = default;
+
+		/* forbid copy action */
+		Notifier(const Notifier &other) = delete;
+		Notifier &operator=(const Notifier &other) = delete;
+		/* end: forbid copy action */
+
+		/// @brief block until predicate is true (checked before blocking and after each notification)
+		/// @param is_ready Predicate (may pop queue, change of its state must be followed by notifyOne / notifyAll)
+		template <typename Predicate>
+		void wait(Predicate is_ready)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, is_ready);
+		}
+
+		/// @brief wake one waiter (call after state change)
+		void notifyOne()
+		{
+			// waiter between predicate check and blocking holds mutex, so the notification is not lost
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+			}
+			m_cv.notify_one();
+		}
+
+		/// @brief wake all waiters (call after state change)
+		void notifyAll()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+			}
+			m_cv.notify_all();
+		}
+	};
+
+	/// @brief reorder window of items produced out of order by parallel producers (taken in sequence order)
+	/// @tparam T Swappable item (buffers in items are swapped between producers and consumer, not reallocated)
+	/// @details Sequences must be given to producers in increasing order (e.g. popped from FIFO queue), and every given
+	///          sequence must be put (or buffer must be aborted), otherwise take waits forever.
+	template <typename T>
+	class ReorderBuffer
+	{
+	private:
+		std::mutex m_mutex;
+		std::condition_variable m_cv;
+		std::vector<T> m_slotList; // sequence N is put to slot N % slot_num
+		std::vector<bool> m_isFilledList;
+		uint64_t m_takenSequenceNum = 0; // next sequence taken by consumer
+		uint32_t m_runningProducerNum;
+		bool m_isAborted = false;
+
+	public:
+		/// @brief constructor
+		/// @param slot_num Number of items waiting for older ones (producers ahead of consumer by slot_num wait)
+		/// @param producer_num Number of producers (each calls finishProducer once)
+		/// @param initial_item Item copied to all slots (buffers swapped to producers are allocated in advance)
+		ReorderBuffer(const size_t &slot_num, const uint32_t &producer_num, const T &initial_item = T())
+				: m_slotList(std::max<size_t>(slot_num, 1U), initial_item), m_isFilledList(m_slotList.size(), false), m_runningProducerNum(producer_num)
+		{
+		}
+
+		/* forbid copy action */
+		ReorderBuffer(const ReorderBuffer &other) = delete;
+		ReorderBuffer &operator=(const ReorderBuffer &other) = delete;
+		/* end: forbid copy action */
+
+		/// @brief put item of sequence (wait until sequence is inside window of consumer)
+		/// @param sequence Sequence of item
+		/// @param item Put item (swapped with item taken before from the same slot)
+		/// @return false if aborted (item is not put)
+		bool put(const uint64_t &sequence, T &item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			// slot of sequence is free once all older sequences sharing it are taken
+			// (oldest untaken sequence is always inside, so its producer never waits)
+			m_cv.wait(lock, [&]() { return sequence < m_takenSequenceNum + m_slotList.size() || m_isAborted; });
+			if (m_isAborted)
+				return false;
+
+			const auto slot_idx = static_cast<size_t>(sequence % m_slotList.size());
+			std::swap(m_slotList[slot_idx], item);
+			m_isFilledList[slot_idx] = true;
+			lock.unlock();
+			m_cv.notify_all();
+			return true;
+		}
+
+		/// @brief take item of next sequence (wait until it is put)
+		/// @param item Taken item (output, swapped with slot)
+		/// @return false if aborted, or all producers finished without putting next sequence
+		bool take(T &item)
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			const auto slot_idx = static_cast<size_t>(m_takenSequenceNum % m_slotList.size());
+			m_cv.wait(lock, [&]() { return m_isFilledList[slot_idx] || m_runningProducerNum == 0 || m_isAborted; });
+			if (m_isAborted || !m_isFilledList[slot_idx])
+				return false;
+
+			std::swap(m_slotList[slot_idx], item);
+			m_isFilledList[slot_idx] = false;
+			m_takenSequenceNum++;
+			lock.unlock();
+			m_cv.notify_all();
+			return true;
+		}
+
+		/// @brief notify that producer puts no more items
+		void finishProducer()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_runningProducerNum--;
+			}
+			m_cv.notify_all();
+		}
+
+		/// @brief wake and fail all waiting and later put / take
+		void abort()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_isAborted = true;
+			}
+			m_cv.notify_all();
+		}
+
+		/// @brief getter takenSequenceNum (number of items taken by consumer)
+		uint64_t getTakenSequenceNum()
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_takenSequenceNum;
+		}
+	};
+};
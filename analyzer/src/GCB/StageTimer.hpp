@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+
+#include "../GCB.hpp"
+
+// Scoped timer adding its lifetime to a stage histogram (use via GCB_STAGE_TIMER, removed without GCB_STAGE_TIMING)
+class StageTimer
+{
+private:
+	GCB::StageTimingProfile &m_profile;
+	GCB::AnalysisStage m_stage;
+	std::chrono::steady_clock::time_point m_begin;
+	bool m_isStopped;
+
+public:
+	/// @brief constructor (start measurement)
+	/// @param profile Profile receiving the duration
+	/// @param stage Measured stage
+	StageTimer(GCB::StageTimingProfile &profile, const GCB::AnalysisStage &stage)
+			: m_profile(profile), m_stage(stage), m_begin(std::chrono::steady_clock::now()), m_isStopped(false) {}
+
+	/// @brief destructor (stop measurement if not stopped)
+	~StageTimer() { stop(); }
+
+	/* forbid copy action */
+	StageTimer(const StageTimer &other) = delete;
+	StageTimer &operator=(const StageTimer &other) = delete;
+	/* end: forbid copy action */
+
+	/// @brief stop measurement before end of scope (for sequential stages in one scope)
+	void stop()
+	{
+		if (m_isStopped)
+			return;
+
+		m_isStopped = true;
+		m_profile.addSample(m_stage, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+																										 std::chrono::steady_clock::now() - m_begin)
+																										 .count()));
+	}
+};
+
+#ifdef GCB_STAGE_TIMING
+#define GCB_STAGE_TIMER(timer_name, profile, stage) StageTimer timer_name((profile), (stage))
+#define GCB_STAGE_TIMER_STOP(timer_name) timer_name.stop()
+#else
+#define GCB_STAGE_TIMER(timer_name, profile, stage)
+#define GCB_STAGE_TIMER_STOP(timer_name)
+#endif
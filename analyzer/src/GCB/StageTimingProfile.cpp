@@ -0,0 +1,97 @@
+#include "../GCB.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace GCB;
+
+static const std::array<std::string, static_cast<size_t>(AnalysisStage::STAGE_NUM)> STAGE_NAMES{
+    "analyze_picture", "color_conversion", "otsu_threshold", "channel_normalization", "contour_detection",
+    "marker_extraction", "marker_tracking", "homography", "warp", "led_sampling"};
+
+size_t StageTimingProfile::getBucketIdx(const uint64_t &nanoseconds)
+{
+  size_t bucket_idx = 0;
+  for (auto value = nanoseconds; value > 1U && bucket_idx + 1 < BUCKET_NUM; value >>= 1U)
+    bucket_idx++;
+
+  return bucket_idx;
+}
+
+const std::string &StageTimingProfile::getStageName(const AnalysisStage &stage)
+{
+  return STAGE_NAMES[static_cast<size_t>(stage)];
+}
+
+void StageTimingProfile::addSample(const AnalysisStage &stage, const uint64_t &nanoseconds)
+{
+  auto &stage_histogram = m_stageHistograms[static_cast<size_t>(stage)];
+  stage_histogram.m_bucketCounts[getBucketIdx(nanoseconds)]++;
+  stage_histogram.m_sampleNum++;
+  stage_histogram.m_totalNanoseconds += nanoseconds;
+  stage_histogram.m_maxNanoseconds = std::max(stage_histogram.m_maxNanoseconds, nanoseconds);
+}
+
+void StageTimingProfile::merge(const StageTimingProfile &other)
+{
+  for (size_t stage_idx = 0; stage_idx < m_stageHistograms.size(); stage_idx++)
+  {
+    auto &stage_histogram = m_stageHistograms[stage_idx];
+    const auto &other_stage_histogram = other.m_stageHistograms[stage_idx];
+    for (size_t bucket_idx = 0; bucket_idx < BUCKET_NUM; bucket_idx++)
+      stage_histogram.m_bucketCounts[bucket_idx] += other_stage_histogram.m_bucketCounts[bucket_idx];
+    stage_histogram.m_sampleNum += other_stage_histogram.m_sampleNum;
+    stage_histogram.m_totalNanoseconds += other_stage_histogram.m_totalNanoseconds;
+    stage_histogram.m_maxNanoseconds = std::max(stage_histogram.m_maxNanoseconds, other_stage_histogram.m_maxNanoseconds);
+  }
+}
+
+uint64_t StageTimingProfile::getPercentileNanoseconds(const AnalysisStage &stage, const double &percentile) const
+{
+  const auto &stage_histogram = m_stageHistograms[static_cast<size_t>(stage)];
+  if (stage_histogram.m_sampleNum == 0U)
+    return 0U;
+
+  // rank of sample (1 ~ sample_num)
+  const auto rank = std::max<uint64_t>(
+      1U, static_cast<uint64_t>(std::ceil(percentile * static_cast<double>(stage_histogram.m_sampleNum))));
+  uint64_t accumulated_count = 0U;
+  for (size_t bucket_idx = 0; bucket_idx < BUCKET_NUM; bucket_idx++)
+  {
+    accumulated_count += stage_histogram.m_bucketCounts[bucket_idx];
+    if (accumulated_count >= rank)
+      return std::min(stage_histogram.m_maxNanoseconds, (uint64_t{2} << bucket_idx) - 1U);
+  }
+
+  return stage_histogram.m_maxNanoseconds;
+}
+
+nlohmann::json StageTimingProfile::getJson() const
+{
+  nlohmann::json profile_json = nlohmann::json::object();
+  for (size_t stage_idx = 0; stage_idx < m_stageHistograms.size(); stage_idx++)
+  {
+    const auto &stage_histogram = m_stageHistograms[stage_idx];
+    if (stage_histogram.m_sampleNum == 0U)
+      continue;
+
+    const auto stage = static_cast<AnalysisStage>(stage_idx);
+    auto &stage_json = profile_json[STAGE_NAMES[stage_idx]];
+    stage_json["count"] = stage_histogram.m_sampleNum;
+    stage_json["total_ms"] = static_cast<double>(stage_histogram.m_totalNanoseconds) * 1e-6;
+    stage_json["mean_us"] =
+        static_cast<double>(stage_histogram.m_totalNanoseconds) / static_cast<double>(stage_histogram.m_sampleNum) * 1e-3;
+    stage_json["p50_us"] = static_cast<double>(getPercentileNanoseconds(stage, 0.50)) * 1e-3;
+    stage_json["p99_us"] = static_cast<double>(getPercentileNanoseconds(stage, 0.99)) * 1e-3;
+    stage_json["max_us"] = static_cast<double>(stage_histogram.m_maxNanoseconds) * 1e-3;
+
+    // key: lower bound of bucket (nanoseconds)
+    auto &bucket_json = stage_json["buckets_ns"];
+    bucket_json = nlohmann::json::object();
+    for (size_t bucket_idx = 0; bucket_idx < BUCKET_NUM; bucket_idx++)
+      if (stage_histogram.m_bucketCounts[bucket_idx] > 0U)
+        bucket_json[std::to_string(uint64_t{1} << bucket_idx)] = stage_histogram.m_bucketCounts[bucket_idx];
+  }
+
+  return profile_json;
+}
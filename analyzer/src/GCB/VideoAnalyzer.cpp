@@ -0,0 +1,273 @@
+#include "../GCB.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+
+using namespace GCB;
+
+// Analyzed frame waiting in reorder buffer for older frames (swapped in and out, not reallocated)
+struct ReorderedFrame
+{
+  std::vector<AnalyzationResult> m_analyzationResultList;
+  std::chrono::steady_clock::time_point m_analysisBeginTime;
+  FrameDecoder::DecodedFrame m_decodedFrame; // retained frame
+};
+
+/// @brief get number of device markers found by local search so far
+/// @param tracking_state_list Tracking states of all devices
+/// @return Sum of tracked frames of devices
+static uint64_t get_tracked_device_num(const std::vector<TrackingState> &tracking_state_list)
+{
+  uint64_t tracked_device_num = 0;
+  for (const auto &tracking_state : tracking_state_list)
+    tracked_device_num += tracking_state.m_trackedFrameNum;
+
+  return tracked_device_num;
+}
+
+VideoAnalyzer::VideoAnalyzer(const BeaconAnalyzer &beacon_analyzer, const uint32_t &worker_num,
+                             AnalysisSlotPool *ptr_slot_pool)
+    : m_beaconAnalyzer(beacon_analyzer), m_workerNum(worker_num), m_ptrSlotPool(ptr_slot_pool)
+{
+  if (m_workerNum == 0)
+    m_workerNum = (m_ptrSlotPool != nullptr) ? m_ptrSlotPool->getSlotNum() : std::max(1U, std::thread::hardware_concurrency());
+}
+
+VideoAnalysisStatistics VideoAnalyzer::analyzeVideo(
+    cv::VideoCapture &video_cap,
+    const std::vector<DetectionResult> &detection_result_list,
+    const FrameResultCallback &frame_result_callback) const
+{
+  return analyzeFrames(
+      video_cap, detection_result_list,
+      [&](const uint64_t &frame_count, const cv::Mat &, const std::vector<AnalyzationResult> &analyzation_result_list)
+      { frame_result_callback(frame_count, analyzation_result_list); },
+      false);
+}
+
+VideoAnalysisStatistics VideoAnalyzer::analyzeVideo(
+    cv::VideoCapture &video_cap,
+    const std::vector<DetectionResult> &detection_result_list,
+    const AnalyzedFrameCallback &analyzed_frame_callback) const
+{
+  return analyzeFrames(video_cap, detection_result_list, analyzed_frame_callback, true);
+}
+
+VideoAnalysisStatistics VideoAnalyzer::analyzeFrames(
+    cv::VideoCapture &video_cap,
+    const std::vector<DetectionResult> &detection_result_list,
+    const AnalyzedFrameCallback &analyzed_frame_callback,
+    const bool &is_frame_retained) const
+{
+  const auto analysis_begin = std::chrono::steady_clock::now();
+
+  // tracked markers must come from previous frame: each worker takes segments of consecutive frames,
+  // and tracking restarts by full detection at every segment (results do not depend on worker number or timing)
+  const auto is_marker_tracked = std::any_of(detection_result_list.begin(), detection_result_list.end(),
+                                             [](const DetectionResult &detection_result)
+                                             { return detection_result.m_useMarkerTracking; });
+  const size_t segment_frame_num = is_marker_tracked ? TRACKING_SEGMENT_FRAME_NUM : 1U;
+
+  // decoder runs ahead of workers by pooled buffers (memory is capped by backpressure)
+  // each worker holds a segment, retained frames wait in reorder buffer, extra buffers keep decoder ahead
+  FrameDecoder frame_decoder(video_cap, static_cast<size_t>(m_workerNum) * (segment_frame_num * (is_frame_retained ? 2U : 1U) + 1U));
+
+  // results of all devices are allocated in advance, then swapped between workers, reorder buffer and merge
+  ReorderedFrame initial_reordered_frame;
+  initial_reordered_frame.m_analyzationResultList.resize(detection_result_list.size());
+  for (size_t device_idx = 0; device_idx < detection_result_list.size(); device_idx++)
+  {
+    const auto &device_name = detection_result_list[device_idx].m_deviceName;
+    auto &analyzation_result = initial_reordered_frame.m_analyzationResultList[device_idx];
+    analyzation_result.m_deviceName = device_name;
+    analyzation_result.m_ledPatternList.reserve(m_beaconAnalyzer.getDeviceDefinitions().at(device_name).m_beaconList.size());
+  }
+
+  // segments are taken from decoder in order, so worker of the oldest unmerged frame never waits for reorder buffer
+  Pipeline::ReorderBuffer<ReorderedFrame> reorder_buffer(static_cast<size_t>(m_workerNum) * segment_frame_num * 2U, m_workerNum,
+                                                         initial_reordered_frame);
+  std::mutex segment_mutex; // frames of one segment are taken together
+
+  std::mutex result_mutex;
+  std::exception_ptr worker_exception = nullptr;
+  std::atomic<uint64_t> analysis_nanoseconds(0);
+  std::atomic<uint64_t> steady_allocation_num(0);
+  std::atomic<uint64_t> tracked_frame_num(0);
+  std::atomic<uint64_t> tracked_allocation_num(0);
+  StageTimingProfile stage_timing_profile; // merged from worker workspaces (guarded by result_mutex)
+
+  // first exception of workers or callback stops decoder and wakes all waits
+  const auto abort_analysis = [&](const std::exception_ptr &exception)
+  {
+    {
+      std::lock_guard<std::mutex> result_lock(result_mutex);
+      if (!worker_exception)
+        worker_exception = exception;
+    }
+    reorder_buffer.abort();
+    frame_decoder.stop();
+  };
+
+  /* analyze frames on worker threads */
+  const auto analyze_frames = [&]()
+  {
+    // each worker tracks markers from the previous frame of its segment, and reuses its buffers
+    std::vector<TrackingState> tracking_state_list(detection_result_list.size());
+    AnalyzerWorkspace workspace;
+    ReorderedFrame reordered_frame = initial_reordered_frame;
+    bool is_first_frame = true;
+    bool is_first_tracked_frame = true; // grows buffers of search window
+
+    std::vector<FrameDecoder::DecodedFrame> segment_frame_list(segment_frame_num);
+    bool is_aborted = false;
+    while (!is_aborted)
+    {
+      size_t acquired_frame_num = 0;
+      {
+        std::lock_guard<std::mutex> segment_lock(segment_mutex);
+        while (acquired_frame_num < segment_frame_num && frame_decoder.acquireFrame(segment_frame_list[acquired_frame_num]))
+          acquired_frame_num++;
+      }
+      if (acquired_frame_num == 0)
+        break;
+
+      for (auto &tracking_state : tracking_state_list)
+        tracking_state.m_isTracking = false;
+
+      for (size_t segment_frame_idx = 0; segment_frame_idx < acquired_frame_num && !is_aborted; segment_frame_idx++)
+      {
+        auto &decoded_frame = segment_frame_list[segment_frame_idx];
+
+        // slot is held only while analyzing (never while waiting for decoder or reorder buffer)
+        if (m_ptrSlotPool != nullptr)
+          m_ptrSlotPool->acquireSlot();
+        const auto frame_analysis_begin = std::chrono::steady_clock::now();
+        const auto allocation_num_begin = AllocationCounter::get_thread_allocation_num();
+        const auto tracked_device_num_begin = get_tracked_device_num(tracking_state_list);
+
+        auto &analyzation_result_list = reordered_frame.m_analyzationResultList;
+        try
+        {
+          // list swapped back from reorder buffer is allocated by initial_reordered_frame
+          analyzation_result_list.resize(detection_result_list.size());
+          for (size_t device_idx = 0; device_idx < detection_result_list.size(); device_idx++)
+          {
+            auto &analyzation_result = analyzation_result_list[device_idx];
+            m_beaconAnalyzer.analyzePicture(decoded_frame.m_image, detection_result_list[device_idx],
+                                            tracking_state_list[device_idx], workspace, analyzation_result);
+            // refers to workspace overwritten by next frame
+            analyzation_result.m_analyzedPictureResult.release();
+          }
+        }
+        catch (...)
+        {
+          if (m_ptrSlotPool != nullptr)
+            m_ptrSlotPool->releaseSlot();
+          abort_analysis(std::current_exception());
+          is_aborted = true;
+          break;
+        }
+
+        const auto frame_allocation_num = AllocationCounter::get_thread_allocation_num() - allocation_num_begin;
+        if (m_ptrSlotPool != nullptr)
+          m_ptrSlotPool->releaseSlot();
+        if (!is_frame_retained)
+          frame_decoder.releaseFrame(decoded_frame);
+        analysis_nanoseconds.fetch_add(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - frame_analysis_begin)
+                                      .count()),
+            std::memory_order_relaxed);
+        // first frame grows workspace to high-water size
+        if (!is_first_frame)
+          steady_allocation_num.fetch_add(frame_allocation_num, std::memory_order_relaxed);
+        is_first_frame = false;
+        // full detection allocates contour storage of OpenCV, tracked frames must not allocate
+        if (is_marker_tracked &&
+            get_tracked_device_num(tracking_state_list) - tracked_device_num_begin == detection_result_list.size())
+        {
+          tracked_frame_num.fetch_add(1U, std::memory_order_relaxed);
+          if (!is_first_tracked_frame)
+            tracked_allocation_num.fetch_add(frame_allocation_num, std::memory_order_relaxed);
+          is_first_tracked_frame = false;
+        }
+
+        reordered_frame.m_analysisBeginTime = frame_analysis_begin;
+        if (is_frame_retained)
+        {
+          reordered_frame.m_decodedFrame = decoded_frame;
+          decoded_frame.m_image.release(); // owned by reorder buffer
+        }
+        if (!reorder_buffer.put(decoded_frame.m_frameCount, reordered_frame))
+          is_aborted = true;
+      }
+
+      // frames of aborted segment are not analyzed
+      if (is_aborted)
+      {
+        for (auto &decoded_frame : segment_frame_list)
+          if (!decoded_frame.m_image.empty())
+            frame_decoder.releaseFrame(decoded_frame);
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> result_lock(result_mutex);
+      stage_timing_profile.merge(workspace.m_stageTimingProfile);
+    }
+    reorder_buffer.finishProducer();
+  };
+
+  std::vector<std::thread> worker_list;
+  for (uint32_t worker_idx = 0; worker_idx < m_workerNum; worker_idx++)
+    worker_list.emplace_back(analyze_frames);
+  /* end: analyze frames on worker threads */
+
+  /* merge results in frame order (on caller's thread) */
+  uint64_t merged_frame_count = 0;
+  std::vector<uint64_t> frame_latency_nanoseconds_list;
+  ReorderedFrame reordered_frame = initial_reordered_frame;
+  while (reorder_buffer.take(reordered_frame))
+  {
+    frame_latency_nanoseconds_list.push_back(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - reordered_frame.m_analysisBeginTime)
+            .count()));
+    auto &decoded_frame = reordered_frame.m_decodedFrame;
+    try
+    {
+      analyzed_frame_callback(merged_frame_count, decoded_frame.m_image, reordered_frame.m_analyzationResultList);
+    }
+    catch (...)
+    {
+      // stopped like failed worker (workers are joined before rethrow)
+      abort_analysis(std::current_exception());
+    }
+    if (is_frame_retained)
+      frame_decoder.releaseFrame(decoded_frame);
+    merged_frame_count++;
+  }
+  /* end: merge results in frame order (on caller's thread) */
+
+  for (auto &worker : worker_list)
+    worker.join();
+
+  if (worker_exception)
+    std::rethrow_exception(worker_exception);
+
+  VideoAnalysisStatistics video_analysis_statistics;
+  video_analysis_statistics.m_frameNum = merged_frame_count;
+  video_analysis_statistics.m_decodeSeconds = frame_decoder.getDecodeSeconds();
+  video_analysis_statistics.m_analysisSeconds = static_cast<double>(analysis_nanoseconds.load()) * 1e-9;
+  video_analysis_statistics.m_elapsedSeconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - analysis_begin).count();
+  video_analysis_statistics.m_steadyAllocationNum = steady_allocation_num.load();
+  video_analysis_statistics.m_trackedFrameNum = tracked_frame_num.load();
+  video_analysis_statistics.m_trackedAllocationNum = tracked_allocation_num.load();
+  video_analysis_statistics.m_stageTimingProfile = stage_timing_profile;
+  video_analysis_statistics.m_frameLatencyNanoseconds = std::move(frame_latency_nanoseconds_list);
+
+  return video_analysis_statistics;
+}
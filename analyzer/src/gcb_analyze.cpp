@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include "GCB.hpp"
+
+// Video and its request JSON analyzed as one job
+struct AnalysisJob
+{
+  std::string m_videoFilePath;
+  std::string m_requestJsonPath;
+  std::string m_resultJsonPath;
+};
+
+// Settings of gcb-analyze (given by command line)
+struct BatchOption
+{
+  std::string m_definitionFilePath = "../assets/beacon_device_definition.json";
+  std::string m_outputDirPath = "../data/analyze";
+  uint32_t m_parallelJobNum = 0; // 0: min(number of jobs, number of hardware threads)
+  uint32_t m_workerNumPerJob = 0; // 0: hardware threads / parallel jobs
+  int64_t m_maxTrackedAllocationNum = -1; // -1: allocations are not checked
+  std::vector<std::pair<std::string, std::string>> m_inputPairList; // (video, request JSON)
+};
+
+static std::mutex g_print_mutex;
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-analyze [-d definition_json] [-o output_dir] [-j parallel_jobs] [-w workers_per_job]\n"
+            << "                   [-a max_tracked_allocations] [-l list_file] <video> <request_json> [<video> <request_json> ...]\n"
+            << "  -a: fail job when workers allocate more on frames of tracked markers, or no frame is tracked\n"
+            << "      (after first tracked frame of each worker, requires build with GCB_COUNT_ALLOCATIONS)\n"
+            << "  -l: file listing \"<video> <request_json>\" per line\n"
+            << "  result of each video is written to <output_dir>/<video stem>.json" << std::endl;
+}
+
+/// @brief read whole text file
+/// @param file_path Read file path
+/// @return File content (throws std::runtime_error when file cannot be opened)
+static std::string read_text_file(const std::string &file_path)
+{
+  std::ifstream ifs(file_path);
+  if (ifs.fail())
+    throw std::runtime_error("File Open Error: " + file_path);
+
+  std::string text, line;
+  while (std::getline(ifs, line))
+    text.append(line);
+
+  return text;
+}
+
+/// @brief parse command line of gcb-analyze
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param batch_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, BatchOption &batch_option)
+{
+  std::vector<std::string> positional_arg_list;
+
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg.size() != 2 || arg[0] != '-')
+    {
+      positional_arg_list.push_back(arg);
+      continue;
+    }
+
+    if (arg == "-h")
+      return false;
+    if (arg_idx + 1 >= argc)
+    {
+      std::cout << "missing value of " << arg << std::endl;
+      return false;
+    }
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-d")
+      batch_option.m_definitionFilePath = value;
+    else if (arg == "-o")
+      batch_option.m_outputDirPath = value;
+    else if (arg == "-j")
+      batch_option.m_parallelJobNum = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-w")
+      batch_option.m_workerNumPerJob = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-a")
+      batch_option.m_maxTrackedAllocationNum = std::stoll(value);
+    else if (arg == "-l")
+    {
+      std::ifstream list_ifs(value);
+      if (list_ifs.fail())
+      {
+        std::cout << "File Open Error: " << value << std::endl;
+        return false;
+      }
+
+      std::string video_file_path, request_json_path;
+      while (list_ifs >> video_file_path >> request_json_path)
+        batch_option.m_inputPairList.emplace_back(video_file_path, request_json_path);
+    }
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (positional_arg_list.size() % 2 != 0)
+  {
+    std::cout << "video and request_json must be given in pairs" << std::endl;
+    return false;
+  }
+  for (size_t arg_idx = 0; arg_idx < positional_arg_list.size(); arg_idx += 2)
+    batch_option.m_inputPairList.emplace_back(positional_arg_list[arg_idx], positional_arg_list[arg_idx + 1]);
+
+  return !batch_option.m_inputPairList.empty();
+}
+
+/// @brief analyze one video and write result JSON (same format as gcb-analyzer server)
+/// @param beacon_analyzer Analyzer shared by all jobs
+/// @param analysis_job Analyzed video, request and result path
+/// @param worker_num Number of worker threads of this job
+/// @param max_tracked_allocation_num Allocations allowed on tracked frames (-1: not checked)
+static void run_analysis_job(const GCB::BeaconAnalyzer &beacon_analyzer, const AnalysisJob &analysis_job,
+                             const uint32_t &worker_num, const int64_t &max_tracked_allocation_num)
+{
+  const auto detection_result_list =
+      GCB::get_detection_result_list_from_json(read_text_file(analysis_job.m_requestJsonPath));
+
+  cv::VideoCapture video_cap(analysis_job.m_videoFilePath);
+  if (!video_cap.isOpened())
+    throw std::runtime_error("Video Open Error: " + analysis_job.m_videoFilePath);
+
+  GCB::AnalyzationResultWriter analyzation_result_writer;
+  const GCB::VideoAnalyzer video_analyzer(beacon_analyzer, worker_num);
+  const auto video_analysis_statistics = video_analyzer.analyzeVideo(
+      video_cap, detection_result_list,
+      [&](const uint64_t &frame_idx, const std::vector<GCB::AnalyzationResult> &analyzation_result_list)
+      {
+        for (const auto &analyzation_result : analyzation_result_list)
+          analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result, frame_idx);
+      });
+
+  analyzation_result_writer.outputJson(analysis_job.m_resultJsonPath, video_analysis_statistics.m_frameNum);
+
+  std::lock_guard<std::mutex> print_lock(g_print_mutex);
+  std::cout << analysis_job.m_videoFilePath << ": analyzed " << video_analysis_statistics.m_frameNum
+            << " frames in " << video_analysis_statistics.m_elapsedSeconds << " s"
+            << " (decode: " << video_analysis_statistics.m_decodeSeconds << " s"
+            << ", analysis: " << video_analysis_statistics.m_analysisSeconds << " s on "
+            << video_analyzer.getWorkerNum() << " workers) -> " << analysis_job.m_resultJsonPath << std::endl;
+  if (GCB::AllocationCounter::is_enabled())
+    std::cout << analysis_job.m_videoFilePath << ": allocations in steady state (workers, after first frame): "
+              << video_analysis_statistics.m_steadyAllocationNum << ", on " << video_analysis_statistics.m_trackedFrameNum
+              << " tracked frames: " << video_analysis_statistics.m_trackedAllocationNum << std::endl;
+
+  if (max_tracked_allocation_num < 0)
+    return;
+  if (!GCB::AllocationCounter::is_enabled())
+    throw std::runtime_error("allocations are not counted (build with GCB_COUNT_ALLOCATIONS)");
+  if (video_analysis_statistics.m_trackedFrameNum == 0)
+    throw std::runtime_error("no frame is analyzed by marker tracking");
+  if (video_analysis_statistics.m_trackedAllocationNum > static_cast<uint64_t>(max_tracked_allocation_num))
+    throw std::runtime_error("allocations on tracked frames exceed " + std::to_string(max_tracked_allocation_num));
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  BatchOption batch_option;
+  if (!parse_arguments(argc, argv, batch_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  /* create job list */
+  std::vector<AnalysisJob> analysis_job_list;
+  std::set<std::string> result_json_path_set;
+  std::filesystem::create_directories(batch_option.m_outputDirPath);
+  for (const auto &[video_file_path, request_json_path] : batch_option.m_inputPairList)
+  {
+    AnalysisJob analysis_job;
+    analysis_job.m_videoFilePath = video_file_path;
+    analysis_job.m_requestJsonPath = request_json_path;
+    analysis_job.m_resultJsonPath =
+        (std::filesystem::path(batch_option.m_outputDirPath) /
+         std::filesystem::path(video_file_path).stem()).string() + ".json";
+
+    // results of "a/input.mp4" and "b/input.mp4" would overwrite each other
+    if (!result_json_path_set.insert(analysis_job.m_resultJsonPath).second)
+    {
+      std::cout << "duplicated result path: " << analysis_job.m_resultJsonPath
+                << " (video file names must be unique)" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    analysis_job_list.push_back(analysis_job);
+  }
+  /* end: create job list */
+
+  /* decide parallelism (jobs x workers ~ hardware threads) */
+  const uint32_t hardware_thread_num = std::max(1U, std::thread::hardware_concurrency());
+  const auto job_num = static_cast<uint32_t>(analysis_job_list.size());
+  const uint32_t parallel_job_num =
+      std::min(job_num, batch_option.m_parallelJobNum > 0 ? batch_option.m_parallelJobNum : hardware_thread_num);
+  const uint32_t worker_num_per_job =
+      batch_option.m_workerNumPerJob > 0 ? batch_option.m_workerNumPerJob
+                                         : std::max(1U, hardware_thread_num / parallel_job_num);
+  /* end: decide parallelism */
+
+  // definition is loaded once and shared by all jobs (analyzePicture is const)
+  const GCB::BeaconAnalyzer beacon_analyzer(batch_option.m_definitionFilePath);
+
+  std::atomic<size_t> next_job_idx(0);
+  std::atomic<uint32_t> failed_job_num(0);
+  std::vector<std::thread> job_thread_list;
+  for (uint32_t thread_idx = 0; thread_idx < parallel_job_num; thread_idx++)
+  {
+    job_thread_list.emplace_back(
+        [&]()
+        {
+          for (auto job_idx = next_job_idx++; job_idx < analysis_job_list.size(); job_idx = next_job_idx++)
+          {
+            try
+            {
+              run_analysis_job(beacon_analyzer, analysis_job_list[job_idx], worker_num_per_job,
+                               batch_option.m_maxTrackedAllocationNum);
+            }
+            catch (const std::exception &e)
+            {
+              failed_job_num++;
+              std::lock_guard<std::mutex> print_lock(g_print_mutex);
+              std::cout << analysis_job_list[job_idx].m_videoFilePath << ": failed (" << e.what() << ")" << std::endl;
+            }
+          }
+        });
+  }
+  for (auto &job_thread : job_thread_list)
+    job_thread.join();
+
+  std::cout << (job_num - failed_job_num) << "/" << job_num << " videos analyzed" << std::endl;
+
+  return failed_job_num == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,372 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+
+#include "BeaconSynth.hpp"
+#include "GCB/ImgFunc.hpp"
+
+// One benchmark case (body runs one iteration)
+struct BenchCase
+{
+  std::string m_name; // "<function>/<device_name>/<roi_width>x<roi_height>"
+  std::function<void()> m_body;
+};
+
+// Measured time of one benchmark case
+struct BenchResult
+{
+  std::string m_name;
+  uint64_t m_iterationNum = 0; // iterations per repetition
+  double m_medianNanoseconds = 0.0;
+  double m_minNanoseconds = 0.0;
+};
+
+// Settings of gcb-bench (given by command line)
+struct BenchOption
+{
+  std::string m_definitionFilePath = "../assets/beacon_device_definition.json";
+  std::string m_nameFilter; // run cases whose name contains this string (empty: all)
+  double m_minSeconds = 0.2; // minimum time of one repetition
+  uint32_t m_repetitionNum = 5;
+  std::string m_resultJsonPath; // empty: no JSON output
+};
+
+// Inputs of benchmark cases on one synthetic device roi (shared by cases of the roi)
+struct BenchInput
+{
+  cv::Mat m_roiImg;      // device roi (BGR)
+  cv::Mat m_warpedImg;   // device roi warped to analysis template
+  const GCB::Inside::AnalysisTemplate *m_analysisTemplate = nullptr;
+  cv::Mat m_markerImg;   // grayscale image of blue marker's bounding rect
+  cv::Mat m_markerMask;  // contour mask of blue marker's bounding rect
+  std::vector<cv::Point> m_markerContour; // blue marker's contour as extracted by marker detection
+  std::vector<cv::Point2f> m_markerPoints; // detected markers (head: blue marker)
+  GCB::DetectionResult m_detectionResult;
+  GCB::TrackingState m_trackingState;
+  GCB::AnalyzerWorkspace m_workspace;
+  GCB::AnalyzationResult m_analyzationResult;
+  std::vector<uint8_t> m_ledPatternList;
+};
+
+static const std::vector<int32_t> BENCH_ROI_WIDTH_LIST = {320, 640, 1280, 1920};
+static constexpr double DEVICE_FILL_RATIO = 0.9;   // device size in roi (margin is background)
+static constexpr double DEVICE_TILT_RATIO = 0.02;  // slight perspective as seen by camera
+static const cv::Scalar BACKGROUND_COLOR(16, 16, 16);
+
+static volatile double g_bench_sink = 0.0; // keeps results of benchmark bodies alive
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-bench [-d definition_json] [-f name_filter] [-t min_seconds] [-r repetitions] [-o result_json]\n"
+            << "  cases: <function>/<device_name>/<roi_width>x<roi_height> (every device x roi widths 320, 640, 1280, 1920)"
+            << std::endl;
+}
+
+/// @brief parse command line of gcb-bench
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param bench_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, BenchOption &bench_option)
+{
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg == "-h" || arg_idx + 1 >= argc)
+      return false;
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-d")
+      bench_option.m_definitionFilePath = value;
+    else if (arg == "-f")
+      bench_option.m_nameFilter = value;
+    else if (arg == "-t")
+      bench_option.m_minSeconds = std::stod(value);
+    else if (arg == "-r")
+      bench_option.m_repetitionNum = std::max(1U, static_cast<uint32_t>(std::stoul(value)));
+    else if (arg == "-o")
+      bench_option.m_resultJsonPath = value;
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// @brief create inputs of one device roi (device is rendered, detected and warped once)
+/// @param beacon_analyzer Analyzer having device definition
+/// @param device_definition Rendered device
+/// @param roi_size Size of device roi
+/// @return Inputs (nullptr if markers of rendered device are not detected)
+static std::shared_ptr<BenchInput> create_bench_input(const GCB::BeaconAnalyzer &beacon_analyzer,
+                                                      const GCB::Inside::DeviceDefinition &device_definition,
+                                                      const cv::Size &roi_size)
+{
+  auto bench_input = std::make_shared<BenchInput>();
+
+  /* render device roi */
+  std::vector<uint8_t> led_level_list;
+  for (size_t beacon_idx = 0; beacon_idx < device_definition.m_beaconList.size(); beacon_idx++)
+    led_level_list.push_back(static_cast<uint8_t>((beacon_idx * 7U) % BeaconSynth::LED_LEVEL_NUM));
+
+  bench_input->m_roiImg = cv::Mat(roi_size, CV_8UC3, BACKGROUND_COLOR);
+  const auto device_corners = BeaconSynth::get_device_corners(
+      device_definition.m_deviceTemplateSize, cv::Rect2f(cv::Point2f(0.0f, 0.0f), cv::Size2f(roi_size)),
+      DEVICE_FILL_RATIO, DEVICE_TILT_RATIO);
+  BeaconSynth::draw_device(bench_input->m_roiImg,
+                           BeaconSynth::render_device_template(device_definition, led_level_list), device_corners);
+  /* end: render device roi */
+
+  // template follows roi size (same as "analysis_scale": "auto")
+  auto &detection_result = bench_input->m_detectionResult;
+  detection_result.m_deviceName = device_definition.m_deviceName;
+  detection_result.m_deviceId = 0;
+  detection_result.m_positionRect = cv::Rect2f(cv::Point2f(0.0f, 0.0f), cv::Size2f(roi_size));
+  detection_result.m_analysisScale = GCB::ANALYSIS_SCALE_AUTO;
+
+  GCB::TrackingState tracking_state;
+  beacon_analyzer.analyzePicture(bench_input->m_roiImg, detection_result, tracking_state,
+                                 bench_input->m_workspace, bench_input->m_analyzationResult);
+  if (!tracking_state.m_isTracking)
+    return nullptr;
+
+  bench_input->m_markerPoints = bench_input->m_workspace.m_markerPoints;
+  bench_input->m_warpedImg = bench_input->m_analyzationResult.m_analyzedPictureResult.clone();
+  for (const auto &analysis_template : device_definition.m_analysisTemplateList)
+  {
+    if (analysis_template.m_templateSize == bench_input->m_warpedImg.size())
+      bench_input->m_analysisTemplate = &analysis_template;
+  }
+
+  /* blue marker's contour and its mask (contour picked by detect_beacon_device_markers, not the device body) */
+  GCB::AnalyzerWorkspace detection_workspace;
+  double lightness_threshold;
+  GCB::Inside::detect_beacon_device_markers(bench_input->m_roiImg, detection_workspace, lightness_threshold);
+  if (detection_workspace.m_markerPoints.empty())
+    return nullptr;
+
+  // detected marker centers are minEnclosingCircle centers of extracted contours (head: blue marker)
+  const auto &blue_marker_center = detection_workspace.m_markerPoints.front();
+  const auto min_marker_area = static_cast<double>(roi_size.area()) * 0.001;
+  double min_center_distance = std::numeric_limits<double>::max();
+  for (const auto &contour : detection_workspace.m_contours)
+  {
+    if (cv::contourArea(contour) < min_marker_area)
+      continue;
+
+    cv::Point2f contour_center;
+    float_t contour_radius;
+    cv::minEnclosingCircle(contour, contour_center, contour_radius);
+    const auto center_distance = cv::norm(contour_center - blue_marker_center);
+    if (center_distance < min_center_distance)
+    {
+      min_center_distance = center_distance;
+      bench_input->m_markerContour = contour;
+    }
+  }
+
+  cv::Mat roi_gray;
+  cv::cvtColor(bench_input->m_roiImg, roi_gray, cv::COLOR_BGR2GRAY);
+  const auto bounding_rect = cv::boundingRect(bench_input->m_markerContour);
+  std::vector<cv::Point> shifted_contour;
+  for (const auto &point : bench_input->m_markerContour)
+    shifted_contour.push_back(point - bounding_rect.tl());
+  bench_input->m_markerMask = cv::Mat::zeros(bounding_rect.size(), CV_8UC1);
+  cv::fillConvexPoly(bench_input->m_markerMask, shifted_contour, cv::Scalar(255, 0, 0));
+  bench_input->m_markerImg = ImgSize::get_img_roi(roi_gray, bounding_rect);
+  /* end: blue marker's contour and its mask */
+
+  return bench_input;
+}
+
+/// @brief create benchmark cases of one device roi
+/// @param beacon_analyzer Analyzer having device definition
+/// @param device_definition Analyzed device
+/// @param bench_input Inputs of device roi
+/// @param bench_case_list Created cases (appended)
+static void add_bench_cases(const GCB::BeaconAnalyzer &beacon_analyzer,
+                            const GCB::Inside::DeviceDefinition &device_definition,
+                            const std::shared_ptr<BenchInput> &bench_input,
+                            std::vector<BenchCase> &bench_case_list)
+{
+  const auto roi_size = bench_input->m_roiImg.size();
+  const auto case_suffix =
+      "/" + device_definition.m_deviceName + "/" + std::to_string(roi_size.width) + "x" + std::to_string(roi_size.height);
+  const auto add_case = [&](const std::string &function_name, std::function<void()> body)
+  { bench_case_list.push_back({function_name + case_suffix, std::move(body)}); };
+
+  /* ImgProc */
+  add_case("ImgProc::calc_pixel_mean_with_mask", [bench_input]()
+           { g_bench_sink = ImgProc::calc_pixel_mean_with_mask(bench_input->m_markerImg, bench_input->m_markerMask); });
+  add_case("ImgProc::calc_pixel_sum_with_mask", [bench_input]()
+           { g_bench_sink = ImgProc::calc_pixel_sum_with_mask(bench_input->m_markerImg, bench_input->m_markerMask); });
+  add_case("ImgProc::get_contour_circularity", [bench_input]()
+           { g_bench_sink = ImgProc::get_contour_circularity(bench_input->m_markerContour); });
+  add_case("ImgProc::calc_angle_degree_formed_by_vectors", [bench_input]()
+           {
+             const auto &marker_points = bench_input->m_markerPoints;
+             const auto base_point = static_cast<cv::Point2f>(bench_input->m_roiImg.size()) / 2.0f;
+             float_t angle_sum = 0.0f;
+             for (size_t marker_idx = 1; marker_idx < marker_points.size(); marker_idx++)
+               angle_sum += ImgProc::calc_angle_degree_formed_by_vectors(marker_points[0], marker_points[marker_idx], base_point);
+             g_bench_sink = angle_sum;
+           });
+  /* end: ImgProc */
+
+  /* stages of analyzePicture */
+  add_case("detect_beacon_device_markers", [bench_input]()
+           {
+             double lightness_threshold;
+             GCB::Inside::detect_beacon_device_markers(bench_input->m_roiImg, bench_input->m_workspace, lightness_threshold);
+             g_bench_sink = static_cast<double>(bench_input->m_workspace.m_markerPoints.size());
+           });
+  add_case("analyze_led_pattern", [bench_input, &device_definition]()
+           {
+             GCB::Inside::analyze_led_pattern(bench_input->m_warpedImg, device_definition, *bench_input->m_analysisTemplate,
+                                              bench_input->m_workspace, bench_input->m_ledPatternList);
+             g_bench_sink = bench_input->m_ledPatternList.front();
+           });
+  /* end: stages of analyzePicture */
+
+  /* whole analyzePicture (full detection every call, as first frame of video) */
+  const auto add_analyze_picture_case = [&](const std::string &variant_name, const GCB::SamplingMode &sampling_mode,
+                                            const bool &use_marker_tracking)
+  {
+    add_case("BeaconAnalyzer::analyzePicture" + variant_name,
+             [bench_input, &beacon_analyzer, sampling_mode, use_marker_tracking]()
+             {
+               auto detection_result = bench_input->m_detectionResult;
+               detection_result.m_samplingMode = sampling_mode;
+               detection_result.m_useMarkerTracking = use_marker_tracking;
+               if (!use_marker_tracking)
+                 bench_input->m_trackingState = GCB::TrackingState();
+
+               beacon_analyzer.analyzePicture(bench_input->m_roiImg, detection_result, bench_input->m_trackingState,
+                                              bench_input->m_workspace, bench_input->m_analyzationResult);
+               g_bench_sink = bench_input->m_analyzationResult.m_ledPatternList.front();
+             });
+  };
+  add_analyze_picture_case("", GCB::SamplingMode::WARP_TEMPLATE, false);
+  add_analyze_picture_case("(source_roi)", GCB::SamplingMode::SOURCE_ROI, false);
+  add_analyze_picture_case("(marker_tracking)", GCB::SamplingMode::WARP_TEMPLATE, true);
+  /* end: whole analyzePicture */
+}
+
+/// @brief measure one benchmark case
+/// @param bench_case Measured case
+/// @param bench_option Minimum time and repetitions
+/// @return Time per iteration
+static BenchResult run_bench_case(const BenchCase &bench_case, const BenchOption &bench_option)
+{
+  using Clock = std::chrono::steady_clock;
+  const auto run_iterations = [&](const uint64_t &iteration_num)
+  {
+    const auto start_time = Clock::now();
+    for (uint64_t iteration_idx = 0; iteration_idx < iteration_num; iteration_idx++)
+      bench_case.m_body();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start_time).count();
+  };
+
+  // warm up buffers of workspace, then grow iterations until one repetition takes minimum time
+  bench_case.m_body();
+  BenchResult bench_result;
+  bench_result.m_name = bench_case.m_name;
+  bench_result.m_iterationNum = 1;
+  const auto min_nanoseconds = bench_option.m_minSeconds * 1.0e9;
+  for (auto elapsed_nanoseconds = run_iterations(1); elapsed_nanoseconds < min_nanoseconds;)
+  {
+    const auto growth = std::clamp(min_nanoseconds * 1.2 / std::max(elapsed_nanoseconds, 1.0), 2.0, 100.0);
+    bench_result.m_iterationNum = static_cast<uint64_t>(static_cast<double>(bench_result.m_iterationNum) * growth);
+    elapsed_nanoseconds = run_iterations(bench_result.m_iterationNum);
+  }
+
+  std::vector<double> nanoseconds_per_iteration_list;
+  for (uint32_t repetition_idx = 0; repetition_idx < bench_option.m_repetitionNum; repetition_idx++)
+    nanoseconds_per_iteration_list.push_back(
+        run_iterations(bench_result.m_iterationNum) / static_cast<double>(bench_result.m_iterationNum));
+
+  std::sort(nanoseconds_per_iteration_list.begin(), nanoseconds_per_iteration_list.end());
+  bench_result.m_medianNanoseconds = nanoseconds_per_iteration_list[nanoseconds_per_iteration_list.size() / 2];
+  bench_result.m_minNanoseconds = nanoseconds_per_iteration_list.front();
+
+  return bench_result;
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  BenchOption bench_option;
+  if (!parse_arguments(argc, argv, bench_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const GCB::BeaconAnalyzer beacon_analyzer(bench_option.m_definitionFilePath);
+
+  /* create cases (every device x roi size) */
+  std::vector<BenchCase> bench_case_list;
+  for (const auto &device_name : beacon_analyzer.getDeviceNames())
+  {
+    const auto &device_definition = beacon_analyzer.getDeviceDefinitions().at(device_name);
+    const auto &template_size = device_definition.m_deviceTemplateSize;
+
+    for (const auto &roi_width : BENCH_ROI_WIDTH_LIST)
+    {
+      // roi keeps aspect of template (device is placed with margin)
+      const cv::Size roi_size(roi_width, static_cast<int32_t>(std::lround(
+                                             static_cast<double>(roi_width) * template_size.height / template_size.width)));
+      const auto bench_input = create_bench_input(beacon_analyzer, device_definition, roi_size);
+      if (bench_input == nullptr)
+      {
+        std::cout << device_name << " " << roi_size << ": markers of synthetic device are not detected (skipped)" << std::endl;
+        continue;
+      }
+
+      add_bench_cases(beacon_analyzer, device_definition, bench_input, bench_case_list);
+    }
+  }
+  /* end: create cases */
+
+  nlohmann::json result_json;
+  result_json["min_seconds"] = bench_option.m_minSeconds;
+  result_json["repetition_num"] = bench_option.m_repetitionNum;
+  result_json["benchmarks"] = nlohmann::json::array();
+
+  std::cout << std::left << std::setw(84) << "case" << std::right << std::setw(12) << "iterations"
+            << std::setw(14) << "median [us]" << std::setw(14) << "min [us]" << std::endl;
+  for (const auto &bench_case : bench_case_list)
+  {
+    if (bench_case.m_name.find(bench_option.m_nameFilter) == std::string::npos)
+      continue;
+
+    const auto bench_result = run_bench_case(bench_case, bench_option);
+    std::cout << std::left << std::setw(84) << bench_result.m_name << std::right << std::setw(12) << bench_result.m_iterationNum
+              << std::fixed << std::setprecision(3)
+              << std::setw(14) << bench_result.m_medianNanoseconds / 1.0e3
+              << std::setw(14) << bench_result.m_minNanoseconds / 1.0e3 << std::endl;
+
+    nlohmann::json bench_json;
+    bench_json["name"] = bench_result.m_name;
+    bench_json["iterations"] = bench_result.m_iterationNum;
+    bench_json["median_ns"] = bench_result.m_medianNanoseconds;
+    bench_json["min_ns"] = bench_result.m_minNanoseconds;
+    result_json["benchmarks"].push_back(bench_json);
+  }
+
+  if (!bench_option.m_resultJsonPath.empty())
+  {
+    std::ofstream result_ofs(bench_option.m_resultJsonPath);
+    result_ofs << result_json.dump(2);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+#include "BeaconSynth.hpp"
+
+// Settings of gcb-check-result (given by command line)
+struct CheckOption
+{
+  std::string m_definitionFilePath = "../assets/beacon_device_definition.json";
+  std::string m_groundTruthJsonPath;
+  std::string m_resultJsonPath;
+  uint32_t m_maxLevelError = 8;     // max difference of one LED (levels of 0 ~ 31)
+  double m_maxMeanLevelError = 2.0; // max mean difference of all LEDs
+};
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-check-result [-d definition_json] [-t max_level_error] [-e max_mean_level_error]\n"
+            << "                        <truth_json> <result_json>\n"
+            << "  truth_json is written by gcb-synth-video, result_json by gcb-analyze or /analyzation_result\n"
+            << "  truth levels are normalized like analyzed LED patterns (b* of rendered LED color, min-max per device)\n"
+            << "  fails when frames differ, markers of a frame are not found (all LEDs 0),\n"
+            << "  one LED differs by more than max_level_error (default 8) or the mean by more than max_mean_level_error (default 2.0)"
+            << std::endl;
+}
+
+/// @brief parse command line of gcb-check-result
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param check_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, CheckOption &check_option)
+{
+  std::vector<std::string> positional_arg_list;
+
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg.size() != 2 || arg[0] != '-')
+    {
+      positional_arg_list.push_back(arg);
+      continue;
+    }
+
+    if (arg == "-h" || arg_idx + 1 >= argc)
+      return false;
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-d")
+      check_option.m_definitionFilePath = value;
+    else if (arg == "-t")
+      check_option.m_maxLevelError = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-e")
+      check_option.m_maxMeanLevelError = std::stod(value);
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (positional_arg_list.size() != 2)
+    return false;
+  check_option.m_groundTruthJsonPath = positional_arg_list[0];
+  check_option.m_resultJsonPath = positional_arg_list[1];
+
+  return true;
+}
+
+/// @brief read JSON file
+/// @param json_file_path Read file path
+/// @return JSON object (throws std::runtime_error when file cannot be opened)
+static nlohmann::json read_json_file(const std::string &json_file_path)
+{
+  std::ifstream json_ifs(json_file_path);
+  if (json_ifs.fail())
+    throw std::runtime_error("File Open Error: " + json_file_path);
+
+  return nlohmann::json::parse(json_ifs);
+}
+
+/// @brief get Lab b* of rendered LED (value read by analyzer before normalization, without blur and noise)
+/// @param led_color LED color of device definition
+/// @param led_level Lighting level (0 ~ 31)
+/// @return b* of OpenCV 8 bit Lab
+static int32_t get_rendered_lab_b(const std::string &led_color, const uint8_t &led_level)
+{
+  cv::Mat led_bgr(1, 1, CV_8UC3, BeaconSynth::get_led_bgr_color(led_color, led_level));
+  cv::Mat led_lab;
+  cv::cvtColor(led_bgr, led_lab, cv::COLOR_BGR2Lab);
+
+  return led_lab.at<cv::Vec3b>(0, 0)[2];
+}
+
+/// @brief normalize values into level of 0~31 (same formula as normalized LED pattern of analyzer)
+/// @param value_list Values of all LEDs on device
+/// @return Normalized levels (all 0 when values are equal)
+static std::vector<uint8_t> normalize_levels(const std::vector<int32_t> &value_list)
+{
+  const auto [min_value_iter, max_value_iter] = std::minmax_element(value_list.begin(), value_list.end());
+  const auto divider = *max_value_iter - *min_value_iter;
+
+  std::vector<uint8_t> level_list(value_list.size(), 0U);
+  if (divider <= 0)
+    return level_list;
+
+  for (size_t led_idx = 0; led_idx < value_list.size(); led_idx++)
+    level_list[led_idx] = static_cast<uint8_t>((static_cast<double>(value_list[led_idx] - *min_value_iter) / divider) * 31U);
+
+  return level_list;
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  CheckOption check_option;
+  if (!parse_arguments(argc, argv, check_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const GCB::BeaconAnalyzer beacon_analyzer(check_option.m_definitionFilePath);
+  const auto truth_json = read_json_file(check_option.m_groundTruthJsonPath);
+  const auto result_json = read_json_file(check_option.m_resultJsonPath);
+
+  const uint64_t frame_num = truth_json.at("frame_num");
+  if (result_json.value("frame_num", uint64_t(0)) != frame_num)
+  {
+    std::cout << "frame_num differs: " << result_json.value("frame_num", uint64_t(0)) << " (truth: " << frame_num << ")"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  uint64_t unfound_frame_num = 0;
+  uint64_t led_num = 0;
+  uint64_t total_level_error = 0;
+  uint32_t max_level_error = 0;
+  std::vector<int32_t> expected_value_list;
+  for (uint64_t frame_count = 0; frame_count < frame_num; frame_count++)
+  {
+    const auto frame_id = "Frame" + std::to_string(frame_count);
+    const auto &truth_frame_json = truth_json.at(frame_id);
+    const auto result_frame_iter = result_json.find(frame_id);
+
+    for (const auto &device_key_item : truth_frame_json.at("device_keys").items())
+    {
+      const auto &device_key = device_key_item.key();
+      const auto &truth_device_json = truth_frame_json.at(device_key);
+      const auto &device_definition = beacon_analyzer.getDeviceDefinitions().at(truth_device_json.at("device_name"));
+      const auto &beacon_list = device_definition.m_beaconList;
+      if (result_frame_iter == result_json.end() || !result_frame_iter->contains(device_key))
+      {
+        std::cout << frame_id << " " << device_key << ": no result" << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      /* levels of truth and result (index: beacon ordinal - 1) */
+      const auto &truth_beacon_json = truth_device_json.at("beacon");
+      const auto &result_beacon_json = result_frame_iter->at(device_key).at("beacon");
+      expected_value_list.resize(beacon_list.size());
+      std::vector<uint8_t> result_level_list(beacon_list.size());
+      for (size_t led_idx = 0; led_idx < beacon_list.size(); led_idx++)
+      {
+        const auto led_id = "ID" + std::to_string(led_idx + 1U);
+        expected_value_list[led_idx] = get_rendered_lab_b(beacon_list[led_idx].m_color, truth_beacon_json.at(led_id).get<uint8_t>());
+        result_level_list[led_idx] = result_beacon_json.at(led_id).get<uint8_t>();
+      }
+      const auto expected_level_list = normalize_levels(expected_value_list);
+      /* end: levels of truth and result */
+
+      // dummy result of frame whose markers are not found
+      if (*std::max_element(result_level_list.begin(), result_level_list.end()) == 0U)
+      {
+        std::cout << frame_id << " " << device_key << ": markers are not found" << std::endl;
+        unfound_frame_num++;
+        continue;
+      }
+
+      for (size_t led_idx = 0; led_idx < beacon_list.size(); led_idx++)
+      {
+        const auto level_error = static_cast<uint32_t>(std::abs(expected_level_list[led_idx] - result_level_list[led_idx]));
+        if (level_error > check_option.m_maxLevelError)
+          std::cout << frame_id << " " << device_key << " ID" << (led_idx + 1U) << ": " << static_cast<uint32_t>(result_level_list[led_idx])
+                    << " (expected: " << static_cast<uint32_t>(expected_level_list[led_idx]) << ")" << std::endl;
+        max_level_error = std::max(max_level_error, level_error);
+        total_level_error += level_error;
+      }
+      led_num += beacon_list.size();
+    }
+  }
+
+  const auto mean_level_error = (led_num > 0U) ? static_cast<double>(total_level_error) / static_cast<double>(led_num) : 0.0;
+  std::cout << frame_num << " frames: max level error " << max_level_error << " (tolerance: " << check_option.m_maxLevelError
+            << "), mean level error " << mean_level_error << " (tolerance: " << check_option.m_maxMeanLevelError << "), "
+            << unfound_frame_num << " devices without markers" << std::endl;
+
+  const auto is_passed = unfound_frame_num == 0U && led_num > 0U && max_level_error <= check_option.m_maxLevelError &&
+                         mean_level_error <= check_option.m_maxMeanLevelError;
+  return is_passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,152 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GCB/Pipeline.hpp"
+
+// Settings of gcb-pipeline-stress (given by command line)
+struct StressOption
+{
+  uint32_t m_producerNum = 8;
+  uint64_t m_itemNum = 4000;
+  uint32_t m_slowMicroseconds = 2000; // time of one slow producer per item (others are not delayed)
+  uint32_t m_roundNum = 3;
+};
+
+// Item passed through reorder buffer (payload is swapped like analysis results)
+struct StressItem
+{
+  uint64_t m_sequence = 0;
+  std::vector<uint64_t> m_payload;
+};
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-pipeline-stress [-w producers] [-n items] [-s slow_producer_us] [-r rounds]\n"
+            << "  one producer is slowed down, the others run ahead of it until reorder window is full\n"
+            << "  (exit code is not 0 on wrong order, lost items or hang detected by ctest timeout)" << std::endl;
+}
+
+/// @brief parse command line of gcb-pipeline-stress
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param stress_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, StressOption &stress_option)
+{
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg == "-h" || arg_idx + 1 >= argc)
+      return false;
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-w")
+      stress_option.m_producerNum = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-n")
+      stress_option.m_itemNum = std::stoull(value);
+    else if (arg == "-s")
+      stress_option.m_slowMicroseconds = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-r")
+      stress_option.m_roundNum = static_cast<uint32_t>(std::stoul(value));
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  return stress_option.m_producerNum > 0;
+}
+
+/// @brief produce items out of order like frame workers (sequences are taken in order, one producer is slow)
+/// @param stress_option Settings
+/// @param abort_sequence Producer of this sequence aborts buffer instead of putting it (itemNum: never)
+/// @return Number of items taken in order (itemNum + 1 on wrong order or payload)
+static uint64_t run_round(const StressOption &stress_option, const uint64_t &abort_sequence)
+{
+  // same window as VideoAnalyzer (2 slots per worker)
+  Pipeline::ReorderBuffer<StressItem> reorder_buffer(static_cast<size_t>(stress_option.m_producerNum) * 2U,
+                                                     stress_option.m_producerNum);
+  std::atomic<uint64_t> next_sequence(0);
+
+  std::vector<std::thread> producer_list;
+  for (uint32_t producer_idx = 0; producer_idx < stress_option.m_producerNum; producer_idx++)
+  {
+    producer_list.emplace_back(
+        [&, producer_idx]()
+        {
+          StressItem stress_item;
+          for (auto sequence = next_sequence++; sequence < stress_option.m_itemNum; sequence = next_sequence++)
+          {
+            if (producer_idx == 0)
+              std::this_thread::sleep_for(std::chrono::microseconds(stress_option.m_slowMicroseconds));
+            if (sequence == abort_sequence)
+            {
+              reorder_buffer.abort();
+              break;
+            }
+
+            stress_item.m_sequence = sequence;
+            stress_item.m_payload.assign(1U + sequence % 7U, sequence);
+            if (!reorder_buffer.put(sequence, stress_item))
+              break;
+          }
+          reorder_buffer.finishProducer();
+        });
+  }
+
+  uint64_t taken_item_num = 0;
+  bool is_item_valid = true;
+  StressItem stress_item;
+  while (reorder_buffer.take(stress_item))
+  {
+    is_item_valid = is_item_valid && stress_item.m_sequence == taken_item_num &&
+                    stress_item.m_payload.size() == 1U + taken_item_num % 7U &&
+                    stress_item.m_payload.back() == taken_item_num;
+    taken_item_num++;
+  }
+
+  for (auto &producer : producer_list)
+    producer.join();
+
+  return is_item_valid ? taken_item_num : stress_option.m_itemNum + 1U;
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  StressOption stress_option;
+  if (!parse_arguments(argc, argv, stress_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  for (uint32_t round_idx = 0; round_idx < stress_option.m_roundNum; round_idx++)
+  {
+    // all items are taken in order although one producer is far behind the others
+    const auto begin_time = std::chrono::steady_clock::now();
+    const auto taken_item_num = run_round(stress_option, stress_option.m_itemNum);
+    const auto elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin_time).count();
+    std::cout << "round " << round_idx << ": " << taken_item_num << "/" << stress_option.m_itemNum
+              << " items in order (" << elapsed_seconds << " s)" << std::endl;
+    if (taken_item_num != stress_option.m_itemNum)
+      return EXIT_FAILURE;
+
+    // failed producer wakes consumer and the other producers (no item after the failed one is taken)
+    const auto abort_sequence = stress_option.m_itemNum / 2U + round_idx;
+    const auto aborted_item_num = run_round(stress_option, abort_sequence);
+    std::cout << "round " << round_idx << ": aborted at " << abort_sequence << " after " << aborted_item_num
+              << " items" << std::endl;
+    if (aborted_item_num > abort_sequence)
+      return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
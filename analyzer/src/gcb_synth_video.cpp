@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include "BeaconSynth.hpp"
+
+// Settings of gcb-synth-video (given by command line)
+struct SynthOption
+{
+  std::string m_definitionFilePath = "../assets/beacon_device_definition.json";
+  std::string m_videoFilePath = "../data/synth/synth.mp4"; // ".mp4": mp4v video, ".bgr": raw bgr24 frame stream
+  std::string m_groundTruthJsonPath; // empty: <video stem>_truth.json next to video
+  std::string m_requestJsonPath;     // empty: <video stem>_request.json next to video
+  std::vector<std::string> m_deviceNameList; // empty: every device of definition
+  nlohmann::json m_requestOptionJson = nlohmann::json::object(); // options set to every device of request JSON
+  cv::Size m_frameSize = cv::Size(1920, 1080);
+  uint64_t m_frameNum = 300;
+  double m_fps = 240.0;
+  uint64_t m_seed = 1;
+  std::string m_patternName = "random"; // "random": seeded levels, "counter": level increases by frame
+  double m_tiltRatio = 0.02;     // perspective distortion (ratio of roi size)
+  double m_motionPixels = 4.0;   // amplitude of device shake in roi
+  double m_noiseSigma = 2.0;     // gaussian noise of pixel value (0: off)
+  double m_blurSigma = 0.0;      // gaussian blur of frame (0: off)
+};
+
+// Synthetic device placed in frame
+struct SynthDevice
+{
+  const GCB::Inside::DeviceDefinition *m_deviceDefinition;
+  uint64_t m_deviceId;
+  std::string m_deviceKey; // device_name + device_id (same key as AnalyzationResultWriter)
+  cv::Rect m_roiRect;      // rect of request JSON
+  std::array<cv::Point2f, 4> m_deviceCorners; // corners without shake
+  double m_renderScale;
+};
+
+static constexpr double DEVICE_FILL_RATIO = 0.85; // device size in roi (roi has margin like real requests)
+static constexpr double CELL_ROI_RATIO = 0.9;     // roi size in grid cell
+static const cv::Scalar BACKGROUND_COLOR(16, 16, 16);
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-synth-video [-d definition_json] [-o video(.mp4|.bgr)] [-g truth_json] [-q request_json]\n"
+            << "                       [-D device_name,...] [-W width] [-H height] [-n frames] [-r fps] [-s seed]\n"
+            << "                       [-P random|counter] [-p tilt_ratio] [-m motion_px] [-N noise_sigma] [-b blur_sigma]\n"
+            << "                       [-O request_option=value ...]\n"
+            << "  -O: option of every device in request JSON (e.g. sampling_mode=source_roi, analysis_scale=0.5, marker_tracking=true)\n"
+            << "  same options give identical frames and ground truth (\".bgr\": read by ffmpeg -f rawvideo -pix_fmt bgr24)"
+            << std::endl;
+}
+
+/// @brief parse command line of gcb-synth-video
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param synth_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, SynthOption &synth_option)
+{
+  for (int arg_idx = 1; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg == "-h" || arg_idx + 1 >= argc)
+      return false;
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-d")
+      synth_option.m_definitionFilePath = value;
+    else if (arg == "-o")
+      synth_option.m_videoFilePath = value;
+    else if (arg == "-g")
+      synth_option.m_groundTruthJsonPath = value;
+    else if (arg == "-q")
+      synth_option.m_requestJsonPath = value;
+    else if (arg == "-D")
+    {
+      std::stringstream device_name_stream(value);
+      std::string device_name;
+      while (std::getline(device_name_stream, device_name, ','))
+        synth_option.m_deviceNameList.push_back(device_name);
+    }
+    else if (arg == "-W")
+      synth_option.m_frameSize.width = std::stoi(value);
+    else if (arg == "-H")
+      synth_option.m_frameSize.height = std::stoi(value);
+    else if (arg == "-n")
+      synth_option.m_frameNum = std::stoull(value);
+    else if (arg == "-r")
+      synth_option.m_fps = std::stod(value);
+    else if (arg == "-s")
+      synth_option.m_seed = std::stoull(value);
+    else if (arg == "-P")
+      synth_option.m_patternName = value;
+    else if (arg == "-p")
+      synth_option.m_tiltRatio = std::stod(value);
+    else if (arg == "-m")
+      synth_option.m_motionPixels = std::stod(value);
+    else if (arg == "-N")
+      synth_option.m_noiseSigma = std::stod(value);
+    else if (arg == "-b")
+      synth_option.m_blurSigma = std::stod(value);
+    else if (arg == "-O")
+    {
+      // value is JSON (number, true, ...) or string
+      const auto separator_pos = value.find('=');
+      if (separator_pos == std::string::npos || separator_pos == 0)
+      {
+        std::cout << "request option must be key=value: " << value << std::endl;
+        return false;
+      }
+      const auto option_value = value.substr(separator_pos + 1);
+      auto option_value_json = nlohmann::json::parse(option_value, nullptr, false);
+      if (option_value_json.is_discarded())
+        option_value_json = option_value;
+      synth_option.m_requestOptionJson[value.substr(0, separator_pos)] = option_value_json;
+    }
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  if (synth_option.m_patternName != "random" && synth_option.m_patternName != "counter")
+  {
+    std::cout << "unknown pattern: " << synth_option.m_patternName << std::endl;
+    return false;
+  }
+
+  return synth_option.m_frameSize.area() > 0 && synth_option.m_fps > 0.0;
+}
+
+/// @brief splitmix64 hash (same value on every platform, unlike std distributions)
+/// @param value Hashed value
+/// @return Hash value
+static uint64_t get_splitmix64_hash(uint64_t value)
+{
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+/// @brief get LED level of beacon in frame
+/// @param synth_option Pattern and seed
+/// @param frame_idx Frame index
+/// @param device_idx Index of device in frame
+/// @param beacon_idx Beacon ordinal - 1
+/// @return LED level (0 ~ 31)
+static uint8_t get_led_level(const SynthOption &synth_option, const uint64_t &frame_idx,
+                             const size_t &device_idx, const size_t &beacon_idx)
+{
+  if (synth_option.m_patternName == "counter")
+    return static_cast<uint8_t>((frame_idx + device_idx * 11U + beacon_idx) % BeaconSynth::LED_LEVEL_NUM);
+
+  const auto hash = get_splitmix64_hash(synth_option.m_seed ^ get_splitmix64_hash(
+                                            (frame_idx << 24) ^ (static_cast<uint64_t>(device_idx) << 16) ^ beacon_idx));
+  return static_cast<uint8_t>(hash % BeaconSynth::LED_LEVEL_NUM);
+}
+
+/// @brief place devices on grid of frame
+/// @param beacon_analyzer Analyzer having device definition
+/// @param synth_option Device names and frame size
+/// @return Placed devices
+static std::vector<SynthDevice> place_synth_devices(const GCB::BeaconAnalyzer &beacon_analyzer,
+                                                    const SynthOption &synth_option)
+{
+  const auto &device_name_list =
+      synth_option.m_deviceNameList.empty() ? beacon_analyzer.getDeviceNames() : synth_option.m_deviceNameList;
+  const auto device_num = device_name_list.size();
+  const auto column_num = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(device_num))));
+  const auto row_num = (device_num + column_num - 1) / column_num;
+  const cv::Size2f cell_size(static_cast<float_t>(synth_option.m_frameSize.width) / static_cast<float_t>(column_num),
+                             static_cast<float_t>(synth_option.m_frameSize.height) / static_cast<float_t>(row_num));
+
+  std::vector<SynthDevice> synth_device_list;
+  std::unordered_map<std::string, uint64_t> device_id_map; // key: device_name, value: next device_id
+  for (size_t device_idx = 0; device_idx < device_num; device_idx++)
+  {
+    const auto &device_name = device_name_list[device_idx];
+    SynthDevice synth_device;
+    synth_device.m_deviceDefinition = &beacon_analyzer.getDeviceDefinitions().at(device_name);
+    synth_device.m_deviceId = device_id_map[device_name]++;
+    synth_device.m_deviceKey = device_name + std::to_string(synth_device.m_deviceId);
+
+    /* roi in center of grid cell */
+    const cv::Point2f cell_tl(cell_size.width * static_cast<float_t>(device_idx % column_num),
+                              cell_size.height * static_cast<float_t>(device_idx / column_num));
+    const auto roi_size = cell_size * static_cast<float_t>(CELL_ROI_RATIO);
+    const auto roi_tl = cell_tl + cv::Point2f(cell_size.width - roi_size.width, cell_size.height - roi_size.height) / 2.0f;
+    synth_device.m_roiRect = cv::Rect(cv::Rect2f(roi_tl, roi_size));
+    /* end: roi in center of grid cell */
+
+    const auto &template_size = synth_device.m_deviceDefinition->m_deviceTemplateSize;
+    synth_device.m_deviceCorners = BeaconSynth::get_device_corners(
+        template_size, cv::Rect2f(synth_device.m_roiRect), DEVICE_FILL_RATIO, synth_option.m_tiltRatio);
+
+    // render twice of drawn size (area interpolation smooths LED edges)
+    synth_device.m_renderScale =
+        std::min(1.0, 2.0 * DEVICE_FILL_RATIO * std::max(static_cast<double>(synth_device.m_roiRect.width) / template_size.width,
+                                                         static_cast<double>(synth_device.m_roiRect.height) / template_size.height));
+
+    synth_device_list.push_back(synth_device);
+  }
+
+  return synth_device_list;
+}
+
+/// @brief get path next to video ("<dir>/<video stem><suffix>")
+/// @param video_file_path Video path
+/// @param suffix Suffix of path
+/// @return Path
+static std::string get_path_next_to_video(const std::string &video_file_path, const std::string &suffix)
+{
+  const std::filesystem::path video_path(video_file_path);
+  return (video_path.parent_path() / video_path.stem()).string() + suffix;
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  SynthOption synth_option;
+  if (!parse_arguments(argc, argv, synth_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+  if (synth_option.m_groundTruthJsonPath.empty())
+    synth_option.m_groundTruthJsonPath = get_path_next_to_video(synth_option.m_videoFilePath, "_truth.json");
+  if (synth_option.m_requestJsonPath.empty())
+    synth_option.m_requestJsonPath = get_path_next_to_video(synth_option.m_videoFilePath, "_request.json");
+
+  const GCB::BeaconAnalyzer beacon_analyzer(synth_option.m_definitionFilePath);
+  const auto synth_device_list = place_synth_devices(beacon_analyzer, synth_option);
+
+  /* request JSON (input of gcb-analyze and /analyze_video) */
+  nlohmann::json request_json;
+  request_json["device_key"] = nlohmann::json::array();
+  for (const auto &synth_device : synth_device_list)
+  {
+    request_json["device_key"].push_back(synth_device.m_deviceKey);
+    request_json[synth_device.m_deviceKey] = {
+        {"device_name", synth_device.m_deviceDefinition->m_deviceName},
+        {"device_id", synth_device.m_deviceId},
+        {"rect_x", synth_device.m_roiRect.x},
+        {"rect_y", synth_device.m_roiRect.y},
+        {"rect_width", synth_device.m_roiRect.width},
+        {"rect_height", synth_device.m_roiRect.height}};
+    request_json[synth_device.m_deviceKey].update(synth_option.m_requestOptionJson);
+  }
+  /* end: request JSON */
+
+  /* open output */
+  const auto video_parent_path = std::filesystem::path(synth_option.m_videoFilePath).parent_path();
+  if (!video_parent_path.empty())
+    std::filesystem::create_directories(video_parent_path);
+
+  const auto is_raw_output = std::filesystem::path(synth_option.m_videoFilePath).extension() == ".bgr";
+  std::ofstream raw_ofs;
+  cv::VideoWriter video_writer;
+  if (is_raw_output)
+    raw_ofs.open(synth_option.m_videoFilePath, std::ios::binary);
+  else
+    video_writer.open(synth_option.m_videoFilePath, cv::VideoWriter::fourcc('m', 'p', '4', 'v'),
+                      synth_option.m_fps, synth_option.m_frameSize);
+
+  if (is_raw_output ? raw_ofs.fail() : !video_writer.isOpened())
+  {
+    std::cout << "File Open Error: " << synth_option.m_videoFilePath << std::endl;
+    return EXIT_FAILURE;
+  }
+  /* end: open output */
+
+  // ground truth has the same layout as analysis result JSON (levels are not normalized)
+  GCB::AnalyzationResultWriter ground_truth_writer;
+  cv::RNG noise_rng(synth_option.m_seed);
+  cv::Mat frame, noise_img;
+  std::vector<uint8_t> led_level_list;
+  const auto pi = std::acos(-1.0);
+  for (uint64_t frame_idx = 0; frame_idx < synth_option.m_frameNum; frame_idx++)
+  {
+    frame.create(synth_option.m_frameSize, CV_8UC3);
+    frame.setTo(BACKGROUND_COLOR);
+    const auto frame_seconds = static_cast<double>(frame_idx) / synth_option.m_fps;
+
+    for (size_t device_idx = 0; device_idx < synth_device_list.size(); device_idx++)
+    {
+      const auto &synth_device = synth_device_list[device_idx];
+      const auto &device_definition = *synth_device.m_deviceDefinition;
+
+      led_level_list.resize(device_definition.m_beaconList.size());
+      for (size_t beacon_idx = 0; beacon_idx < led_level_list.size(); beacon_idx++)
+        led_level_list[beacon_idx] = get_led_level(synth_option, frame_idx, device_idx, beacon_idx);
+
+      // shake of hand-held camera (about 2 Hz, phase differs by device)
+      const auto shake_phase = 2.0 * pi * (2.0 * frame_seconds + 0.37 * static_cast<double>(device_idx));
+      const cv::Point2f shake_offset(static_cast<float_t>(synth_option.m_motionPixels * std::sin(shake_phase)),
+                                     static_cast<float_t>(synth_option.m_motionPixels * std::cos(1.3 * shake_phase)));
+      auto device_corners = synth_device.m_deviceCorners;
+      for (auto &device_corner : device_corners)
+        device_corner += shake_offset;
+
+      BeaconSynth::draw_device(
+          frame, BeaconSynth::render_device_template(device_definition, led_level_list, synth_device.m_renderScale),
+          device_corners);
+
+      GCB::AnalyzationResult ground_truth;
+      ground_truth.m_deviceName = device_definition.m_deviceName;
+      ground_truth.m_deviceId = synth_device.m_deviceId;
+      ground_truth.m_devicePositionRect = synth_device.m_roiRect;
+      ground_truth.m_ledPatternList = led_level_list;
+      ground_truth_writer.writeAnalyzedLedPattern(ground_truth, frame_idx);
+    }
+
+    /* camera degradation */
+    if (synth_option.m_blurSigma > 0.0)
+      cv::GaussianBlur(frame, frame, cv::Size(), synth_option.m_blurSigma);
+
+    if (synth_option.m_noiseSigma > 0.0)
+    {
+      noise_img.create(frame.size(), CV_16SC3);
+      noise_rng.fill(noise_img, cv::RNG::NORMAL, 0.0, synth_option.m_noiseSigma);
+      cv::add(frame, noise_img, frame, cv::noArray(), CV_8U);
+    }
+    /* end: camera degradation */
+
+    if (is_raw_output)
+      raw_ofs.write(reinterpret_cast<const char *>(frame.data), static_cast<std::streamsize>(frame.total() * frame.elemSize()));
+    else
+      video_writer.write(frame);
+  }
+
+  ground_truth_writer.outputJson(synth_option.m_groundTruthJsonPath, synth_option.m_frameNum);
+
+  std::ofstream request_ofs(synth_option.m_requestJsonPath);
+  request_ofs << request_json.dump(2);
+  request_ofs.close();
+
+  std::cout << "wrote " << synth_option.m_frameNum << " frames (" << synth_option.m_frameSize << ", "
+            << synth_option.m_fps << " fps) -> " << synth_option.m_videoFilePath << "\n"
+            << "ground truth -> " << synth_option.m_groundTruthJsonPath << "\n"
+            << "request -> " << synth_option.m_requestJsonPath << std::endl;
+
+  return EXIT_SUCCESS;
+}
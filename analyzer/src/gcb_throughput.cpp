@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef GCB_THROUGHPUT_HTTP
+#include <drogon/drogon.h>
+#include <trantor/net/EventLoopThread.h>
+#endif
+
+#include "GCB.hpp"
+
+// Settings of gcb-throughput (given by command line)
+struct ThroughputOption
+{
+  std::string m_modeName; // "video" or "http"
+  std::string m_inputFilePath; // video (video mode), picture (http mode)
+  std::string m_requestJsonPath;
+  std::string m_definitionFilePath = "../assets/beacon_device_definition.json";
+  uint32_t m_workerNum = 0;   // video: worker threads (0: number of hardware threads)
+  uint32_t m_roundNum = 1;    // video: times the video is analyzed
+  std::string m_serverUrl = "http://127.0.0.1:8080";
+  uint32_t m_concurrencyNum = 1; // http: clients sending requests at the same time
+  uint64_t m_requestNum = 1000;  // http: requests of all clients
+  ::pid_t m_serverPid = 0;       // http: server process measured for RSS and CPU (0: not measured)
+  std::string m_resultJsonPath;   // empty: not written
+  std::string m_baselineJsonPath; // empty: no comparison
+  double m_tolerance = 0.05;      // allowed relative regression
+};
+
+// Resource usage of measured process
+struct ProcessUsage
+{
+  double m_cpuSeconds = 0.0;
+  uint64_t m_peakRssKilobytes = 0;
+};
+
+static void print_usage()
+{
+  std::cout << "usage: gcb-throughput video <video> <request_json> [-d definition_json] [-w workers] [-R rounds] [options]\n"
+            << "       gcb-throughput http <picture> <request_json> [-u server_url] [-c concurrency] [-n requests] [-p server_pid] [options]\n"
+            << "options: [-o result_json] [-b baseline_json] [-T tolerance (default 0.05)]\n"
+            << "  -b: compare with result_json of earlier run, exit with failure if fps, latency or peak RSS regress\n"
+            << "      (or if any request failed, failed requests are not counted in fps and latency)"
+            << std::endl;
+}
+
+/// @brief parse command line of gcb-throughput
+/// @param argc Argument count
+/// @param argv Argument vector
+/// @param throughput_option Parsed settings
+/// @return true: success, false: invalid arguments
+static bool parse_arguments(const int argc, char **argv, ThroughputOption &throughput_option)
+{
+  if (argc < 4)
+    return false;
+
+  throughput_option.m_modeName = argv[1];
+  throughput_option.m_inputFilePath = argv[2];
+  throughput_option.m_requestJsonPath = argv[3];
+
+  for (int arg_idx = 4; arg_idx < argc; arg_idx++)
+  {
+    const std::string arg = argv[arg_idx];
+    if (arg_idx + 1 >= argc)
+      return false;
+
+    const std::string value = argv[++arg_idx];
+    if (arg == "-d")
+      throughput_option.m_definitionFilePath = value;
+    else if (arg == "-w")
+      throughput_option.m_workerNum = static_cast<uint32_t>(std::stoul(value));
+    else if (arg == "-R")
+      throughput_option.m_roundNum = std::max(1U, static_cast<uint32_t>(std::stoul(value)));
+    else if (arg == "-u")
+      throughput_option.m_serverUrl = value;
+    else if (arg == "-c")
+      throughput_option.m_concurrencyNum = std::max(1U, static_cast<uint32_t>(std::stoul(value)));
+    else if (arg == "-n")
+      throughput_option.m_requestNum = std::stoull(value);
+    else if (arg == "-p")
+      throughput_option.m_serverPid = static_cast<::pid_t>(std::stol(value));
+    else if (arg == "-o")
+      throughput_option.m_resultJsonPath = value;
+    else if (arg == "-b")
+      throughput_option.m_baselineJsonPath = value;
+    else if (arg == "-T")
+      throughput_option.m_tolerance = std::stod(value);
+    else
+    {
+      std::cout << "unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+
+  return throughput_option.m_modeName == "video" || throughput_option.m_modeName == "http";
+}
+
+/// @brief read whole text file
+/// @param file_path Read file path
+/// @return File content (throws std::runtime_error when file cannot be opened)
+static std::string read_text_file(const std::string &file_path)
+{
+  std::ifstream ifs(file_path);
+  if (ifs.fail())
+    throw std::runtime_error("File Open Error: " + file_path);
+
+  std::string text, line;
+  while (std::getline(ifs, line))
+    text.append(line);
+
+  return text;
+}
+
+/// @brief get resource usage of this process
+/// @return CPU time (user + system) and peak RSS
+static ProcessUsage get_self_usage()
+{
+  ::rusage resource_usage;
+  ::getrusage(RUSAGE_SELF, &resource_usage);
+
+  ProcessUsage process_usage;
+  process_usage.m_cpuSeconds =
+      static_cast<double>(resource_usage.ru_utime.tv_sec + resource_usage.ru_stime.tv_sec) +
+      static_cast<double>(resource_usage.ru_utime.tv_usec + resource_usage.ru_stime.tv_usec) * 1e-6;
+  process_usage.m_peakRssKilobytes = static_cast<uint64_t>(resource_usage.ru_maxrss); // kilobytes on Linux
+
+  return process_usage;
+}
+
+/// @brief get resource usage of another process (/proc/<pid>/stat and /proc/<pid>/status)
+/// @param pid Process id
+/// @return CPU time (user + system) and peak RSS (zero if process cannot be read)
+static ProcessUsage get_process_usage(const ::pid_t &pid)
+{
+  ProcessUsage process_usage;
+  const auto proc_dir_path = "/proc/" + std::to_string(pid);
+
+  std::ifstream stat_ifs(proc_dir_path + "/stat");
+  std::string stat_line;
+  if (std::getline(stat_ifs, stat_line))
+  {
+    // fields after "(comm)": state is field 3, utime and stime are fields 14 and 15
+    std::istringstream stat_stream(stat_line.substr(stat_line.rfind(')') + 2));
+    std::string field;
+    uint64_t utime_ticks = 0, stime_ticks = 0;
+    for (int32_t field_idx = 3; field_idx <= 15 && stat_stream >> field; field_idx++)
+    {
+      if (field_idx == 14)
+        utime_ticks = std::stoull(field);
+      else if (field_idx == 15)
+        stime_ticks = std::stoull(field);
+    }
+    process_usage.m_cpuSeconds = static_cast<double>(utime_ticks + stime_ticks) / static_cast<double>(::sysconf(_SC_CLK_TCK));
+  }
+
+  std::ifstream status_ifs(proc_dir_path + "/status");
+  std::string status_line;
+  while (std::getline(status_ifs, status_line))
+  {
+    if (status_line.rfind("VmHWM:", 0) == 0)
+      process_usage.m_peakRssKilobytes = std::stoull(status_line.substr(6));
+  }
+
+  return process_usage;
+}
+
+/// @brief get percentile of sorted latencies (nearest rank)
+/// @param sorted_latency_list Latencies sorted in ascending order
+/// @param percentile Percentile (0.0 ~ 100.0)
+/// @return Latency (0 if empty)
+static uint64_t get_percentile(const std::vector<uint64_t> &sorted_latency_list, const double &percentile)
+{
+  if (sorted_latency_list.empty())
+    return 0;
+
+  const auto rank = static_cast<size_t>(std::ceil(percentile / 100.0 * static_cast<double>(sorted_latency_list.size())));
+  return sorted_latency_list[std::clamp<size_t>(rank, 1, sorted_latency_list.size()) - 1];
+}
+
+/// @brief create result JSON of measurement
+/// @param frame_num Frames (or requests) processed
+/// @param elapsed_seconds Wall-clock time of measurement
+/// @param latency_nanoseconds_list Latency of each frame (or request, sorted in place)
+/// @param process_usage Usage of measured process during measurement
+/// @return Result JSON
+static nlohmann::json get_result_json(const uint64_t &frame_num, const double &elapsed_seconds,
+                                      std::vector<uint64_t> &latency_nanoseconds_list, const ProcessUsage &process_usage)
+{
+  std::sort(latency_nanoseconds_list.begin(), latency_nanoseconds_list.end());
+  const auto to_milliseconds = [](const uint64_t &nanoseconds)
+  { return static_cast<double>(nanoseconds) * 1e-6; };
+
+  const auto hardware_thread_num = std::max(1U, std::thread::hardware_concurrency());
+  const auto cpu_cores = elapsed_seconds > 0.0 ? process_usage.m_cpuSeconds / elapsed_seconds : 0.0;
+
+  nlohmann::json result_json;
+  result_json["frame_num"] = frame_num;
+  result_json["elapsed_s"] = elapsed_seconds;
+  result_json["fps"] = elapsed_seconds > 0.0 ? static_cast<double>(frame_num) / elapsed_seconds : 0.0;
+  result_json["latency_ms"] = {
+      {"p50", to_milliseconds(get_percentile(latency_nanoseconds_list, 50.0))},
+      {"p99", to_milliseconds(get_percentile(latency_nanoseconds_list, 99.0))},
+      {"p999", to_milliseconds(get_percentile(latency_nanoseconds_list, 99.9))},
+      {"max", to_milliseconds(latency_nanoseconds_list.empty() ? 0 : latency_nanoseconds_list.back())}};
+  result_json["peak_rss_kb"] = process_usage.m_peakRssKilobytes;
+  result_json["cpu_s"] = process_usage.m_cpuSeconds;
+  result_json["cpu_cores"] = cpu_cores; // average busy cores
+  result_json["cpu_utilization"] = cpu_cores / hardware_thread_num; // 1.0: all hardware threads busy
+  result_json["hardware_threads"] = hardware_thread_num;
+
+  return result_json;
+}
+
+/// @brief measure video path (decode, analyzePicture per device, AnalyzationResultWriter)
+/// @param throughput_option Video, request and workers
+/// @return Result JSON
+static nlohmann::json measure_video_path(const ThroughputOption &throughput_option)
+{
+  const GCB::BeaconAnalyzer beacon_analyzer(throughput_option.m_definitionFilePath);
+  const auto detection_result_list =
+      GCB::get_detection_result_list_from_json(read_text_file(throughput_option.m_requestJsonPath));
+  const GCB::VideoAnalyzer video_analyzer(beacon_analyzer, throughput_option.m_workerNum);
+
+  uint64_t frame_num = 0;
+  double elapsed_seconds = 0.0, decode_seconds = 0.0, analysis_seconds = 0.0;
+  std::vector<uint64_t> latency_nanoseconds_list;
+  const auto usage_begin = get_self_usage();
+  for (uint32_t round_idx = 0; round_idx < throughput_option.m_roundNum; round_idx++)
+  {
+    cv::VideoCapture video_cap(throughput_option.m_inputFilePath);
+    if (!video_cap.isOpened())
+      throw std::runtime_error("Video Open Error: " + throughput_option.m_inputFilePath);
+
+    const auto round_begin = std::chrono::steady_clock::now();
+    GCB::AnalyzationResultWriter analyzation_result_writer;
+    const auto video_analysis_statistics = video_analyzer.analyzeVideo(
+        video_cap, detection_result_list,
+        [&](const uint64_t &frame_idx, const std::vector<GCB::AnalyzationResult> &analyzation_result_list)
+        {
+          for (const auto &analyzation_result : analyzation_result_list)
+            analyzation_result_writer.writeAnalyzedLedPattern(analyzation_result, frame_idx);
+        });
+    // serialized as the server does before writing result file
+    const auto result_json_size = analyzation_result_writer.getJsonString(video_analysis_statistics.m_frameNum).size();
+    elapsed_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - round_begin).count();
+
+    std::cout << "round " << round_idx << ": " << video_analysis_statistics.m_frameNum << " frames in "
+              << video_analysis_statistics.m_elapsedSeconds << " s (result JSON: " << result_json_size << " bytes)" << std::endl;
+
+    frame_num += video_analysis_statistics.m_frameNum;
+    decode_seconds += video_analysis_statistics.m_decodeSeconds;
+    analysis_seconds += video_analysis_statistics.m_analysisSeconds;
+    latency_nanoseconds_list.insert(latency_nanoseconds_list.end(),
+                                    video_analysis_statistics.m_frameLatencyNanoseconds.begin(),
+                                    video_analysis_statistics.m_frameLatencyNanoseconds.end());
+  }
+
+  auto process_usage = get_self_usage();
+  process_usage.m_cpuSeconds -= usage_begin.m_cpuSeconds;
+
+  auto result_json = get_result_json(frame_num, elapsed_seconds, latency_nanoseconds_list, process_usage);
+  result_json["mode"] = "video";
+  result_json["input"] = throughput_option.m_inputFilePath;
+  result_json["device_num"] = detection_result_list.size();
+  result_json["worker_num"] = video_analyzer.getWorkerNum();
+  result_json["round_num"] = throughput_option.m_roundNum;
+  result_json["decode_s"] = decode_seconds;
+  result_json["analysis_s"] = analysis_seconds;
+
+  return result_json;
+}
+
+#ifdef GCB_THROUGHPUT_HTTP
+/// @brief measure /analyze_picture of running gcb-analyzer server
+/// @param throughput_option Picture, request, server and load
+/// @return Result JSON
+static nlohmann::json measure_http_path(const ThroughputOption &throughput_option)
+{
+  std::mutex latency_mutex;
+  std::vector<uint64_t> latency_nanoseconds_list;
+  std::atomic<uint64_t> next_request_idx(0);
+  std::atomic<uint64_t> failed_request_num(0);
+
+  const auto send_requests = [&]()
+  {
+    // one connection per client (synchronous requests must not be sent from loop thread)
+    trantor::EventLoopThread loop_thread;
+    loop_thread.run();
+    const auto http_client = drogon::HttpClient::newHttpClient(throughput_option.m_serverUrl, loop_thread.getLoop());
+
+    std::vector<uint64_t> client_latency_list;
+    while (next_request_idx++ < throughput_option.m_requestNum)
+    {
+      const drogon::UploadFile image_file(throughput_option.m_inputFilePath, "", "image_file");
+      const drogon::UploadFile request_json_file(throughput_option.m_requestJsonPath, "", "request_json");
+      auto request = drogon::HttpRequest::newFileUploadRequest({image_file, request_json_file});
+      request->setMethod(drogon::Post);
+      request->setPath("/analyze_picture");
+
+      const auto request_begin = std::chrono::steady_clock::now();
+      const auto [request_result, response] = http_client->sendRequest(request);
+      const auto request_time = std::chrono::steady_clock::now() - request_begin;
+
+      // fast error responses (e.g. 503 of full queue) must not count as throughput
+      if (request_result != drogon::ReqResult::Ok || response->getStatusCode() != drogon::k200OK)
+      {
+        failed_request_num++;
+        continue;
+      }
+      client_latency_list.push_back(
+          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(request_time).count()));
+    }
+
+    std::lock_guard<std::mutex> latency_lock(latency_mutex);
+    latency_nanoseconds_list.insert(latency_nanoseconds_list.end(), client_latency_list.begin(), client_latency_list.end());
+  };
+
+  const auto usage_begin = get_process_usage(throughput_option.m_serverPid);
+  const auto measurement_begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> client_thread_list;
+  for (uint32_t client_idx = 0; client_idx < throughput_option.m_concurrencyNum; client_idx++)
+    client_thread_list.emplace_back(send_requests);
+  for (auto &client_thread : client_thread_list)
+    client_thread.join();
+  const auto elapsed_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - measurement_begin).count();
+
+  // server usage is zero when its pid is not given
+  auto process_usage = get_process_usage(throughput_option.m_serverPid);
+  process_usage.m_cpuSeconds -= usage_begin.m_cpuSeconds;
+
+  // fps and latency of succeeded requests only
+  const uint64_t request_num = latency_nanoseconds_list.size();
+  auto result_json = get_result_json(request_num, elapsed_seconds, latency_nanoseconds_list, process_usage);
+  result_json["mode"] = "http";
+  result_json["input"] = throughput_option.m_inputFilePath;
+  result_json["server_url"] = throughput_option.m_serverUrl;
+  result_json["concurrency"] = throughput_option.m_concurrencyNum;
+  result_json["failed_request_num"] = failed_request_num.load();
+
+  return result_json;
+}
+#endif
+
+/// @brief compare result with baseline
+/// @param result_json Result of this run
+/// @param baseline_json Result of earlier run
+/// @param tolerance Allowed relative regression
+/// @return true if no metric regresses and no request failed
+static bool compare_with_baseline(const nlohmann::json &result_json, const nlohmann::json &baseline_json,
+                                  const double &tolerance)
+{
+  // (JSON pointer, whether higher is better)
+  const std::vector<std::pair<std::string, bool>> metric_list = {
+      {"/fps", true},
+      {"/latency_ms/p50", false},
+      {"/latency_ms/p99", false},
+      {"/latency_ms/p999", false},
+      {"/peak_rss_kb", false}};
+
+  // numbers of partly failed run are not comparable
+  const auto failed_request_num = result_json.value("failed_request_num", static_cast<uint64_t>(0));
+  bool is_passed = (failed_request_num == 0);
+  if (!is_passed)
+    std::cout << failed_request_num << " requests failed" << std::endl;
+
+  std::cout << std::left << std::setw(20) << "metric" << std::right << std::setw(14) << "baseline"
+            << std::setw(14) << "current" << std::setw(10) << "change" << std::endl;
+  for (const auto &[metric_pointer, is_higher_better] : metric_list)
+  {
+    const nlohmann::json::json_pointer json_pointer(metric_pointer);
+    if (!baseline_json.contains(json_pointer) || !result_json.contains(json_pointer))
+      continue;
+
+    const auto baseline_value = baseline_json.at(json_pointer).get<double>();
+    const auto current_value = result_json.at(json_pointer).get<double>();
+    // skip unmeasured metric (e.g. RSS of http mode without server pid)
+    if (baseline_value <= 0.0)
+      continue;
+
+    const auto change_ratio = (current_value - baseline_value) / baseline_value;
+    const auto is_regressed = is_higher_better ? (change_ratio < -tolerance) : (change_ratio > tolerance);
+    is_passed &= !is_regressed;
+
+    std::cout << std::left << std::setw(20) << metric_pointer << std::right << std::fixed << std::setprecision(3)
+              << std::setw(14) << baseline_value << std::setw(14) << current_value
+              << std::setw(9) << std::showpos << change_ratio * 100.0 << "%" << std::noshowpos
+              << (is_regressed ? "  REGRESSION" : "") << std::endl;
+  }
+
+  return is_passed;
+}
+
+int main(int argc, char **argv)
+{
+  std::ios::sync_with_stdio(false);
+
+  ThroughputOption throughput_option;
+  if (!parse_arguments(argc, argv, throughput_option))
+  {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  nlohmann::json result_json;
+  if (throughput_option.m_modeName == "video")
+    result_json = measure_video_path(throughput_option);
+  else
+  {
+#ifdef GCB_THROUGHPUT_HTTP
+    result_json = measure_http_path(throughput_option);
+#else
+    std::cout << "http mode needs gcb-throughput built with server (cmake -DGCB_BUILD_SERVER=ON ..)" << std::endl;
+    return EXIT_FAILURE;
+#endif
+  }
+
+  std::cout << result_json.dump(2) << std::endl;
+  if (!throughput_option.m_resultJsonPath.empty())
+  {
+    std::ofstream result_ofs(throughput_option.m_resultJsonPath);
+    result_ofs << result_json.dump(2);
+  }
+
+  if (throughput_option.m_baselineJsonPath.empty())
+    return EXIT_SUCCESS;
+
+  const auto baseline_json = nlohmann::json::parse(read_text_file(throughput_option.m_baselineJsonPath));
+  if (baseline_json.value("mode", "") != result_json["mode"])
+  {
+    std::cout << "baseline is measured in another mode" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return compare_with_baseline(result_json, baseline_json, throughput_option.m_tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 
 #include <drogon/drogon.h>
@@ -7,29 +8,6 @@
 
 static std::shared_ptr<GCB::BeaconAnalyzer> gptr_beacon_analyzer = nullptr;
 
-static std::vector<GCB::DetectionResult> get_device_detection_list_from_json(const std::string &json_string)
-{
-  std::vector<GCB::DetectionResult> detection_result_list;
-
-  const auto json_obj = nlohmann::json::parse(json_string);
-  const std::vector<std::string> device_key_list = json_obj["device_key"];
-
-  for (const auto &device_key : device_key_list)
-  {
-    GCB::DetectionResult detection_result;
-    detection_result.m_deviceName = json_obj[device_key]["device_name"];
-    detection_result.m_deviceId = json_obj[device_key]["device_id"];
-    detection_result.m_positionRect.x = json_obj[device_key]["rect_x"];
-    detection_result.m_positionRect.y = json_obj[device_key]["rect_y"];
-    detection_result.m_positionRect.width = json_obj[device_key]["rect_width"];
-    detection_result.m_positionRect.height = json_obj[device_key]["rect_height"];
-
-    detection_result_list.push_back(detection_result);
-  }
-
-  return detection_result_list;
-}
-
 static std::string analyze_picture(const cv::Mat &picture, const std::vector<GCB::DetectionResult> &detection_result_list)
 {
   GCB::AnalyzationResultWriter analyzation_result_writer;
@@ -146,7 +124,7 @@ static void visualize_analyzation_result(const std::string &analyzation_json_pat
         continue;
       }
 
-      for (const auto &[_, marker] : beacon_device.m_markerHash)
+      for (const auto &marker : beacon_device.m_markerList)
       {
         cv::Scalar marker_color;
 
@@ -157,9 +135,9 @@ static void visualize_analyzation_result(const std::string &analyzation_json_pat
         cv::circle(view_img, marker.m_position, static_cast<int32_t>(marker.m_radius), marker_color, -1);
       }
 
-      for (const auto &[beacon_id, beacon] : beacon_device.m_beaconHash)
+      for (const auto &beacon : beacon_device.m_beaconList)
       {
-        const uint8_t beacon_pattern = device_obj["beacon"][beacon_id];
+        const uint8_t beacon_pattern = device_obj["beacon"]["ID" + std::to_string(beacon.m_ordinal)];
 
         cv::circle(view_img, beacon.m_position, static_cast<int32_t>(beacon.m_radius),
                    cv::Scalar(0, 0, (255 / 32) * beacon_pattern), -1);
@@ -204,15 +182,42 @@ void debug_video()
   while (std::getline(json_ifs, line))
     request_json_file_string.append(line);
 
-  const auto detection_result_list = get_device_detection_list_from_json(request_json_file_string);
+  const auto detection_result_list = GCB::get_detection_result_list_from_json(request_json_file_string);
   analyze_video("../data/input.mp4", detection_result_list);
   // analyze_video("../data/input.mov", detection_result_list);
   visualize_analyzation_result("../data/analyze/result.json", "../data/input.mp4");
 }
 
+/// @brief get unsigned integer setting from environment variable
+/// @param env_name Environment variable name
+/// @param default_value Value used when variable is not set
+/// @return Setting value
+static uint32_t get_env_uint(const char *env_name, const uint32_t &default_value)
+{
+  const auto env_value = std::getenv(env_name);
+  if (env_value == nullptr)
+    return default_value;
+
+  return static_cast<uint32_t>(std::stoul(env_value));
+}
+
 int main()
 {
-  ApiServer::bootServer("0.0.0.0", 8080);
+  ApiServer::ServerOption server_option;
+  server_option.m_ioThreadNum = get_env_uint("GCB_IO_THREAD_NUM", server_option.m_ioThreadNum);
+  server_option.m_computeThreadNum = get_env_uint("GCB_COMPUTE_THREAD_NUM", server_option.m_computeThreadNum);
+  server_option.m_maxQueuedPictureNum = get_env_uint("GCB_MAX_QUEUED_PICTURE_NUM", server_option.m_maxQueuedPictureNum);
+  server_option.m_analysisWorkerNum = get_env_uint("GCB_ANALYSIS_WORKER_NUM", 0U);
+  server_option.m_maxRunningJobNum = get_env_uint("GCB_MAX_RUNNING_JOB_NUM", server_option.m_maxRunningJobNum);
+  server_option.m_maxQueuedJobNum = get_env_uint("GCB_MAX_QUEUED_JOB_NUM", server_option.m_maxQueuedJobNum);
+  server_option.m_jobStatusSlotNum = get_env_uint("GCB_JOB_STATUS_SLOT_NUM", server_option.m_jobStatusSlotNum);
+  server_option.m_eventPushIntervalMilliseconds =
+      get_env_uint("GCB_EVENT_PUSH_INTERVAL_MS", server_option.m_eventPushIntervalMilliseconds);
+  if (const auto local_video_root = std::getenv("GCB_LOCAL_VIDEO_ROOT"); local_video_root != nullptr)
+    server_option.m_localVideoRoot = local_video_root;
+  server_option.m_resultCacheMegabytes = get_env_uint("GCB_RESULT_CACHE_MB", server_option.m_resultCacheMegabytes);
+
+  ApiServer::bootServer("0.0.0.0", 8080, server_option);
   // debug_video();
 
   return 0;
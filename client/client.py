@@ -131,7 +131,8 @@ def videoProcessor(meta, outputDir):
     #------------------------------------
 
     print(f'\nAnalyzing video file => {input_video_path} .....')
-    api_access_id, analyzerResult = gcb_client.request_analyze_video(input_video_path, request_json)
+    # the result video is rendered while the video is analyzed
+    api_access_id, analyzerResult, visualize_access_id = gcb_client.request_analyze_video(input_video_path, request_json, visualize=True)
     with open(tmp_json_path, 'w') as fp:
         json.dump(analyzerResult,fp,indent=4)   # Save analyzer result.
 
@@ -166,7 +167,7 @@ def videoProcessor(meta, outputDir):
     # Create result video
     #--------------------------------
     print(f'\nCreating result video ....')
-    video_binary = gcb_client.request_visualize_analyzation_result(api_access_id,os.path.basename(input_video_path))
+    video_binary = gcb_client.wait_visualization_result(visualize_access_id)
 
     if video_binary is None:
         print("error: request visualize_result")
@@ -1,8 +1,36 @@
+import hashlib
+import json
 import os
 import requests
-import time
 
-def request_analyze_video(video_path: str, request_json_file: str):
+
+def print_progression(access_id, process_progression):
+    os.system("clear")
+    print(f"process_id: {access_id}")
+    print(f"progress: {int(process_progression * 100)}%")
+    print("[" + "*" * int(process_progression * 50) + "]")
+
+
+def wait_job_events(access_id):
+    # progress is pushed by server (Server-Sent Events), returns data of "completed" or "failed" event
+    url = f"http://127.0.0.1:8080/job_events/{access_id}"
+    with requests.get(url=url, stream=True) as connect_status:
+        if not "text/event-stream" in connect_status.headers["Content-Type"]:
+            return connect_status.json()
+
+        event_name = None
+        for line in connect_status.iter_lines(decode_unicode=True):
+            if line.startswith("event: "):
+                event_name = line[len("event: "):]
+            elif line.startswith("data: "):
+                json_data = json.loads(line[len("data: "):])
+                if event_name != "progress":
+                    return json_data
+                print_progression(access_id, json_data["progression"])
+
+    return {"error": "event stream is closed"}
+
+def request_analyze_video(video_path: str, request_json_file: str, visualize: bool = False, overlap: bool = False):
     analyzed_video_file = None
     with open(video_path, 'rb') as fp:
         analyzed_video_file = fp.read()
@@ -13,45 +41,67 @@ def request_analyze_video(video_path: str, request_json_file: str):
 
     video_file = os.path.basename(video_path)
     url = f"http://127.0.0.1:8080/analyze_video/{video_file}"
+    params = {}
+    if visualize:
+        # visualization is rendered in the same pass (video is decoded once)
+        params["visualize"] = "true"
+    files = {"video": analyzed_video_file, "request_json": request_json_file}
+    if overlap:
+        # request_json is sent first, so the server starts analysis while the video is uploading
+        # (only for streamable containers: fragmented MP4, MPEG-TS)
+        params["overlap"] = "true"
+        files = {"request_json": request_json_file, "video": analyzed_video_file}
+    # digest of video lets the server answer cached or running analysis before the upload ends
     connect_status = requests.post(
-        url=url, files={"video": analyzed_video_file, "request_json": request_json_file})
+        url=url, params=params, files=files,
+        headers={"X-Video-SHA256": hashlib.sha256(analyzed_video_file).hexdigest()})
 
     print(connect_status)
     json_data = connect_status.json()
     result_access_id = json_data.get("access_id")
+    visualize_access_id = json_data.get("visualization_access_id")
 
     if result_access_id is None:
         print(json_data.get("error"))
-        return -1, None
+        return -1, None, None
 
     print('result_access_id=',result_access_id)
-    time.sleep(1.0)
 
-    while True:
-        url = f"http://127.0.0.1:8080/analyzation_result/{result_access_id}"
-        connect_status = requests.get(url=url)
+    result_access_id, json_data = wait_analyzation_result(result_access_id)
+    return result_access_id, json_data, visualize_access_id
 
-        json_data = connect_status.json()
 
-        error_msg = json_data.get("error")
-        if error_msg is not None:
-            print(error_msg)
-            return -1, None
+def request_analyze_local_video(video_path: str, request_json_file: str):
+    # video_path is read in place by server (relative to its GCB_LOCAL_VIDEO_ROOT)
+    url = "http://127.0.0.1:8080/analyze_local_video"
+    connect_status = requests.post(
+        url=url, json={"video_path": video_path, "request_json": request_json_file})
 
-        process_progression = json_data.get("progression")
-        if process_progression is None:
-            break
+    print(connect_status)
+    json_data = connect_status.json()
+    result_access_id = json_data.get("access_id")
 
-        os.system("clear")
-        print(f"process_id: {result_access_id}")
-        print(f"progress: {int(process_progression * 100)}%")
-        print("[" + "*" * int(process_progression * 50) + "]")
-        time.sleep(1.2)
+    if result_access_id is None:
+        print(json_data.get("error"))
+        return -1, None
 
-    os.system("clear")
-    print(f"process_id: {result_access_id}")
-    print(f"progress: {100}%")
-    print("[" + "*" * int(1.0 * 50) + "]")
+    print('result_access_id=',result_access_id)
+
+    return wait_analyzation_result(result_access_id)
+
+
+def wait_analyzation_result(result_access_id):
+    json_data = wait_job_events(result_access_id)
+    error_msg = json_data.get("error")
+    if error_msg is not None:
+        print(error_msg)
+        return -1, None
+
+    url = f"http://127.0.0.1:8080/analyzation_result/{result_access_id}"
+    connect_status = requests.get(url=url)
+    json_data = connect_status.json()
+
+    print_progression(result_access_id, 1.0)
 
     #with open(f"./temp/result{result_access_id}.json", 'w') as fp:
     #    print(json_data, file=fp)
@@ -72,37 +122,25 @@ def request_visualize_analyzation_result(request_access_id, video_path: str):
         return None
 
     print(f"process_id: {result_visualize_access_id}")
-    time.sleep(2.0)
 
-    video_binary = None
+    return wait_visualization_result(result_visualize_access_id)
 
-    while True:
-        url = f"http://127.0.0.1:8080/visualization_result/{result_visualize_access_id}"
-        connect_status = requests.get(url=url)
 
-        content_type = connect_status.headers["Content-Type"]
-        if not "application/json" in content_type:
-            video_binary = connect_status.content
-            break
-
-        json_data = connect_status.json()
-
-        error_msg = json_data.get("error")
-        if error_msg is not None:
-            print(error_msg)
-            return None
+def wait_visualization_result(result_visualize_access_id):
+    if not result_visualize_access_id:
+        print("visualization job is not queued")
+        return None
 
-        process_progression = json_data.get("progression")
+    json_data = wait_job_events(result_visualize_access_id)
+    error_msg = json_data.get("error")
+    if error_msg is not None:
+        print(error_msg)
+        return None
 
-        os.system("clear")
-        print(f"process_id: {result_visualize_access_id}")
-        print(f"progress: {int(process_progression * 100)}%")
-        print("[" + "*" * int(process_progression * 50) + "]")
-        time.sleep(1.2)
+    url = f"http://127.0.0.1:8080/visualization_result/{result_visualize_access_id}"
+    connect_status = requests.get(url=url)
+    video_binary = connect_status.content
 
-    os.system("clear")
-    print(f"process_id: {result_visualize_access_id}")
-    print(f"progress: {100}%")
-    print("[" + "*" * int(1.0 * 50) + "]")
+    print_progression(result_visualize_access_id, 1.0)
 
     return video_binary